@@ -1,8 +1,18 @@
+#include "arena.h"
 #include "game_const.h"
 #include "game_weapon.h"
+#include "hash.h"
+#include "jobs.h"
 #include "map.h"
+#include "match.h"
+#include "pool.h"
+#include "projectile.h"
+#include "replay.h"
+#include "rng.h"
+#include "runtime.h"
 #include "scene.h"
 #include "sdl_wrapper.h"
+#include "snapshot.h"
 #include "vector.h"
 
 #include <assert.h>
@@ -24,12 +34,35 @@ typedef struct state {
   size_t p1lives;
   size_t p2lives;
   bool story_mode;
+  jobs_t *jobs;
+  // Seeds every new scene, and picks story mode maps
+  rng_t *rng;
+  replay_t *replay;
+  // Reused by state_hash() to save the match into every tick
+  snapshot_t *hash_snapshot;
+  // Set by POOL_STATS: the most any scene had in use of its pools and
+  // projectiles, and the takes its pools missed, printed once at exit
+  bool print_stats;
+  size_t pool_high_water;
+  size_t pool_misses;
+  size_t projectile_high_water;
 } state_t;
 
 const double TIME_THRESHOLD = 1.0;
 const double TIME_MULT = 10.0;
 
 const size_t NUM_OF_KEYS = 10;
+// Block size of scene arenas; a freshly built map2 scene fits in one block
+const size_t SCENE_ARENA_SIZE = 1 << 16;
+// Room a saved match2 scene needs, so state_hash() never grows its snapshot
+const size_t HASH_SNAPSHOT_SIZE = 1 << 14;
+// Threads scene_tick() runs on unless TICK_THREADS says otherwise
+const size_t DEFAULT_TICK_THREADS = 1;
+
+// The keys each player's actions press, in match_action_t bit order
+const char MATCH_KEYS[2][4] = {{A_KEY, D_KEY, W_KEY, SPACE},
+                               {LEFT_ARROW, RIGHT_ARROW, UP_ARROW, PERIOD}};
+const size_t MATCH_ACTIONS = 4;
 
 const double ANGLE_ERROR = 0.1;
 const double ANGULAR_MULTIPLIER_BIG = 1.3;
@@ -42,9 +75,6 @@ const int STARTING_LIVES = 5;
 const double LIVES_WIDTH = 5.0;
 const double LIVES_HEIGHT = 5.0;
 
-/** Generates a random number between 0 and 1 */
-double rand_double(void) { return (double)rand() / RAND_MAX; }
-
 bool in_game(state_t *state) {
   game_state_t game_state = state->game_state;
   if (game_state == MAP1 || game_state == MAP2 || game_state == MAP3) {
@@ -54,11 +84,13 @@ bool in_game(state_t *state) {
   return false;
 }
 
-body_t *get_life(vector_t center, body_type_t type) {
-  list_t *shape = rect_init(LIVES_WIDTH, LIVES_HEIGHT);
+body_t *get_life(scene_t *scene, vector_t center, body_type_t type) {
+  arena_t *arena = scene_get_arena(scene);
+  list_t *shape = rect_init_arena(arena, LIVES_WIDTH, LIVES_HEIGHT);
   rgb_color_t color = type == P1_LIFE ? PLAYER_1_COLOR : PLAYER_2_COLOR;
-  body_t *life = body_init_with_info(shape, 1, color,
-                                     info_init(type, NO_SIDE, NO_WEAPON), free);
+  body_t *life =
+      body_init_arena(arena, shape, 1, color,
+                      info_init_arena(arena, type, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(life, center);
 
   return life;
@@ -79,17 +111,20 @@ void add_lives(state_t *state) {
     Max = (vector_t){MAX2.x, MAX2.y};
   }
   for (size_t i = 0; i < state->p1lives; i++) {
-    body_t *life = get_life((vector_t){(LIVES_SPACING + 1 / 2 * LIVES_WIDTH) +
-                                           (LIVES_SPACING + LIVES_WIDTH) * i,
-                                       Max.y - LIVES_SPACING},
-                            P1_LIFE);
+    body_t *life =
+        get_life(state->scene,
+                 (vector_t){(LIVES_SPACING + 1 / 2 * LIVES_WIDTH) +
+                                (LIVES_SPACING + LIVES_WIDTH) * i,
+                            Max.y - LIVES_SPACING},
+                 P1_LIFE);
     scene_add_body(state->scene, life);
     sprite_img_add(state->scene, life, state->game_state);
   }
 
   for (size_t i = 0; i < state->p2lives; i++) {
     body_t *life =
-        get_life((vector_t){Max.x - ((LIVES_SPACING + 1 / 2 * LIVES_WIDTH) +
+        get_life(state->scene,
+                 (vector_t){Max.x - ((LIVES_SPACING + 1 / 2 * LIVES_WIDTH) +
                                      (LIVES_SPACING + LIVES_WIDTH) * i),
                             Max.y - LIVES_SPACING},
                  P2_LIFE);
@@ -174,11 +209,42 @@ void apply_key_states(state_t *state, body_t *player1, body_t *player2) {
   }
 }
 
+/** Creates an empty scene that ticks on the game's job system */
+scene_t *new_scene(state_t *state) {
+  scene_t *scene = scene_init_with_arena(SCENE_ARENA_SIZE);
+  scene_set_jobs(scene, state->jobs);
+  scene_seed(scene, rng_next(state->rng));
+  return scene;
+}
+
+/** Adds the scene's pool and projectile usage to what is printed at exit */
+void record_pool_stats(state_t *state) {
+  pool_t *pool;
+  for (size_t i = 0; (pool = scene_get_pool(state->scene, i)) != NULL; i++) {
+    if (pool_high_water(pool) > state->pool_high_water) {
+      state->pool_high_water = pool_high_water(pool);
+    }
+    state->pool_misses += pool_misses(pool);
+  }
+  size_t projectile_high_water =
+      projectiles_high_water(scene_get_projectiles(state->scene));
+  if (projectile_high_water > state->projectile_high_water) {
+    state->projectile_high_water = projectile_high_water;
+  }
+}
+
+void free_scene(state_t *state) {
+  if (state->print_stats) {
+    record_pool_stats(state);
+  }
+  scene_free(state->scene);
+}
+
 void menu_handler(state_t *state, game_state_t new_game_state) {
   sdl_sound_effects(state, CLICK);
-  scene_free(state->scene);
+  free_scene(state);
   state->game_state = new_game_state;
-  state->scene = scene_init();
+  state->scene = new_scene(state);
   if (new_game_state == MAP2 || new_game_state == MAP3) {
     sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
   } else if (new_game_state == MAP1) {
@@ -192,6 +258,9 @@ void menu_handler(state_t *state, game_state_t new_game_state) {
 
 void key_event_handler(char key, key_event_type_t type, double held_time,
                        state_t *state) {
+  if (state->replay != NULL && replay_is_recording(state->replay)) {
+    replay_add_key(state->replay, key, type, held_time);
+  }
   if (state->game_state == MAP1 || state->game_state == MAP2 ||
       state->game_state == MAP3) {
     scene_t *scene = state->scene;
@@ -386,11 +455,11 @@ void wrap(scene_t *scene) {
 }
 
 void reset_map(state_t *state) {
-  scene_free(state->scene);
-  state->scene = scene_init();
+  free_scene(state);
+  state->scene = new_scene(state);
 
   if (state->story_mode) {
-    if (rand() % 2 == 0) {
+    if (rng_below(state->rng, 2) == 0) {
       state->game_state = MAP3;
     } else {
       state->game_state = MAP2;
@@ -428,9 +497,63 @@ bool respawn(state_t *state) {
 // ---------------------- INIT/RUNTIME
 // ---------------------------------------------------------------------
 
-state_t *state_init() {
+/**
+ * Starts playing the replay in REPLAY_PLAY, or recording to REPLAY_RECORD.
+ * Writes the seed the match should use to seed.
+ */
+replay_t *start_replay(uint64_t *seed) {
+  const char *play_path = getenv("REPLAY_PLAY");
+  if (play_path != NULL) {
+    replay_t *replay = replay_play(play_path);
+    if (replay != NULL) {
+      *seed = replay_get_seed(replay);
+      return replay;
+    }
+    fprintf(stderr, "replay: cannot play %s\n", play_path);
+  }
+
+  *seed = time(NULL);
+  const char *record_path = getenv("REPLAY_RECORD");
+  if (record_path == NULL) {
+    return NULL;
+  }
+  replay_t *replay = replay_record(record_path, *seed, RUNTIME_TICK_DT);
+  if (replay == NULL) {
+    fprintf(stderr, "replay: cannot record to %s\n", record_path);
+  }
+  return replay;
+}
+
+void stop_replay(state_t *state) {
+  replay_print_summary(state->replay);
+  replay_free(state->replay);
+  state->replay = NULL;
+  sdl_on_key(key_event_handler);
+}
+
+/**
+ * Hashes everything a tick can change, to check replays against: the bytes
+ * match_save() writes, so no field it restores can diverge unnoticed
+ */
+uint64_t state_hash(state_t *state) {
+  match_save(state, state->hash_snapshot);
+  return hash_bytes(HASH_INIT, snapshot_get_data(state->hash_snapshot),
+                    snapshot_size(state->hash_snapshot));
+}
+
+/** Creates a state at the intro menu whose random draws derive from seed */
+state_t *state_init_seeded(uint64_t seed, jobs_t *jobs) {
   state_t *state = malloc(sizeof(state_t));
-  state->scene = scene_init();
+  assert(state != NULL);
+  state->jobs = jobs;
+  state->rng = rng_init(seed, RNG_GAMEPLAY);
+  state->replay = NULL;
+  state->hash_snapshot = snapshot_init(HASH_SNAPSHOT_SIZE);
+  state->print_stats = false;
+  state->pool_high_water = 0;
+  state->pool_misses = 0;
+  state->projectile_high_water = 0;
+  state->scene = new_scene(state);
   state->key_states = calloc(NUM_OF_KEYS + 1, sizeof(bool));
   state->sound_effects = sdl_load_sounds();
   state->game_state = INTRO_MENU;
@@ -444,13 +567,22 @@ state_t *state_init() {
   return state;
 }
 
+state_t *state_init() {
+  size_t threads = runtime_env("TICK_THREADS", 0);
+  jobs_t *jobs = jobs_init(threads > 0 ? threads : DEFAULT_TICK_THREADS);
+  uint64_t seed;
+  replay_t *replay = start_replay(&seed);
+  state_t *state = state_init_seeded(seed, jobs);
+  state->replay = replay;
+  state->print_stats = getenv("POOL_STATS") != NULL;
+  return state;
+}
+
 list_t *state_get_sounds(state_t *state, size_t idx) {
   return list_get(state->sound_effects, idx);
 }
 
 state_t *emscripten_init(void) {
-  srand(time(NULL));
-
   state_t *state = state_init();
   create_map(state->scene, state->game_state);
 
@@ -463,7 +595,10 @@ state_t *emscripten_init(void) {
   }
 
   sdl_sprites_init(state->scene, state->game_state);
-  sdl_on_key(key_event_handler);
+  // Live key presses would change a replay's outcome, so ignore them
+  bool is_playing =
+      state->replay != NULL && !replay_is_recording(state->replay);
+  sdl_on_key(is_playing ? NULL : key_event_handler);
   sdl_music(state, MENU_MUS);
   return state;
 }
@@ -479,8 +614,37 @@ void apply_time(state_t *state, double dt, body_t *player1, body_t *player2) {
   }
 }
 
-void emscripten_main(state_t *state) {
+/** Returns the length of the next tick, feeding in replayed key events */
+double begin_tick(state_t *state) {
   double dt = time_since_last_tick();
+  if (state->replay == NULL) {
+    return dt;
+  }
+  if (!replay_is_recording(state->replay) &&
+      !replay_play_tick(state->replay, key_event_handler, state)) {
+    stop_replay(state);
+    return dt;
+  }
+  return replay_get_dt(state->replay);
+}
+
+void end_tick(state_t *state) {
+  if (state->replay == NULL) {
+    return;
+  }
+  uint64_t hash = state_hash(state);
+  if (replay_is_recording(state->replay)) {
+    if (!replay_end_tick(state->replay, state->game_state, hash)) {
+      fprintf(stderr, "replay: cannot write, recording stopped\n");
+      stop_replay(state);
+    }
+  } else {
+    replay_check_tick(state->replay, state->game_state, hash);
+  }
+}
+
+/** Advances the match by dt, without rendering or handling its end */
+void state_step(state_t *state, double dt) {
   body_t *player1 = fetch_object(state->scene, PLAYER1);
   body_t *player2 = fetch_object(state->scene, PLAYER2);
 
@@ -510,16 +674,9 @@ void emscripten_main(state_t *state) {
   // Powerups
   if (state->game_state == MAP1 || state->game_state == MAP2 ||
       state->game_state == MAP3) {
-    size_t powerups_on_screen = 0;
-    for (size_t i = 0; i < scene_bodies(state->scene); i++) {
-      body_type_t type = get_info(scene_get_body(state->scene, i))->type;
-      if (type == POWERUP_RICOCHET || type == POWERUP_SHOTGUN) {
-        powerups_on_screen++;
-        if (powerups_on_screen >= MAX_POWERUPS) {
-          break;
-        }
-      }
-    }
+    size_t powerups_on_screen =
+        scene_count_type(state->scene, POWERUP_RICOCHET) +
+        scene_count_type(state->scene, POWERUP_SHOTGUN);
     bool spawned = spawn_powerup(state->scene, state->time_since_drop,
                                  powerups_on_screen, state->game_state);
     if (spawned) {
@@ -532,8 +689,14 @@ void emscripten_main(state_t *state) {
     wrap(state->scene);
   }
 
-  // Tick and Reset
   scene_tick(state->scene, dt);
+}
+
+void emscripten_main(state_t *state) {
+  double dt = begin_tick(state);
+  state_step(state, dt);
+
+  // Reset
   if (((!respawn(state)) && state->time_since_respawn > TIME_THRESHOLD) ||
       !in_game(state)) {
     sdl_render_game(state->scene);
@@ -550,12 +713,154 @@ void emscripten_main(state_t *state) {
       menu_handler(state, GAME_WIN_P1);
     }
   }
+
+  end_tick(state);
 }
 
 void emscripten_free(state_t *state) {
-  scene_free(state->scene);
+  if (state->replay != NULL) {
+    stop_replay(state);
+  }
+  free_scene(state);
+  if (state->print_stats) {
+    printf("pools: high water %zu, misses %zu\n", state->pool_high_water,
+           state->pool_misses);
+    printf("projectiles: high water %zu\n", state->projectile_high_water);
+  }
+  rng_free(state->rng);
+  snapshot_free(state->hash_snapshot);
+  jobs_free(state->jobs);
   free(state);
 }
 
 // ---------------------- END INIT/RUNTIME
-// ---------------------------------------------------------------------
\ No newline at end of file
+// ---------------------------------------------------------------------
+// ---------------------- MATCHES
+// ---------------------------------------------------------------------
+
+state_t *match_init(game_state_t map, uint64_t seed) {
+  assert(map == MAP1 || map == MAP2 || map == MAP3);
+  state_t *state = state_init_seeded(seed, NULL);
+  state->game_state = map;
+  create_map(state->scene, map);
+  sdl_sprites_init(state->scene, map);
+  add_lives(state);
+  return state;
+}
+
+void match_free(state_t *state) {
+  free_scene(state);
+  rng_free(state->rng);
+  snapshot_free(state->hash_snapshot);
+  list_free(state->sound_effects);
+  free(state->key_states);
+  free(state);
+}
+
+void match_key(state_t *state, char key, bool pressed) {
+  key_event_handler(key, pressed ? KEY_PRESSED : KEY_RELEASED, 0.0, state);
+}
+
+void match_actions(state_t *state, size_t player, uint8_t previous,
+                   uint8_t actions) {
+  assert(player < 2);
+  for (size_t a = 0; a < MATCH_ACTIONS; a++) {
+    uint8_t bit = 1 << a;
+    if (actions & bit) {
+      match_key(state, MATCH_KEYS[player][a], true);
+    } else if (previous & bit) {
+      match_key(state, MATCH_KEYS[player][a], false);
+    }
+  }
+}
+
+void match_step(state_t *state, double dt) {
+  state_step(state, dt);
+  respawn(state);
+}
+
+bool match_is_over(state_t *state) {
+  return state->p1lives == 0 || state->p2lives == 0;
+}
+
+scene_t *match_get_scene(state_t *state) { return state->scene; }
+
+size_t match_get_lives(state_t *state, body_type_t player) {
+  assert(player == PLAYER1 || player == PLAYER2);
+  return player == PLAYER1 ? state->p1lives : state->p2lives;
+}
+
+uint64_t match_hash(state_t *state) { return state_hash(state); }
+
+void match_save(state_t *state, snapshot_t *snapshot) {
+  snapshot_begin_save(snapshot);
+  snapshot_write(snapshot, &state->game_state, sizeof(state->game_state));
+  snapshot_write(snapshot, &state->time_since_drop, sizeof(double));
+  snapshot_write(snapshot, &state->time_since_respawn, sizeof(double));
+  snapshot_write(snapshot, &state->time_since_p1_jump, sizeof(double));
+  snapshot_write(snapshot, &state->time_since_p2_jump, sizeof(double));
+  snapshot_write(snapshot, &state->p1lives, sizeof(size_t));
+  snapshot_write(snapshot, &state->p2lives, sizeof(size_t));
+  snapshot_write(snapshot, &state->story_mode, sizeof(bool));
+  snapshot_write(snapshot, state->key_states, (NUM_OF_KEYS + 1) * sizeof(bool));
+  uint64_t rng_state = rng_get_state(state->rng);
+  snapshot_write(snapshot, &rng_state, sizeof(rng_state));
+  scene_save(state->scene, snapshot);
+}
+
+bool match_restore(state_t *state, snapshot_t *snapshot) {
+  if (!snapshot_begin_restore(snapshot)) {
+    return false;
+  }
+  // Read into locals, so a snapshot that fails to load leaves state as it was
+  game_state_t game_state;
+  double timers[4];
+  size_t lives[2];
+  bool story_mode;
+  bool *key_states = malloc((NUM_OF_KEYS + 1) * sizeof(bool));
+  assert(key_states != NULL);
+  uint64_t rng_state;
+  snapshot_read(snapshot, &game_state, sizeof(game_state));
+  snapshot_read(snapshot, timers, sizeof(timers));
+  snapshot_read(snapshot, lives, sizeof(lives));
+  snapshot_read(snapshot, &story_mode, sizeof(story_mode));
+  snapshot_read(snapshot, key_states, (NUM_OF_KEYS + 1) * sizeof(bool));
+  snapshot_read(snapshot, &rng_state, sizeof(rng_state));
+  scene_t *scene = scene_load(snapshot, SCENE_ARENA_SIZE);
+  if (scene == NULL) {
+    free(key_states);
+    return false;
+  }
+
+  free_scene(state);
+  free(state->key_states);
+  state->scene = scene;
+  state->game_state = game_state;
+  state->time_since_drop = timers[0];
+  state->time_since_respawn = timers[1];
+  state->time_since_p1_jump = timers[2];
+  state->time_since_p2_jump = timers[3];
+  state->p1lives = lives[0];
+  state->p2lives = lives[1];
+  state->story_mode = story_mode;
+  state->key_states = key_states;
+  rng_set_state(state->rng, rng_state);
+  scene_set_jobs(state->scene, state->jobs);
+  if (in_game(state)) {
+    game_weapon_pools_init(state->scene);
+  }
+  // Sprites hold textures, so they are rebuilt instead of saved
+  sdl_sprites_init(state->scene, state->game_state);
+  for (size_t i = 0; i < scene_bodies(state->scene); i++) {
+    body_t *body = scene_get_body(state->scene, i);
+    body_type_t type = get_info(body)->type;
+    if (type == POWERUP_RICOCHET || type == POWERUP_SHOTGUN ||
+        type == P1_LIFE || type == P2_LIFE) {
+      sprite_img_add(state->scene, body, state->game_state);
+    }
+  }
+  return true;
+}
+
+// ---------------------- END MATCHES
+// ---------------------------------------------------------------------
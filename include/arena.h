@@ -0,0 +1,60 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+/**
+ * A bump allocator made of a chain of large blocks.
+ * Allocations are never freed individually; the whole arena is released at
+ * once. Memory can be given back with arena_release() to be handed out again
+ * for an allocation of the same size.
+ */
+typedef struct arena arena_t;
+
+/**
+ * Allocates an empty arena.
+ * No block is allocated until the first call to arena_alloc().
+ *
+ * @param block_size the size in bytes of each block the arena requests
+ * @return a pointer to the new arena
+ */
+arena_t *arena_init(size_t block_size);
+
+/**
+ * Releases all memory owned by an arena, including the arena itself.
+ * Every pointer previously returned by arena_alloc() becomes invalid.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ */
+void arena_free(arena_t *arena);
+
+/**
+ * Returns a block of memory aligned for any type.
+ * The memory is uninitialized and lives until the arena is freed.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param size the number of bytes to allocate
+ * @return a pointer to the allocated memory
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Gives back memory from arena_alloc() that is no longer used, e.g. a
+ * list's array after the list outgrew it. The next allocation of the same
+ * size reuses it instead of growing the arena.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @param memory a pointer returned from arena_alloc() on this arena
+ * @param size the size memory was allocated with
+ */
+void arena_release(arena_t *arena, void *memory, size_t size);
+
+/**
+ * Returns the number of bytes handed out and not given back.
+ *
+ * @param arena a pointer to an arena returned from arena_init()
+ * @return the number of bytes in use
+ */
+size_t arena_used(arena_t *arena);
+
+#endif // #ifndef __ARENA_H__
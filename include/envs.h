@@ -0,0 +1,103 @@
+#ifndef __ENVS_H__
+#define __ENVS_H__
+
+#include "match.h"
+#include "sdl_wrapper.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A batch of independent matches stepped together, for training bots.
+ * Every step applies one action per player in every match, advances all
+ * matches by one fixed tick across the batch's threads and writes a packed
+ * observation of each match. Matches that end are restarted with a fresh
+ * seed straight away, so the batch never needs to be reset by hand.
+ *
+ * Each match's observation is envs_observation_size() floats: for player 1
+ * and then player 2,
+ *   x, y, vx, vy, weapon, ammo (-1 when unlimited), lives,
+ * followed by the player's nearest projectiles, each as
+ *   dx, dy, vx, vy, present
+ * where dx and dy are relative to the player and present is 0 for unused
+ * slots. A player between respawns reads as all zeros.
+ *
+ * The game must be linked with sdl_headless.c.
+ */
+typedef struct envs envs_t;
+
+/** The inputs a player can hold down during a step, combined with | */
+typedef enum {
+  ENV_ACTION_LEFT = MATCH_ACTION_LEFT,
+  ENV_ACTION_RIGHT = MATCH_ACTION_RIGHT,
+  ENV_ACTION_JUMP = MATCH_ACTION_JUMP,
+  ENV_ACTION_SHOOT = MATCH_ACTION_SHOOT
+} env_action_t;
+
+/**
+ * Starts a batch of matches.
+ *
+ * @param count the number of matches
+ * @param map the map every match is played on: MAP1, MAP2 or MAP3
+ * @param seed the seed every match's seeds derive from
+ * @param threads the number of threads to step matches on
+ * @return a pointer to the new batch
+ */
+envs_t *envs_init(size_t count, game_state_t map, uint64_t seed,
+                  size_t threads);
+
+/**
+ * Ends every match and releases the batch.
+ *
+ * @param envs a pointer to a batch returned from envs_init()
+ */
+void envs_free(envs_t *envs);
+
+/**
+ * Returns the number of matches in a batch.
+ *
+ * @param envs a pointer to a batch returned from envs_init()
+ * @return the match count
+ */
+size_t envs_count(envs_t *envs);
+
+/**
+ * Returns one of a batch's matches, for reading its full state.
+ * Finished matches are replaced, so the pointer is only valid until the
+ * next call to envs_step().
+ *
+ * @param envs a pointer to a batch returned from envs_init()
+ * @param index the match's index, less than envs_count()
+ * @return the match's state
+ */
+state_t *envs_get_match(envs_t *envs, size_t index);
+
+/**
+ * Returns the number of floats in one match's observation.
+ *
+ * @return the observation size
+ */
+size_t envs_observation_size(void);
+
+/**
+ * Writes the current observation of every match.
+ *
+ * @param envs a pointer to a batch returned from envs_init()
+ * @param observations room for envs_count() * envs_observation_size() floats
+ */
+void envs_observe(envs_t *envs, float *observations);
+
+/**
+ * Advances every match by one tick.
+ *
+ * @param envs a pointer to a batch returned from envs_init()
+ * @param actions two env_action_t masks per match, player 1 first
+ * @param observations room for envs_count() * envs_observation_size()
+ *   floats, filled with the state after the step; may be NULL
+ * @param dones one flag per match, set when the match ended during this step
+ *   and was restarted; may be NULL
+ */
+void envs_step(envs_t *envs, const uint8_t *actions, float *observations,
+               bool *dones);
+
+#endif // #ifndef __ENVS_H__
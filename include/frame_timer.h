@@ -0,0 +1,75 @@
+#ifndef __FRAME_TIMER_H__
+#define __FRAME_TIMER_H__
+
+#include <stddef.h>
+
+/**
+ * Measures the wall time between frames with the monotonic clock, and keeps
+ * the last few frame times to summarize them. Unlike clock(), which counts
+ * the process's CPU time, this keeps counting while the process waits on
+ * vsync or is descheduled.
+ */
+typedef struct frame_timer frame_timer_t;
+
+/** A summary of the frame times in a timer's window, in seconds */
+typedef struct frame_stats {
+  // Frames summarized, at most the window's length
+  size_t frames;
+  double min;
+  double avg;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+} frame_stats_t;
+
+/**
+ * Starts a timer. Its first tick measures nothing.
+ *
+ * @param window how many of the latest frames to summarize
+ * @return a pointer to the new timer
+ */
+frame_timer_t *frame_timer_init(size_t window);
+
+/**
+ * Releases a timer.
+ *
+ * @param timer a pointer to a timer returned from frame_timer_init()
+ */
+void frame_timer_free(frame_timer_t *timer);
+
+/**
+ * Ends a frame and starts the next.
+ *
+ * @param timer a pointer to a timer returned from frame_timer_init()
+ * @return the seconds since the last tick, or 0 the first time
+ */
+double frame_timer_tick(frame_timer_t *timer);
+
+/**
+ * Adds a frame time measured some other way to a timer's window, as
+ * frame_timer_tick() does with the time since the last tick.
+ *
+ * @param timer a pointer to a timer returned from frame_timer_init()
+ * @param seconds how long the frame took
+ */
+void frame_timer_add(frame_timer_t *timer, double seconds);
+
+/**
+ * Summarizes the frames in a timer's window. Percentiles are the nearest
+ * frame time at or above that rank.
+ *
+ * @param timer a pointer to a timer returned from frame_timer_init()
+ * @return the summary, all zero before the second tick
+ */
+frame_stats_t frame_timer_stats(frame_timer_t *timer);
+
+/**
+ * Prints the summary of a timer's window to stdout, in milliseconds.
+ *
+ * @param timer a pointer to a timer returned from frame_timer_init()
+ * @param name what the frames are, to label the line with
+ */
+void frame_timer_print(frame_timer_t *timer, const char *name);
+
+#endif // #ifndef __FRAME_TIMER_H__
@@ -0,0 +1,22 @@
+#ifndef __HASH_H__
+#define __HASH_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** The value to start a new hash from */
+#define HASH_INIT 14695981039346656037ULL
+
+/**
+ * Folds bytes into a running 64-bit FNV-1a hash.
+ * Used to fingerprint simulation state, so two runs can be compared tick by
+ * tick; it is not meant to resist deliberate collisions.
+ *
+ * @param hash the hash so far, or HASH_INIT
+ * @param bytes the bytes to fold in
+ * @param size the number of bytes
+ * @return the updated hash
+ */
+uint64_t hash_bytes(uint64_t hash, const void *bytes, size_t size);
+
+#endif // #ifndef __HASH_H__
@@ -0,0 +1,60 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stddef.h>
+
+/**
+ * A fixed set of worker threads that split loops between them.
+ * Each thread owns a queue of chunks; a thread that runs out of work steals
+ * chunks from the front of another thread's queue. The calling thread always
+ * takes part, so a job system with one thread starts no workers at all and
+ * runs everything inline.
+ */
+typedef struct jobs jobs_t;
+
+/**
+ * A function that processes the items in [begin, end) of a loop.
+ * Different ranges of the same loop may run at the same time on different
+ * threads, so it must only write to memory owned by its own items.
+ */
+typedef void (*job_func_t)(void *aux, size_t begin, size_t end);
+
+/**
+ * Starts a job system.
+ *
+ * @param threads the number of threads to run loops on, including the
+ *   calling thread; must be at least 1
+ * @return a pointer to the new job system
+ */
+jobs_t *jobs_init(size_t threads);
+
+/**
+ * Stops the worker threads and releases the job system.
+ *
+ * @param jobs a pointer to a job system returned from jobs_init()
+ */
+void jobs_free(jobs_t *jobs);
+
+/**
+ * Returns the number of threads loops run on, including the calling thread.
+ *
+ * @param jobs a pointer to a job system returned from jobs_init()
+ * @return the thread count
+ */
+size_t jobs_threads(jobs_t *jobs);
+
+/**
+ * Runs func over [0, count) split into chunks of at least grain items, and
+ * returns once every chunk has finished.
+ * Runs inline when jobs is NULL, has one thread, or count is at most grain.
+ *
+ * @param jobs a pointer to a job system returned from jobs_init(), or NULL
+ * @param count the number of items in the loop
+ * @param grain the smallest number of items worth handing to another thread
+ * @param func the function to run on each chunk
+ * @param aux the first argument passed to func
+ */
+void jobs_parallel_for(jobs_t *jobs, size_t count, size_t grain,
+                       job_func_t func, void *aux);
+
+#endif // #ifndef __JOBS_H__
@@ -0,0 +1,133 @@
+#ifndef __MATCH_H__
+#define __MATCH_H__
+
+#include "scene.h"
+#include "sdl_wrapper.h"
+#include "snapshot.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A match driven directly by code instead of by a window's event loop.
+ * Matches start on a map with full lives, never show menus, play sounds
+ * through sdl_sound_effects() and share no state with each other, so
+ * separate matches can be stepped on separate threads as long as the game is
+ * linked with sdl_headless.c. sdl_init() must have been called once with
+ * the map's bounds before the first match starts.
+ */
+
+/** The inputs a player can hold down during a tick, combined with | */
+typedef enum {
+  MATCH_ACTION_LEFT = 1,
+  MATCH_ACTION_RIGHT = 2,
+  MATCH_ACTION_JUMP = 4,
+  MATCH_ACTION_SHOOT = 8
+} match_action_t;
+
+/**
+ * Starts a match.
+ *
+ * @param map MAP1, MAP2 or MAP3
+ * @param seed the seed every random draw in the match derives from
+ * @return the match's state
+ */
+state_t *match_init(game_state_t map, uint64_t seed);
+
+/**
+ * Releases a match started with match_init().
+ *
+ * @param state a match's state
+ */
+void match_free(state_t *state);
+
+/**
+ * Presses or releases a key, exactly as if it came from the keyboard.
+ *
+ * @param state a match's state
+ * @param key the key's code
+ * @param pressed true to press the key, false to release it
+ */
+void match_key(state_t *state, char key, bool pressed);
+
+/**
+ * Sets what a player holds down for the next tick. Held keys are pressed
+ * again every tick, like keyboard auto-repeat, and keys no longer held are
+ * released, so the same actions always have the same effect.
+ *
+ * @param state a match's state
+ * @param player 0 for player 1, 1 for player 2
+ * @param previous the match_action_t mask the player held last tick
+ * @param actions the match_action_t mask the player holds now
+ */
+void match_actions(state_t *state, size_t player, uint8_t previous,
+                   uint8_t actions);
+
+/**
+ * Advances a match by one tick, respawning players who died.
+ *
+ * @param state a match's state
+ * @param dt the length of the tick, in seconds
+ */
+void match_step(state_t *state, double dt);
+
+/**
+ * Returns whether either player has run out of lives.
+ *
+ * @param state a match's state
+ * @return true once the match has a winner
+ */
+bool match_is_over(state_t *state);
+
+/**
+ * Returns the scene a match is currently played in.
+ * Respawns replace the scene, so the pointer is only valid until the next
+ * call to match_step().
+ *
+ * @param state a match's state
+ * @return the current scene
+ */
+scene_t *match_get_scene(state_t *state);
+
+/**
+ * Returns how many lives a player has left.
+ *
+ * @param state a match's state
+ * @param player PLAYER1 or PLAYER2
+ * @return the player's remaining lives
+ */
+size_t match_get_lives(state_t *state, body_type_t player);
+
+/**
+ * Hashes everything a tick can change, to check that two copies of a match
+ * have stayed in step.
+ *
+ * @param state a match's state
+ * @return the hash of the match's current state
+ */
+uint64_t match_hash(state_t *state);
+
+/**
+ * Saves everything a match's future depends on: every body, force bind,
+ * projectile and random stream in its scene, the players' lives, the game's
+ * timers and which keys are held. Replaces whatever the snapshot held.
+ *
+ * @param state a match's state
+ * @param snapshot the snapshot to save into
+ */
+void match_save(state_t *state, snapshot_t *snapshot);
+
+/**
+ * Puts a match back in a state saved by match_save(). The match then plays
+ * on exactly as it did from the moment it was saved, given the same keys.
+ * The snapshot may come from another match of the same build, which makes
+ * this a way to branch one match into several.
+ *
+ * @param state a match's state
+ * @param snapshot a snapshot written by match_save()
+ * @return false, leaving the match untouched, if the snapshot is from an
+ *   incompatible build or was cut short
+ */
+bool match_restore(state_t *state, snapshot_t *snapshot);
+
+#endif // #ifndef __MATCH_H__
@@ -0,0 +1,65 @@
+#ifndef __POLYGON_BATCH_H__
+#define __POLYGON_BATCH_H__
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+/**
+ * Collects filled polygons, split into triangles, and draws them all with a
+ * single SDL_RenderGeometry() call. Each polygon keeps its own color, and
+ * polygons paint over the ones added before them. Polygons must be convex,
+ * which every body in the game is, since each is fanned out from its first
+ * vertex.
+ *
+ * Vertices are added one by one, so no polygon needs to be copied into an
+ * array first, and the batch's buffers are reused from frame to frame.
+ */
+typedef struct polygon_batch polygon_batch_t;
+
+/**
+ * Allocates an empty batch.
+ *
+ * @param renderer the renderer to draw with
+ * @return a pointer to the new batch
+ */
+polygon_batch_t *polygon_batch_init(SDL_Renderer *renderer);
+
+/**
+ * Releases a batch, dropping any polygons not yet drawn.
+ *
+ * @param batch a pointer to a batch returned from polygon_batch_init()
+ */
+void polygon_batch_free(polygon_batch_t *batch);
+
+/**
+ * Starts a new polygon. Its vertices follow with polygon_batch_add_vertex().
+ *
+ * @param batch a pointer to a batch returned from polygon_batch_init()
+ * @param color the polygon's color
+ */
+void polygon_batch_start(polygon_batch_t *batch, SDL_Color color);
+
+/**
+ * Adds the next vertex of the polygon last started, in order around it.
+ *
+ * @param batch a pointer to a batch returned from polygon_batch_init()
+ * @param point the vertex, in pixels
+ */
+void polygon_batch_add_vertex(polygon_batch_t *batch, SDL_FPoint point);
+
+/**
+ * Draws every polygon added since the last flush.
+ *
+ * @param batch a pointer to a batch returned from polygon_batch_init()
+ */
+void polygon_batch_flush(polygon_batch_t *batch);
+
+/**
+ * Returns how many draw calls a batch has made, and starts counting again.
+ *
+ * @param batch a pointer to a batch returned from polygon_batch_init()
+ * @return the number of draw calls since the last call
+ */
+size_t polygon_batch_take_draw_calls(polygon_batch_t *batch);
+
+#endif // #ifndef __POLYGON_BATCH_H__
@@ -0,0 +1,83 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include "arena.h"
+#include <stddef.h>
+
+/**
+ * A fixed-capacity stack of reusable objects.
+ * The pool never creates or destroys objects itself: callers fill it up
+ * front, take objects out when they need one and put them back when done.
+ * It also tracks how many objects are out at once so it can be sized from
+ * real workloads.
+ */
+typedef struct pool pool_t;
+
+/**
+ * Allocates an empty pool.
+ *
+ * @param arena the arena to carve the pool from, or NULL to use the heap
+ * @param capacity the maximum number of objects the pool can hold
+ * @return a pointer to the new pool
+ */
+pool_t *pool_init(arena_t *arena, size_t capacity);
+
+/**
+ * Releases a heap-allocated pool. Objects still in the pool are not freed.
+ * Pools carved from an arena are released with the arena instead.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ */
+void pool_free(pool_t *pool);
+
+/**
+ * Returns an object to the pool, or stocks it with a new one.
+ * Asserts that the pool is not already full.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @param object the object to store
+ */
+void pool_put(pool_t *pool, void *object);
+
+/**
+ * Takes an object out of the pool.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return an object previously put in the pool, or NULL if it is empty
+ */
+void *pool_take(pool_t *pool);
+
+/**
+ * Returns the number of objects the pool can hold.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return the pool's capacity
+ */
+size_t pool_capacity(pool_t *pool);
+
+/**
+ * Returns the number of objects currently taken out of the pool.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return the number of objects in use
+ */
+size_t pool_in_use(pool_t *pool);
+
+/**
+ * Returns the largest number of objects that were ever in use at once.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return the high-water mark of objects in use
+ */
+size_t pool_high_water(pool_t *pool);
+
+/**
+ * Returns how many times pool_take() found the pool empty.
+ * Any misses mean the pool was sized too small for the workload.
+ *
+ * @param pool a pointer to a pool returned from pool_init()
+ * @return the number of failed takes
+ */
+size_t pool_misses(pool_t *pool);
+
+#endif // #ifndef __POOL_H__
@@ -0,0 +1,143 @@
+#ifndef __PROJECTILE_H__
+#define __PROJECTILE_H__
+
+#include "body.h"
+#include "color.h"
+#include "player.h"
+#include "scene.h"
+#include "snapshot.h"
+#include "vector.h"
+#include <stddef.h>
+
+/**
+ * Every projectile in a scene, stored as one array per field.
+ * Projectiles are not bodies: they have no shape list, no force binds and
+ * never enter the scene's body list. Each tick they are integrated in bulk
+ * and swept against the scene's geometry, players, powerups and each other.
+ */
+typedef struct projectiles projectiles_t;
+
+/**
+ * Allocates an empty projectile buffer.
+ *
+ * @param initial_capacity the number of projectiles to make room for
+ * @return a pointer to the new buffer
+ */
+projectiles_t *projectiles_init(size_t initial_capacity);
+
+/**
+ * Releases the memory allocated for a projectile buffer.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ */
+void projectiles_free(projectiles_t *projectiles);
+
+/**
+ * Fires a new projectile.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param position the projectile's center
+ * @param velocity the projectile's velocity
+ * @param angle the projectile's rotation, which is only used for drawing
+ * @param height the projectile's width across its direction of travel
+ * @param color the projectile's color
+ * @param weapon the weapon that fired it, which decides how it collides
+ * @param owner a handle to the body that fired it
+ */
+void projectiles_add(projectiles_t *projectiles, vector_t position,
+                     vector_t velocity, double angle, double height,
+                     rgb_color_t color, game_weapon_type_t weapon,
+                     body_handle_t owner);
+
+/**
+ * Returns the number of live projectiles.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @return the number of projectiles
+ */
+size_t projectiles_size(projectiles_t *projectiles);
+
+/**
+ * Returns the largest number of projectiles that were ever live at once.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @return the high-water mark of live projectiles
+ */
+size_t projectiles_high_water(projectiles_t *projectiles);
+
+/**
+ * Returns the center of a projectile.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param index the index of the projectile
+ * @return the projectile's center
+ */
+vector_t projectiles_get_position(projectiles_t *projectiles, size_t index);
+
+/**
+ * Returns the velocity of a projectile.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param index the index of the projectile
+ * @return the projectile's velocity
+ */
+vector_t projectiles_get_velocity(projectiles_t *projectiles, size_t index);
+
+/**
+ * Returns the weapon that fired a projectile.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param index the index of the projectile
+ * @return the projectile's weapon type
+ */
+game_weapon_type_t projectiles_get_weapon(projectiles_t *projectiles,
+                                          size_t index);
+
+/**
+ * Returns the color of a projectile.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param index the index of the projectile
+ * @return the projectile's color
+ */
+rgb_color_t projectiles_get_color(projectiles_t *projectiles, size_t index);
+
+/**
+ * Writes the four corners of a projectile's rectangle, in the same order
+ * as rect_init().
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param index the index of the projectile
+ * @param corners an array of four vectors to fill
+ */
+void projectiles_get_corners(projectiles_t *projectiles, size_t index,
+                             vector_t corners[4]);
+
+/**
+ * Appends every projectile to a snapshot.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param snapshot the snapshot to save into
+ */
+void projectiles_save(projectiles_t *projectiles, snapshot_t *snapshot);
+
+/**
+ * Replaces every projectile with the next ones saved in a snapshot.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param snapshot a snapshot positioned where projectiles_save() wrote
+ */
+void projectiles_restore(projectiles_t *projectiles, snapshot_t *snapshot);
+
+/**
+ * Moves every projectile forward by dt and resolves its collisions.
+ * Bodies hit by projectiles are marked with body_remove(), so this must run
+ * before the scene's removal pass.
+ *
+ * @param projectiles a pointer to a buffer returned from projectiles_init()
+ * @param scene the scene whose bodies the projectiles collide with
+ * @param dt the time elapsed since the last tick, in seconds
+ */
+void projectiles_tick(projectiles_t *projectiles, scene_t *scene, double dt);
+
+#endif // #ifndef __PROJECTILE_H__
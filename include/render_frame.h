@@ -0,0 +1,101 @@
+#ifndef __RENDER_FRAME_H__
+#define __RENDER_FRAME_H__
+
+#include "polygon_batch.h"
+#include "sprite_batch.h"
+#include "texture_cache.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * A recording of what to draw: sprites and filled polygons, each on a layer.
+ * Layers are drawn from lowest to highest. Within a layer, polygons come
+ * first and sprites are grouped by texture, so a layer takes a draw call per
+ * texture however its sprites were recorded; things on the same layer and
+ * texture keep the order they were recorded in. Recording a frame makes no
+ * calls into SDL, so a frame can be recorded on one thread and drawn on the
+ * thread that owns the renderer. Its buffers are kept when it is cleared, so
+ * recording into the same frame over and over allocates nothing once it has
+ * grown.
+ */
+typedef struct render_frame render_frame_t;
+
+/**
+ * Allocates an empty frame.
+ *
+ * @return a pointer to the new frame
+ */
+render_frame_t *render_frame_init(void);
+
+/**
+ * Releases a frame.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ */
+void render_frame_free(render_frame_t *frame);
+
+/**
+ * Forgets everything recorded in a frame.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ */
+void render_frame_clear(render_frame_t *frame);
+
+/**
+ * Records a sprite. The region must stay borrowed until the frame has been
+ * drawn for the last time.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ * @param layer the layer to draw it on
+ * @param region the image to show
+ * @param dest where to show it, in pixels
+ * @param flip whether to mirror it horizontally
+ */
+void render_frame_add_sprite(render_frame_t *frame, uint8_t layer,
+                             const texture_region_t *region, SDL_Rect dest,
+                             bool flip);
+
+/**
+ * Starts recording a convex polygon. Its vertices follow with
+ * render_frame_add_vertex().
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ * @param layer the layer to draw it on
+ * @param color the polygon's color
+ */
+void render_frame_start_polygon(render_frame_t *frame, uint8_t layer,
+                                SDL_Color color);
+
+/**
+ * Records the next vertex of the polygon last started, in order around it.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ * @param point the vertex, in pixels
+ */
+void render_frame_add_vertex(render_frame_t *frame, SDL_FPoint point);
+
+/**
+ * Sorts a frame's commands into drawing order: by layer, then by texture,
+ * and otherwise in the order they were recorded. render_frame_draw() does
+ * this itself.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ * @return for each command in drawing order, its place in recording order;
+ *   valid until the frame is recorded into or drawn
+ */
+const size_t *render_frame_sort(render_frame_t *frame);
+
+/**
+ * Sorts a frame's commands into drawing order, then draws them through the
+ * given batches, flushing them when done. Sprites whose images have no
+ * texture yet are skipped.
+ *
+ * @param frame a pointer to a frame returned from render_frame_init()
+ * @param sprites the batch to draw sprites with
+ * @param polygons the batch to draw polygons with
+ */
+void render_frame_draw(render_frame_t *frame, sprite_batch_t *sprites,
+                       polygon_batch_t *polygons);
+
+#endif // #ifndef __RENDER_FRAME_H__
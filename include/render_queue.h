@@ -0,0 +1,117 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include "render_frame.h"
+#include "texture_cache.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * The drawing side of the game: owns the renderer, the textures and
+ * everything made with them, and draws the frames the game records.
+ *
+ * Frames are recorded into snapshots. A queue with a render thread keeps
+ * three: one being recorded, the newest one published and one being drawn.
+ * Publishing swaps the first two and never waits, so the game steps at its
+ * own pace while the render thread draws the newest frame whenever the
+ * display is ready for it; frames recorded in between are skipped. Without
+ * a render thread, publishing draws the frame on the spot.
+ */
+typedef struct render_queue render_queue_t;
+
+/** Where and on which thread a queue draws */
+typedef enum {
+  // In the window, on the thread that publishes
+  RENDER_INLINE,
+  // In the window, on a render thread, where SDL can create a renderer off
+  // the main thread
+  RENDER_THREADED,
+  // With the software renderer into a surface the window's size, on the
+  // thread that publishes, showing nothing; for machines without a display
+  RENDER_OFFSCREEN
+} render_mode_t;
+
+/** Everything needed to draw one frame, recorded without calling SDL */
+typedef struct render_snapshot {
+  // The bodies that never move, drawn into a cached layer the size of the
+  // window, and drawn again only when static_generation or the size changes.
+  // They outlive render_queue_begin(), holding what was last recorded into
+  // this snapshot for static_generation
+  render_frame_t *statics;
+  bool has_statics;
+  size_t static_generation;
+  // Drawn over the static layer, or over a white window without one
+  render_frame_t *frame;
+  // The window's size and the scene's boundary, in pixels
+  int width;
+  int height;
+  SDL_Rect boundary;
+  // texture_cache_generation() when the frame was recorded
+  size_t texture_generation;
+} render_snapshot_t;
+
+/**
+ * Creates the renderer for a window. RENDER_THREADED falls back to
+ * RENDER_INLINE if the render thread cannot start or cannot create its
+ * renderer.
+ *
+ * @param window the window to draw in, or whose size to draw at
+ * @param mode where and on which thread to draw
+ * @return a pointer to the new queue, or NULL if SDL cannot create a
+ *   renderer for the window at all
+ */
+render_queue_t *render_queue_init(SDL_Window *window, render_mode_t mode);
+
+/**
+ * Stops the render thread, then destroys every texture and the renderer.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ */
+void render_queue_free(render_queue_t *queue);
+
+/**
+ * Returns the textures sprites borrow their images from. Images can be
+ * borrowed and given back on the game's thread.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ * @return the queue's texture cache
+ */
+texture_cache_t *render_queue_get_textures(render_queue_t *queue);
+
+/**
+ * Returns a snapshot to record the next frame into, with an empty frame and
+ * has_statics unset. It belongs to the caller until render_queue_publish().
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ * @return the snapshot to record into
+ */
+render_snapshot_t *render_queue_begin(render_queue_t *queue);
+
+/**
+ * Hands the snapshot from render_queue_begin() over to be drawn.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ */
+void render_queue_publish(render_queue_t *queue);
+
+/**
+ * Returns how many draw calls the frames drawn so far took, and starts
+ * counting again. Only possible without a render thread.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ * @return the number of draw calls since the last call
+ */
+size_t render_queue_take_draw_calls(render_queue_t *queue);
+
+/**
+ * Writes the last frame drawn to a binary PPM image. Only possible without
+ * a render thread.
+ *
+ * @param queue a pointer to a queue returned from render_queue_init()
+ * @param path the file to write
+ * @return whether the image was written
+ */
+bool render_queue_write_ppm(render_queue_t *queue, const char *path);
+
+#endif // #ifndef __RENDER_QUEUE_H__
@@ -0,0 +1,130 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "sdl_wrapper.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A match recorded to, or played back from, a binary file.
+ * The file holds the match's seed and fixed tick length, then one record
+ * per tick: the key events handled before that tick, followed by the game
+ * state and state hash after it. Since every random draw comes from streams
+ * seeded from the recorded seed, feeding the same events into the same
+ * ticks reproduces the match exactly, and the hashes show the first tick
+ * where a playback stops matching.
+ */
+typedef struct replay replay_t;
+
+/**
+ * Starts recording a match.
+ *
+ * @param path the file to write
+ * @param seed the seed the match's random streams are derived from
+ * @param dt the fixed length of every tick, in seconds
+ * @return a pointer to the new recording, or NULL if path cannot be written
+ */
+replay_t *replay_record(const char *path, uint64_t seed, double dt);
+
+/**
+ * Opens a recorded match for playback.
+ *
+ * @param path the file to read
+ * @return a pointer to the playback, or NULL if path is not a replay
+ */
+replay_t *replay_play(const char *path);
+
+/**
+ * Closes a replay's file and releases its memory.
+ *
+ * @param replay a pointer to a replay returned from replay_record() or
+ *   replay_play()
+ */
+void replay_free(replay_t *replay);
+
+/**
+ * Returns whether a replay is being recorded rather than played back.
+ *
+ * @param replay a pointer to a replay
+ * @return true if the replay came from replay_record()
+ */
+bool replay_is_recording(replay_t *replay);
+
+/**
+ * Returns the seed a replay's match was started with.
+ *
+ * @param replay a pointer to a replay
+ * @return the match seed
+ */
+uint64_t replay_get_seed(replay_t *replay);
+
+/**
+ * Returns the fixed length of a replay's ticks.
+ *
+ * @param replay a pointer to a replay
+ * @return the tick length in seconds
+ */
+double replay_get_dt(replay_t *replay);
+
+/**
+ * Returns the number of ticks recorded or played back so far.
+ *
+ * @param replay a pointer to a replay
+ * @return the tick count
+ */
+size_t replay_get_ticks(replay_t *replay);
+
+/**
+ * Adds a key event to the tick being recorded.
+ *
+ * @param replay a pointer to a replay returned from replay_record()
+ * @param key the key that was pressed or released
+ * @param type whether the key was pressed or released
+ * @param held_time how long the key had been held, in seconds
+ */
+void replay_add_key(replay_t *replay, char key, key_event_type_t type,
+                    double held_time);
+
+/**
+ * Writes the tick being recorded, with the state it ended in.
+ *
+ * @param replay a pointer to a replay returned from replay_record()
+ * @param game_state the game state after the tick
+ * @param hash a hash of the simulation after the tick
+ * @return false if the file could not be written, leaving the recording
+ *   truncated somewhere in this tick
+ */
+bool replay_end_tick(replay_t *replay, game_state_t game_state, uint64_t hash);
+
+/**
+ * Reads the next recorded tick and passes its key events to handler.
+ *
+ * @param replay a pointer to a replay returned from replay_play()
+ * @param handler the function that handles key events during live play
+ * @param state the state passed to handler
+ * @return false once every recorded tick has been played
+ */
+bool replay_play_tick(replay_t *replay, key_handler_t handler,
+                      state_t *state);
+
+/**
+ * Compares the state after a played tick with the recorded one.
+ * The first mismatch is reported on stderr; later ones are only counted.
+ *
+ * @param replay a pointer to a replay returned from replay_play()
+ * @param game_state the game state after the tick
+ * @param hash a hash of the simulation after the tick
+ * @return true if the tick matches the recording
+ */
+bool replay_check_tick(replay_t *replay, game_state_t game_state,
+                       uint64_t hash);
+
+/**
+ * Prints how many ticks a replay covered and whether playback diverged.
+ *
+ * @param replay a pointer to a replay
+ */
+void replay_print_summary(replay_t *replay);
+
+#endif // #ifndef __REPLAY_H__
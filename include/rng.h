@@ -0,0 +1,87 @@
+#ifndef __RNG_H__
+#define __RNG_H__
+
+#include <stdint.h>
+
+/**
+ * A small seeded pseudo-random number generator (PCG32).
+ * Unlike rand(), every generator has its own state, so separate systems can
+ * draw numbers without shifting each other's sequences, and a whole match
+ * can be reproduced from its seed.
+ */
+typedef struct rng rng_t;
+
+/**
+ * The independent streams every scene keeps.
+ * Gameplay draws change the simulation and must be reproduced exactly by a
+ * replay; cosmetic draws only change how things look.
+ */
+typedef enum { RNG_GAMEPLAY, RNG_COSMETIC, RNG_STREAMS } rng_stream_t;
+
+/**
+ * Allocates a generator.
+ *
+ * @param seed the starting seed
+ * @param stream selects one of 2^63 sequences; generators with the same seed
+ *   but different streams produce unrelated numbers
+ * @return a pointer to the new generator
+ */
+rng_t *rng_init(uint64_t seed, uint64_t stream);
+
+/**
+ * Releases the memory allocated for a generator.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ */
+void rng_free(rng_t *rng);
+
+/**
+ * Restarts a generator's sequence from a seed, keeping its stream.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @param seed the new seed
+ */
+void rng_seed(rng_t *rng, uint64_t seed);
+
+/**
+ * Returns a generator's internal state, which rng_set_state() accepts.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @return the current state
+ */
+uint64_t rng_get_state(rng_t *rng);
+
+/**
+ * Restores a state returned from rng_get_state() on the same stream.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @param state the state to continue from
+ */
+void rng_set_state(rng_t *rng, uint64_t state);
+
+/**
+ * Returns the next number in a generator's sequence.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @return a uniformly distributed 32-bit number
+ */
+uint32_t rng_next(rng_t *rng);
+
+/**
+ * Returns a number in [0, bound), without the bias of rng_next() % bound.
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @param bound one more than the largest number returned; must be positive
+ * @return a uniformly distributed number below bound
+ */
+uint32_t rng_below(rng_t *rng, uint32_t bound);
+
+/**
+ * Returns a number in [0, 1).
+ *
+ * @param rng a pointer to a generator returned from rng_init()
+ * @return a uniformly distributed double
+ */
+double rng_double(rng_t *rng);
+
+#endif // #ifndef __RNG_H__
@@ -0,0 +1,156 @@
+#ifndef __ROLLBACK_H__
+#define __ROLLBACK_H__
+
+#include "match.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * One side of a two-player match played over a network with rollback.
+ *
+ * Each side simulates the whole match. Local inputs are scheduled a few
+ * ticks ahead (the input delay) and sent to the other side. While the
+ * remote input for a tick has not arrived it is predicted to repeat the
+ * last one that did. A snapshot of the match is kept for every recent tick,
+ * so when a remote input turns out to differ from its prediction the
+ * session restores the tick it was first used on and resimulates up to the
+ * present. The session refuses to run further ahead of the remote inputs
+ * than it has snapshots for, so a correction never needs more than
+ * max_rollback ticks of resimulation.
+ *
+ * Inputs are match_action_t masks. The session does no networking itself;
+ * see netplay.c for a UDP transport.
+ */
+typedef struct rollback rollback_t;
+
+/** Counters describing how much resimulation a session has done */
+typedef struct rollback_stats {
+  // Ticks advanced for the first time
+  size_t ticks;
+  // Times a misprediction sent the session back in time
+  size_t rollbacks;
+  // Ticks simulated again after rollbacks
+  size_t resimulated_ticks;
+  // Most ticks resimulated by a single rollback
+  size_t max_rollback_ticks;
+  // Time spent restoring and resimulating, in seconds
+  double resimulation_time;
+  // Longest single rollback, restore included, in seconds
+  double max_rollback_time;
+  // Times rollback_advance() refused to run further ahead
+  size_t stalls;
+} rollback_stats_t;
+
+/**
+ * Starts a session. Both sides must use the same map, seed and input
+ * delay.
+ *
+ * @param map MAP1, MAP2 or MAP3
+ * @param seed the seed every random draw in the match derives from
+ * @param local_player 0 if this side plays player 1, 1 for player 2
+ * @param input_delay how many ticks after they are given local inputs apply
+ * @param max_rollback the most ticks a correction may resimulate
+ * @return a pointer to the new session
+ */
+rollback_t *rollback_init(game_state_t map, uint64_t seed, size_t local_player,
+                          size_t input_delay, size_t max_rollback);
+
+/**
+ * Ends a session and its match.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ */
+void rollback_free(rollback_t *rollback);
+
+/**
+ * Returns the tick the session will simulate next.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @return the number of ticks advanced so far
+ */
+size_t rollback_get_tick(rollback_t *rollback);
+
+/**
+ * Returns the first tick whose remote input has not arrived yet. After the
+ * next rollback_sync(), every tick before it has been simulated with the
+ * other side's real inputs.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @return the first unconfirmed tick
+ */
+size_t rollback_get_confirmed_tick(rollback_t *rollback);
+
+/**
+ * Sets the local player's input for the tick input_delay ticks after the
+ * next one to be simulated, and returns that tick so the input can be sent
+ * to the other side. Inputs already sent cannot change, so if the session
+ * has not advanced since the last call the new input is ignored.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @param actions the match_action_t mask the local player holds
+ * @return the tick the input applies to
+ */
+size_t rollback_add_local_input(rollback_t *rollback, uint8_t actions);
+
+/**
+ * Records the other side's input for a tick. Inputs may arrive late, out of
+ * order or more than once. A late input that differs from its prediction
+ * makes the next rollback_advance() resimulate from that tick.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @param tick the tick the input applies to
+ * @param actions the remote player's match_action_t mask
+ */
+void rollback_add_remote_input(rollback_t *rollback, size_t tick,
+                               uint8_t actions);
+
+/**
+ * Restores and resimulates from the earliest tick whose remote input was
+ * mispredicted, if there is one, bringing the match up to date with every
+ * input received.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @param dt the length of a tick, in seconds; must be the same on both
+ *   sides
+ */
+void rollback_sync(rollback_t *rollback, double dt);
+
+/**
+ * Calls rollback_sync(), then advances the match by one tick.
+ * Does nothing if that would take the session max_rollback ticks past the
+ * last remote input, since a later correction could not be resimulated.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @param dt the length of a tick, in seconds; must be the same on both
+ *   sides
+ * @return whether the match advanced
+ */
+bool rollback_advance(rollback_t *rollback, double dt);
+
+/**
+ * Returns the match as currently simulated, for rendering. The state may
+ * still be corrected by later rollbacks.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @return the match's state
+ */
+state_t *rollback_get_state(rollback_t *rollback);
+
+/**
+ * Returns how much work rollbacks have cost so far.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ * @return the session's counters
+ */
+rollback_stats_t rollback_get_stats(rollback_t *rollback);
+
+/**
+ * Prints a session's counters, including the average cost of resimulating
+ * one tick, to stdout.
+ *
+ * @param rollback a pointer to a session returned from rollback_init()
+ */
+void rollback_print_stats(rollback_t *rollback);
+
+#endif // #ifndef __ROLLBACK_H__
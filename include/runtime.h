@@ -0,0 +1,42 @@
+#ifndef __RUNTIME_H__
+#define __RUNTIME_H__
+
+#include <stddef.h>
+
+/**
+ * What the programs that run matches outside the browser share: the length
+ * of a tick, a clock to time and pace them with, and reading their settings
+ * from environment variables.
+ */
+
+/** Seconds of game time in one tick; matches step at 60 Hz */
+extern const double RUNTIME_TICK_DT;
+
+/**
+ * Returns the time on a clock that never goes backwards, for measuring
+ * intervals. Its zero is arbitrary.
+ *
+ * @return the time in seconds
+ */
+double runtime_now(void);
+
+/**
+ * Reads a count from an environment variable.
+ *
+ * @param name the variable's name
+ * @param fallback the value to use if the variable is not set
+ * @return the variable's value, parsed as a decimal number, or fallback
+ */
+size_t runtime_env(const char *name, size_t fallback);
+
+/**
+ * Reads a number that may have a fractional part from an environment
+ * variable.
+ *
+ * @param name the variable's name
+ * @param fallback the value to use if the variable is not set
+ * @return the variable's value, or fallback
+ */
+double runtime_env_double(const char *name, double fallback);
+
+#endif // #ifndef __RUNTIME_H__
@@ -0,0 +1,41 @@
+#ifndef __SDL_STATS_H__
+#define __SDL_STATS_H__
+
+#include "frame_timer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * What sdl_wrapper.c can report about the frames it shows, for benchmarks
+ * and for debugging slow frames. sdl_headless.c shows nothing and provides
+ * none of these.
+ */
+
+/**
+ * Summarizes the times between the latest ticks measured by
+ * time_since_last_tick(), before they are limited to what one tick may
+ * simulate.
+ *
+ * @return the summary, with no frames before the second tick
+ */
+frame_stats_t sdl_frame_stats(void);
+
+/**
+ * Returns how many draw calls the frames shown so far took, and starts
+ * counting again. Only possible without a render thread, e.g. with SDL's
+ * dummy video driver.
+ *
+ * @return the number of draw calls since the last call
+ */
+size_t sdl_take_draw_calls(void);
+
+/**
+ * Writes the last frame shown to a binary PPM image. Only possible without
+ * a render thread.
+ *
+ * @param path the file to write
+ * @return whether the image was written
+ */
+bool sdl_write_frame(const char *path);
+
+#endif // #ifndef __SDL_STATS_H__
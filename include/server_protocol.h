@@ -0,0 +1,85 @@
+#ifndef __SERVER_PROTOCOL_H__
+#define __SERVER_PROTOCOL_H__
+
+#include <stdint.h>
+
+/**
+ * Datagrams exchanged between the match server (server.c) and its clients.
+ * Every field is fixed width and laid out without padding, and both sides
+ * run on the same machine, so messages are sent as raw structs.
+ *
+ * A client sends SERVER_JOIN until it receives SERVER_WELCOME with its
+ * match and player, then sends SERVER_INPUT every tick with the
+ * match_action_t mask it holds. Lost inputs are simply replaced by the next
+ * one. The server sends SERVER_STATE to both players of a match at the
+ * broadcast rate: a server_state_t followed by body_count server_body_t
+ * and projectile_count server_projectile_t. A state too large for one
+ * datagram is split across several of the same tick, each carrying the
+ * bodies and projectiles from first_body and first_projectile on.
+ */
+
+#define SERVER_MAGIC 0x56525342
+// Largest datagram the server sends, to stay under a typical MTU
+#define SERVER_MAX_PACKET 1400
+
+typedef enum {
+  SERVER_JOIN,
+  SERVER_WELCOME,
+  SERVER_INPUT,
+  SERVER_STATE,
+  // Sent by the server when every player slot is taken
+  SERVER_FULL
+} server_message_type_t;
+
+/** SERVER_JOIN, SERVER_WELCOME, SERVER_INPUT and SERVER_FULL messages */
+typedef struct server_message {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t player;
+  uint16_t match;
+  uint32_t tick;
+  uint8_t actions;
+  uint8_t padding[3];
+} server_message_t;
+
+/** The start of a SERVER_STATE message */
+typedef struct server_state {
+  uint32_t magic;
+  uint8_t type;
+  uint8_t player;
+  uint16_t match;
+  uint32_t tick;
+  uint8_t lives[2];
+  // How many the match has in all
+  uint16_t body_total;
+  uint16_t projectile_total;
+  // Which of them follow in this datagram
+  uint16_t first_body;
+  uint16_t body_count;
+  uint16_t first_projectile;
+  uint16_t projectile_count;
+  uint16_t padding;
+} server_state_t;
+
+/**
+ * A body's motion. Shapes never change during a match, so clients build
+ * them once from the map and the body type and only move them.
+ */
+typedef struct server_body {
+  float x;
+  float y;
+  float vx;
+  float vy;
+  float angle;
+  uint8_t type;
+  uint8_t padding[3];
+} server_body_t;
+
+typedef struct server_projectile {
+  float x;
+  float y;
+  float vx;
+  float vy;
+} server_projectile_t;
+
+#endif // #ifndef __SERVER_PROTOCOL_H__
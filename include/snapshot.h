@@ -0,0 +1,124 @@
+#ifndef __SNAPSHOT_H__
+#define __SNAPSHOT_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * A byte buffer that simulation state is saved into and restored from.
+ * Saved data holds no pointers: bodies are referred to by their position in
+ * the scene's body list or by handle, and functions by type tags, so a
+ * snapshot stays valid after the scene it came from is freed and can be
+ * written to disk. Snapshots start with a format version and are only
+ * readable by the same build of the game.
+ *
+ * A snapshot keeps its memory between uses, so saving into the same
+ * snapshot every tick does not allocate once it has grown large enough.
+ */
+typedef struct snapshot snapshot_t;
+
+/**
+ * Allocates an empty snapshot.
+ *
+ * @param initial_capacity the number of bytes to make room for
+ * @return a pointer to the new snapshot
+ */
+snapshot_t *snapshot_init(size_t initial_capacity);
+
+/**
+ * Releases the memory allocated for a snapshot.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ */
+void snapshot_free(snapshot_t *snapshot);
+
+/**
+ * Empties a snapshot and writes the format header, ready to save into.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ */
+void snapshot_begin_save(snapshot_t *snapshot);
+
+/**
+ * Moves back to the start of a snapshot and checks its format header,
+ * ready to restore from.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @return false if the snapshot was saved by a different format version or
+ *   is shorter than when it was saved
+ */
+bool snapshot_begin_restore(snapshot_t *snapshot);
+
+/**
+ * Appends bytes to a snapshot.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @param data the bytes to append
+ * @param size the number of bytes
+ */
+void snapshot_write(snapshot_t *snapshot, const void *data, size_t size);
+
+/**
+ * Reads the next bytes of a snapshot. Reading past the end zeroes data and
+ * fails the snapshot, as does any read once it has failed.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @param data where to copy the bytes
+ * @param size the number of bytes
+ */
+void snapshot_read(snapshot_t *snapshot, void *data, size_t size);
+
+/**
+ * Reads the number of items saved after it. A count too large for the rest
+ * of the snapshot to hold fails the snapshot, so corrupt counts are never
+ * allocated for.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @param item_size the fewest bytes each item is saved in, at least 1
+ * @return the count, or 0 if the snapshot has failed
+ */
+size_t snapshot_read_count(snapshot_t *snapshot, size_t item_size);
+
+/**
+ * Fails a snapshot whose bytes do not make sense to the code reading them.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ */
+void snapshot_fail(snapshot_t *snapshot);
+
+/**
+ * Returns whether a snapshot has failed since the last save or restore
+ * began: read past its end, held an impossible count, or was failed by
+ * snapshot_fail().
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @return true if what was read from the snapshot cannot be used
+ */
+bool snapshot_has_failed(snapshot_t *snapshot);
+
+/**
+ * Returns the saved bytes, for writing a snapshot to disk.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @return the snapshot's bytes
+ */
+const void *snapshot_get_data(snapshot_t *snapshot);
+
+/**
+ * Returns the number of saved bytes.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @return the snapshot's size in bytes
+ */
+size_t snapshot_size(snapshot_t *snapshot);
+
+/**
+ * Replaces a snapshot's contents with bytes read back from disk.
+ *
+ * @param snapshot a pointer to a snapshot returned from snapshot_init()
+ * @param data bytes previously returned from snapshot_get_data()
+ * @param size the number of bytes
+ */
+void snapshot_set_data(snapshot_t *snapshot, const void *data, size_t size);
+
+#endif // #ifndef __SNAPSHOT_H__
@@ -0,0 +1,222 @@
+#ifndef __SPECTATE_H__
+#define __SPECTATE_H__
+
+#include "color.h"
+#include "list.h"
+#include "match.h"
+#include "player.h"
+#include "vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A compact stream of a match for spectators, who rebuild what to draw from
+ * it without simulating anything.
+ *
+ * The encoder turns one tick of a match into one frame. A keyframe holds
+ * every body, with its type, color and shape, and every projectile. Other
+ * frames only hold what changed since the frame before: bodies that were
+ * removed or spawned, and how far each remaining body's motion strayed from
+ * carrying on at the speed it had. Positions and angles are quantized and
+ * packed into variable-length bit codes, so bodies that keep still or move
+ * steadily cost about a bit each per frame. Keyframes are sent every few
+ * seconds, whenever a respawn rebuilds the scene and on request, so a
+ * spectator can join partway through a match.
+ *
+ * Frames must reach the decoder in order and without gaps, as they would
+ * over a file, a pipe or a TCP connection.
+ */
+typedef struct spectate_encoder spectate_encoder_t;
+
+typedef struct spectate_decoder spectate_decoder_t;
+
+/** How much an encoder has written */
+typedef struct spectate_stats {
+  size_t frames;
+  size_t keyframes;
+  size_t bytes;
+  size_t keyframe_bytes;
+} spectate_stats_t;
+
+/**
+ * The bytes a stream file starts with. Then come one byte for the map and
+ * every frame, preceded by its size as a 16-bit little-endian number.
+ */
+extern const char SPECTATE_STREAM_MAGIC[4];
+
+/**
+ * Allocates an encoder for one match.
+ *
+ * @param keyframe_interval the most frames between two keyframes
+ * @return a pointer to the new encoder
+ */
+spectate_encoder_t *spectate_encoder_init(size_t keyframe_interval);
+
+/**
+ * Releases the memory allocated for an encoder.
+ *
+ * @param encoder a pointer to an encoder returned from spectate_encoder_init()
+ */
+void spectate_encoder_free(spectate_encoder_t *encoder);
+
+/**
+ * Makes the next frame a keyframe, e.g. because a spectator joined.
+ *
+ * @param encoder a pointer to an encoder returned from spectate_encoder_init()
+ */
+void spectate_encoder_request_keyframe(spectate_encoder_t *encoder);
+
+/**
+ * Encodes a match as it is after a tick. The frame stays valid until the
+ * next call.
+ *
+ * @param encoder a pointer to an encoder returned from spectate_encoder_init()
+ * @param state a match's state
+ * @param tick the number of the tick just played
+ * @param size where to write the frame's size in bytes
+ * @return the frame
+ */
+const uint8_t *spectate_encode(spectate_encoder_t *encoder, state_t *state,
+                               uint32_t tick, size_t *size);
+
+/**
+ * Returns how much an encoder has written so far.
+ *
+ * @param encoder a pointer to an encoder returned from spectate_encoder_init()
+ * @return the encoder's totals
+ */
+spectate_stats_t spectate_encoder_get_stats(spectate_encoder_t *encoder);
+
+/**
+ * Allocates a decoder, which waits for a keyframe before it shows anything.
+ *
+ * @return a pointer to the new decoder
+ */
+spectate_decoder_t *spectate_decoder_init(void);
+
+/**
+ * Releases the memory allocated for a decoder.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ */
+void spectate_decoder_free(spectate_decoder_t *decoder);
+
+/**
+ * Applies the next frame of a stream.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param frame a frame written by spectate_encode()
+ * @param size the frame's size in bytes
+ * @return false if the frame was malformed, or was not a keyframe and no
+ *   keyframe has been seen yet; the decoder then waits for the next one
+ */
+bool spectate_decode(spectate_decoder_t *decoder, const uint8_t *frame,
+                     size_t size);
+
+/**
+ * Returns whether a decoder has a match to show.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @return true once a keyframe has been decoded
+ */
+bool spectate_is_ready(spectate_decoder_t *decoder);
+
+/**
+ * Returns the tick the last decoded frame was encoded after.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @return the tick's number
+ */
+uint32_t spectate_get_tick(spectate_decoder_t *decoder);
+
+/**
+ * Returns how many lives a player has left.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param player PLAYER1 or PLAYER2
+ * @return the player's remaining lives
+ */
+size_t spectate_get_lives(spectate_decoder_t *decoder, body_type_t player);
+
+/**
+ * Returns the number of bodies in the match.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @return the number of bodies
+ */
+size_t spectate_bodies(spectate_decoder_t *decoder);
+
+/**
+ * Returns a body's type.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the body, less than spectate_bodies()
+ * @return the body's type
+ */
+body_type_t spectate_get_type(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Returns a body's color.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the body, less than spectate_bodies()
+ * @return the body's color
+ */
+rgb_color_t spectate_get_color(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Returns a body's centroid.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the body, less than spectate_bodies()
+ * @return the body's centroid
+ */
+vector_t spectate_get_centroid(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Returns a body's angle.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the body, less than spectate_bodies()
+ * @return the body's angle, in radians
+ */
+double spectate_get_angle(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Gets the current shape of a body, like body_get_shape().
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the body, less than spectate_bodies()
+ * @return a newly allocated vector list of the body's vertices
+ */
+list_t *spectate_get_shape(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Returns the number of projectiles in the match.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @return the number of projectiles
+ */
+size_t spectate_projectiles(spectate_decoder_t *decoder);
+
+/**
+ * Returns the center of a projectile.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the projectile
+ * @return the projectile's center
+ */
+vector_t spectate_get_projectile(spectate_decoder_t *decoder, size_t index);
+
+/**
+ * Returns the weapon that fired a projectile.
+ *
+ * @param decoder a pointer to a decoder returned from spectate_decoder_init()
+ * @param index the index of the projectile
+ * @return the projectile's weapon
+ */
+game_weapon_type_t spectate_get_projectile_weapon(spectate_decoder_t *decoder,
+                                                  size_t index);
+
+#endif // #ifndef __SPECTATE_H__
@@ -0,0 +1,59 @@
+#ifndef __SPRITE_BATCH_H__
+#define __SPRITE_BATCH_H__
+
+#include "texture_cache.h"
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Collects textured quads and draws all the consecutive ones sharing a
+ * texture with a single SDL_RenderGeometry() call. With sprites drawn from a
+ * texture atlas, a frame then takes one draw call per atlas texture rather
+ * than one per sprite. Quads keep the order they were added in, so sprites
+ * still paint over the ones added before them.
+ */
+typedef struct sprite_batch sprite_batch_t;
+
+/**
+ * Allocates an empty batch.
+ *
+ * @param renderer the renderer to draw with
+ * @return a pointer to the new batch
+ */
+sprite_batch_t *sprite_batch_init(SDL_Renderer *renderer);
+
+/**
+ * Releases a batch, dropping any quads not yet drawn.
+ *
+ * @param batch a pointer to a batch returned from sprite_batch_init()
+ */
+void sprite_batch_free(sprite_batch_t *batch);
+
+/**
+ * Adds a quad showing a region. Quads on another texture are drawn first.
+ *
+ * @param batch a pointer to a batch returned from sprite_batch_init()
+ * @param region the region to show
+ * @param dest where to show it, in pixels
+ * @param flip whether to mirror it horizontally
+ */
+void sprite_batch_add(sprite_batch_t *batch, const texture_region_t *region,
+                      const SDL_Rect *dest, bool flip);
+
+/**
+ * Draws every quad added since the last flush.
+ *
+ * @param batch a pointer to a batch returned from sprite_batch_init()
+ */
+void sprite_batch_flush(sprite_batch_t *batch);
+
+/**
+ * Returns how many draw calls a batch has made, and starts counting again.
+ *
+ * @param batch a pointer to a batch returned from sprite_batch_init()
+ * @return the number of draw calls since the last call
+ */
+size_t sprite_batch_take_draw_calls(sprite_batch_t *batch);
+
+#endif // #ifndef __SPRITE_BATCH_H__
@@ -0,0 +1,137 @@
+#ifndef __TEXTURE_CACHE_H__
+#define __TEXTURE_CACHE_H__
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+/**
+ * The textures made from image assets for one renderer, keyed by the
+ * asset's path. Each asset is decoded once; sprites then borrow its texture
+ * and give it back when they are freed. A texture nobody borrows stays
+ * loaded until texture_cache_trim(), so rebuilding a scene, as every
+ * respawn does, reuses the textures the old scene just gave back without
+ * touching the disk.
+ *
+ * Images can also be packed into a few large atlas textures up front with
+ * texture_cache_build_atlas(), so that sprites drawn from them share a
+ * texture and can be drawn together.
+ *
+ * Loading and trimming make no calls into the renderer, so they can happen
+ * on another thread than drawing. Textures are only made by
+ * texture_cache_upload() and destroyed by texture_cache_collect(), both on
+ * the thread that owns the renderer.
+ */
+typedef struct texture_cache texture_cache_t;
+
+/** The part of a texture that holds one image */
+typedef struct texture_region {
+  // NULL until the image is uploaded
+  SDL_Texture *texture;
+  // Shared by the regions of one texture and never 0, so frames can be
+  // sorted by texture before it is uploaded
+  size_t texture_id;
+  SDL_Rect source;
+  // The whole texture's size, to turn source into texture coordinates
+  int texture_width;
+  int texture_height;
+} texture_region_t;
+
+/**
+ * Allocates an empty cache.
+ *
+ * @return a pointer to the new cache
+ */
+texture_cache_t *texture_cache_init(void);
+
+/**
+ * Destroys every texture in a cache and releases the cache. Regions still
+ * borrowed must not be drawn afterwards. Must be called on the thread that
+ * owns the renderer, before the renderer is destroyed.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ */
+void texture_cache_free(texture_cache_t *cache);
+
+/**
+ * Loads images and packs them into as few textures as fit them, using a
+ * shelf packer. Images already in the cache, images that cannot be loaded
+ * and images too large for a page are left to be loaded on their own.
+ * Atlas images are never trimmed.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @param paths the images' paths
+ * @param count the number of paths
+ * @param page_size the width and height of each atlas texture
+ * @return the number of atlas textures made
+ */
+size_t texture_cache_build_atlas(texture_cache_t *cache,
+                                 const char *const *paths, size_t count,
+                                 int page_size);
+
+/**
+ * Borrows the region holding an image, loading the image the first time.
+ * White pixels are transparent.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @param path the image's path
+ * @return the image's region, which stays valid until it is given back, or
+ *   NULL if the image cannot be loaded, in which case nothing needs to be
+ *   given back
+ */
+const texture_region_t *texture_cache_acquire(texture_cache_t *cache,
+                                              const char *path);
+
+/**
+ * Gives back a region borrowed with texture_cache_acquire().
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @param region the region, or NULL to do nothing
+ */
+void texture_cache_release(texture_cache_t *cache,
+                           const texture_region_t *region);
+
+/**
+ * Makes textures for the images loaded since the last upload.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @param renderer the renderer to make them with
+ */
+void texture_cache_upload(texture_cache_t *cache, SDL_Renderer *renderer);
+
+/**
+ * Lets go of the images nobody borrows, e.g. after leaving a map. Their
+ * textures may still be in frames waiting to be drawn, so they are only
+ * destroyed by texture_cache_collect().
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @return the number of images let go
+ */
+size_t texture_cache_trim(texture_cache_t *cache);
+
+/**
+ * Returns how many times a cache has let go of images, which orders frames
+ * against the trims before and after them.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @return the number of trims that let go of anything
+ */
+size_t texture_cache_generation(texture_cache_t *cache);
+
+/**
+ * Destroys the textures let go of while generation was being reached. No
+ * frame recorded at that generation or later can show them.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @param generation the generation of the oldest frame still to be drawn
+ */
+void texture_cache_collect(texture_cache_t *cache, size_t generation);
+
+/**
+ * Returns how many times an image has been read from disk.
+ *
+ * @param cache a pointer to a cache returned from texture_cache_init()
+ * @return the number of images loaded
+ */
+size_t texture_cache_loads(texture_cache_t *cache);
+
+#endif // #ifndef __TEXTURE_CACHE_H__
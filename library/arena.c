@@ -0,0 +1,133 @@
+#include "arena.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// Released memory is kept on one free list per rounded size up to this many
+// alignment steps, so reuse never searches; larger sizes share one list
+#define ARENA_SIZE_CLASSES 32
+
+typedef struct arena_block {
+  struct arena_block *next;
+  size_t capacity;
+  size_t used;
+  alignas(max_align_t) unsigned char data[];
+} arena_block_t;
+
+// Memory given back with arena_release(), stored in the memory itself
+typedef struct arena_chunk {
+  struct arena_chunk *next;
+  size_t size;
+} arena_chunk_t;
+
+typedef struct arena {
+  arena_block_t *first;
+  arena_block_t *current;
+  arena_chunk_t *released[ARENA_SIZE_CLASSES];
+  arena_chunk_t *released_large;
+  size_t block_size;
+  size_t used;
+} arena_t;
+
+arena_t *arena_init(size_t block_size) {
+  arena_t *arena = malloc(sizeof(arena_t));
+  assert(arena != NULL);
+  assert(block_size > 0);
+  *arena = (arena_t){.first = NULL,
+                     .current = NULL,
+                     .released = {NULL},
+                     .released_large = NULL,
+                     .block_size = block_size,
+                     .used = 0};
+  return arena;
+}
+
+void arena_free(arena_t *arena) {
+  arena_block_t *block = arena->first;
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(arena);
+}
+
+arena_block_t *arena_block_init(size_t capacity) {
+  arena_block_t *block = malloc(sizeof(arena_block_t) + capacity);
+  assert(block != NULL);
+  *block = (arena_block_t){.next = NULL, .capacity = capacity, .used = 0};
+  return block;
+}
+
+/** Rounds size up so every allocation starts max-aligned */
+size_t arena_round(size_t size) {
+  size_t align = alignof(max_align_t);
+  return (size + align - 1) / align * align;
+}
+
+/**
+ * Returns the free list for memory of a rounded size, or NULL if the size is
+ * too large to have a list of its own
+ */
+arena_chunk_t **arena_size_class(arena_t *arena, size_t size) {
+  size_t index = size / alignof(max_align_t) - 1;
+  return index < ARENA_SIZE_CLASSES ? &arena->released[index] : NULL;
+}
+
+void *arena_alloc(arena_t *arena, size_t size) {
+  size = arena_round(size);
+  arena->used += size;
+
+  // Memory given back at exactly this size is reused before the block grows
+  arena_chunk_t **size_class = arena_size_class(arena, size);
+  if (size_class != NULL && *size_class != NULL) {
+    arena_chunk_t *chunk = *size_class;
+    *size_class = chunk->next;
+    return chunk;
+  }
+  if (size_class == NULL) {
+    for (arena_chunk_t **link = &arena->released_large; *link != NULL;
+         link = &(*link)->next) {
+      if ((*link)->size == size) {
+        arena_chunk_t *chunk = *link;
+        *link = chunk->next;
+        return chunk;
+      }
+    }
+  }
+
+  if (arena->current == NULL ||
+      arena->current->used + size > arena->current->capacity) {
+    size_t capacity = size > arena->block_size ? size : arena->block_size;
+    arena_block_t *block = arena_block_init(capacity);
+    if (arena->current == NULL) {
+      arena->first = block;
+    } else {
+      arena->current->next = block;
+    }
+    arena->current = block;
+  }
+
+  void *memory = arena->current->data + arena->current->used;
+  arena->current->used += size;
+  return memory;
+}
+
+void arena_release(arena_t *arena, void *memory, size_t size) {
+  size = arena_round(size);
+  // Too small to remember; stays in the block until the arena is freed
+  if (size < sizeof(arena_chunk_t)) {
+    return;
+  }
+  arena_chunk_t **size_class = arena_size_class(arena, size);
+  if (size_class == NULL) {
+    size_class = &arena->released_large;
+  }
+  arena_chunk_t *chunk = memory;
+  *chunk = (arena_chunk_t){.next = *size_class, .size = size};
+  *size_class = chunk;
+  arena->used -= size;
+}
+
+size_t arena_used(arena_t *arena) { return arena->used; }
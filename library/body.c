@@ -1,10 +1,15 @@
 #include "body.h"
+#include "arena.h"
+#include "pool.h"
+#include "snapshot.h"
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 double MAX_ROT_VELOCITY = 0.15;
+const size_t INITIAL_BINDS = 4;
+const body_handle_t BODY_HANDLE_NONE = {.index = 0, .generation = 0};
 
 typedef struct body {
   list_t *shape;
@@ -22,10 +27,18 @@ typedef struct body {
   bool is_destroyable;
   vector_t rotation_center;
   double rot_acceleration;
+  list_t *binds;
+  body_handle_t handle;
+  arena_t *arena;
+  pool_t *pool;
 } body_t;
 
-body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
-  body_t *body = malloc(sizeof(body_t));
+body_t *body_init_arena(arena_t *arena, list_t *shape, double mass,
+                        rgb_color_t color, void *info,
+                        free_func_t info_freer) {
+  body_t *body = arena != NULL ? arena_alloc(arena, sizeof(body_t))
+                               : malloc(sizeof(body_t));
+  assert(body != NULL);
   assert(mass > 0);
   *body = (body_t){.shape = shape,
                    .mass = mass,
@@ -35,22 +48,39 @@ body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
                    .net_force = VEC_ZERO,
                    .net_impulse = VEC_ZERO,
                    .rot_velocity = 0,
-                   .rot_acceleration = 0};
-  assert(body != NULL);
+                   .rot_acceleration = 0,
+                   .info = info,
+                   .info_freer = info_freer,
+                   .binds = list_init_arena(arena, INITIAL_BINDS, NULL),
+                   .handle = BODY_HANDLE_NONE,
+                   .arena = arena,
+                   .pool = NULL};
   return body;
 }
 
+body_t *body_init(list_t *shape, double mass, rgb_color_t color) {
+  return body_init_arena(NULL, shape, mass, color, NULL, NULL);
+}
+
 body_t *body_init_with_info(list_t *shape, double mass, rgb_color_t color,
                             void *info, free_func_t info_freer) {
-  body_t *body = body_init(shape, mass, color);
-  body->info = info;
-  body->info_freer = info_freer;
-
-  return body;
+  return body_init_arena(NULL, shape, mass, color, info, info_freer);
 };
 
 void body_free(body_t *body) {
+  // Pooled bodies keep all their storage and wait to be reset and reused
+  if (body->pool != NULL) {
+    list_clear(body->binds);
+    pool_put(body->pool, body);
+    return;
+  }
   list_free(body->shape);
+  list_free(body->binds);
+  // An arena body's info and vertices are reclaimed together with the arena
+  if (body->arena != NULL) {
+    arena_release(body->arena, body, sizeof(body_t));
+    return;
+  }
   if (body->info_freer != NULL) {
     body->info_freer(body->info);
   }
@@ -68,6 +98,8 @@ list_t *body_get_shape(body_t *body) {
   return return_shape;
 }
 
+list_t *body_get_vertices(body_t *body) { return body->shape; }
+
 double body_area_helper(list_t *shape) {
   double area = 0;
   size_t size = list_size(shape);
@@ -221,6 +253,91 @@ void body_tick(body_t *body, double dt) {
   body->net_impulse = VEC_ZERO;
 }
 
+list_t *body_get_binds(body_t *body) { return body->binds; }
+
+void body_set_pool(body_t *body, pool_t *pool) { body->pool = pool; }
+
+void body_reset_rect(body_t *body, double width, double height, double mass,
+                     rgb_color_t color) {
+  assert(mass > 0);
+  rect_set(body->shape, width, height);
+  body->mass = mass;
+  body->color = color;
+  body->angle = 0;
+  body->velocity = VEC_ZERO;
+  body->rot_velocity = 0;
+  body->net_force = VEC_ZERO;
+  body->net_impulse = VEC_ZERO;
+  body->is_removed = false;
+  body->is_destroyable = false;
+  body->rotation_center = VEC_ZERO;
+  body->rot_acceleration = 0;
+  body->handle = BODY_HANDLE_NONE;
+}
+
+body_handle_t body_get_handle(body_t *body) { return body->handle; }
+
+void body_set_handle(body_t *body, body_handle_t handle) {
+  body->handle = handle;
+}
+
 void body_remove(body_t *body) { body->is_removed = true; }
 
-bool body_is_removed(body_t *body) { return body->is_removed; }
\ No newline at end of file
+bool body_is_removed(body_t *body) { return body->is_removed; }
+
+void body_save(body_t *body, snapshot_t *snapshot) {
+  snapshot_write(snapshot, &body->mass, sizeof(body->mass));
+  snapshot_write(snapshot, &body->color, sizeof(body->color));
+  snapshot_write(snapshot, &body->angle, sizeof(body->angle));
+  snapshot_write(snapshot, &body->velocity, sizeof(body->velocity));
+  snapshot_write(snapshot, &body->rot_velocity, sizeof(body->rot_velocity));
+  snapshot_write(snapshot, &body->centroid, sizeof(body->centroid));
+  snapshot_write(snapshot, &body->net_force, sizeof(body->net_force));
+  snapshot_write(snapshot, &body->net_impulse, sizeof(body->net_impulse));
+  snapshot_write(snapshot, &body->is_removed, sizeof(body->is_removed));
+  snapshot_write(snapshot, &body->is_destroyable,
+                 sizeof(body->is_destroyable));
+  snapshot_write(snapshot, &body->rotation_center,
+                 sizeof(body->rotation_center));
+  snapshot_write(snapshot, &body->rot_acceleration,
+                 sizeof(body->rot_acceleration));
+
+  size_t vertex_count = list_size(body->shape);
+  snapshot_write(snapshot, &vertex_count, sizeof(vertex_count));
+  for (size_t i = 0; i < vertex_count; i++) {
+    snapshot_write(snapshot, list_get(body->shape, i), sizeof(vector_t));
+  }
+}
+
+body_t *body_load(snapshot_t *snapshot, arena_t *arena, void *info,
+                  free_func_t info_freer) {
+  body_t *body = body_init_arena(arena, NULL, 1, (rgb_color_t){0, 0, 0}, info,
+                                 info_freer);
+  snapshot_read(snapshot, &body->mass, sizeof(body->mass));
+  snapshot_read(snapshot, &body->color, sizeof(body->color));
+  snapshot_read(snapshot, &body->angle, sizeof(body->angle));
+  snapshot_read(snapshot, &body->velocity, sizeof(body->velocity));
+  snapshot_read(snapshot, &body->rot_velocity, sizeof(body->rot_velocity));
+  snapshot_read(snapshot, &body->centroid, sizeof(body->centroid));
+  snapshot_read(snapshot, &body->net_force, sizeof(body->net_force));
+  snapshot_read(snapshot, &body->net_impulse, sizeof(body->net_impulse));
+  snapshot_read(snapshot, &body->is_removed, sizeof(body->is_removed));
+  snapshot_read(snapshot, &body->is_destroyable, sizeof(body->is_destroyable));
+  snapshot_read(snapshot, &body->rotation_center,
+                sizeof(body->rotation_center));
+  snapshot_read(snapshot, &body->rot_acceleration,
+                sizeof(body->rot_acceleration));
+
+  size_t vertex_count = snapshot_read_count(snapshot, sizeof(vector_t));
+  // Arena vertices die with the arena, so the list must not free them
+  body->shape =
+      list_init_arena(arena, vertex_count, arena != NULL ? NULL : free);
+  for (size_t i = 0; i < vertex_count; i++) {
+    vector_t *vertex = arena != NULL ? arena_alloc(arena, sizeof(vector_t))
+                                     : malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    snapshot_read(snapshot, vertex, sizeof(vector_t));
+    list_add(body->shape, vertex);
+  }
+  return body;
+}
@@ -17,6 +17,7 @@ void loop() {
 
   if (sdl_is_done((void *)state)) { // Once our demo exits...
     emscripten_free(state);         // Free any state variables we've been using
+    sdl_clean();                    // Stop drawing and close the window
 #ifdef __EMSCRIPTEN__ // Clean up emscripten environment (if we're using it)
     emscripten_cancel_main_loop();
     emscripten_force_exit(0);
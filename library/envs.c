@@ -0,0 +1,214 @@
+#include "envs.h"
+#include "game_const.h"
+#include "jobs.h"
+#include "match.h"
+#include "player.h"
+#include "projectile.h"
+#include "rng.h"
+#include "runtime.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+// Matches per chunk handed to a thread
+const size_t ENVS_JOB_GRAIN = 4;
+const size_t ENV_PLAYERS = 2;
+// Sizes the nearest-projectile arrays, so it is a constant expression
+#define ENV_NEAREST_PROJECTILES 4
+const size_t ENV_PLAYER_FLOATS = 7;
+const size_t ENV_PROJECTILE_FLOATS = 5;
+
+const body_type_t ENV_PLAYER_TYPES[2] = {PLAYER1, PLAYER2};
+
+typedef struct env {
+  state_t *state;
+  // Seeds each new match of this environment
+  rng_t *seeds;
+  uint8_t held[2];
+} env_t;
+
+typedef struct envs {
+  env_t *envs;
+  size_t count;
+  game_state_t map;
+  jobs_t *jobs;
+
+  // Arguments of the step in progress, shared by every chunk
+  const uint8_t *actions;
+  float *observations;
+  bool *dones;
+} envs_t;
+
+void env_start(env_t *env, game_state_t map) {
+  env->state = match_init(map, rng_next(env->seeds));
+  env->held[0] = 0;
+  env->held[1] = 0;
+}
+
+envs_t *envs_init(size_t count, game_state_t map, uint64_t seed,
+                  size_t threads) {
+  envs_t *envs = malloc(sizeof(envs_t));
+  assert(envs != NULL);
+  *envs = (envs_t){.envs = malloc(count * sizeof(env_t)),
+                   .count = count,
+                   .map = map,
+                   .jobs = jobs_init(threads),
+                   .actions = NULL,
+                   .observations = NULL,
+                   .dones = NULL};
+  assert(envs->envs != NULL);
+
+  // Sprites read the window bounds, so set them once before any thread runs
+  if (map == MAP1) {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX1);
+  } else {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  }
+  for (size_t i = 0; i < count; i++) {
+    envs->envs[i].seeds = rng_init(seed, i);
+    env_start(&envs->envs[i], map);
+  }
+  return envs;
+}
+
+void envs_free(envs_t *envs) {
+  for (size_t i = 0; i < envs->count; i++) {
+    match_free(envs->envs[i].state);
+    rng_free(envs->envs[i].seeds);
+  }
+  jobs_free(envs->jobs);
+  free(envs->envs);
+  free(envs);
+}
+
+size_t envs_count(envs_t *envs) { return envs->count; }
+
+state_t *envs_get_match(envs_t *envs, size_t index) {
+  assert(index < envs->count);
+  return envs->envs[index].state;
+}
+
+size_t envs_observation_size(void) {
+  return ENV_PLAYERS * (ENV_PLAYER_FLOATS +
+                        ENV_NEAREST_PROJECTILES * ENV_PROJECTILE_FLOATS);
+}
+
+/** Writes the projectiles nearest to position, closest first */
+void env_observe_projectiles(projectiles_t *projectiles, vector_t position,
+                             float *out) {
+  size_t nearest[ENV_NEAREST_PROJECTILES];
+  double distances[ENV_NEAREST_PROJECTILES];
+  size_t found = 0;
+  for (size_t i = 0; i < projectiles_size(projectiles); i++) {
+    vector_t offset =
+        vec_subtract(projectiles_get_position(projectiles, i), position);
+    double distance = vec_dot(offset, offset);
+    if (found == ENV_NEAREST_PROJECTILES &&
+        distance >= distances[found - 1]) {
+      continue;
+    }
+
+    // Insertion into the short sorted list, dropping the farthest when full
+    size_t slot = found < ENV_NEAREST_PROJECTILES ? found : found - 1;
+    while (slot > 0 && distances[slot - 1] > distance) {
+      distances[slot] = distances[slot - 1];
+      nearest[slot] = nearest[slot - 1];
+      slot--;
+    }
+    distances[slot] = distance;
+    nearest[slot] = i;
+    if (found < ENV_NEAREST_PROJECTILES) {
+      found++;
+    }
+  }
+
+  for (size_t i = 0; i < ENV_NEAREST_PROJECTILES; i++) {
+    float *slot = &out[i * ENV_PROJECTILE_FLOATS];
+    if (i >= found) {
+      for (size_t j = 0; j < ENV_PROJECTILE_FLOATS; j++) {
+        slot[j] = 0;
+      }
+      continue;
+    }
+    vector_t offset = vec_subtract(
+        projectiles_get_position(projectiles, nearest[i]), position);
+    vector_t velocity = projectiles_get_velocity(projectiles, nearest[i]);
+    slot[0] = offset.x;
+    slot[1] = offset.y;
+    slot[2] = velocity.x;
+    slot[3] = velocity.y;
+    slot[4] = 1;
+  }
+}
+
+void env_observe(env_t *env, float *out) {
+  scene_t *scene = match_get_scene(env->state);
+  size_t player_floats = envs_observation_size() / ENV_PLAYERS;
+  for (size_t p = 0; p < ENV_PLAYERS; p++) {
+    float *player_out = &out[p * player_floats];
+    body_t *player = scene_first_of_type(scene, ENV_PLAYER_TYPES[p]);
+    if (player == NULL) {
+      for (size_t i = 0; i < player_floats; i++) {
+        player_out[i] = 0;
+      }
+      continue;
+    }
+
+    body_info_t *info = get_info(player);
+    vector_t position = body_get_centroid(player);
+    vector_t velocity = body_get_velocity(player);
+    player_out[0] = position.x;
+    player_out[1] = position.y;
+    player_out[2] = velocity.x;
+    player_out[3] = velocity.y;
+    player_out[4] = info->weapon_type;
+    player_out[5] = isinf(info->shots_left) ? -1 : info->shots_left;
+    player_out[6] = match_get_lives(env->state, ENV_PLAYER_TYPES[p]);
+    env_observe_projectiles(scene_get_projectiles(scene), position,
+                            &player_out[ENV_PLAYER_FLOATS]);
+  }
+}
+
+void env_apply_actions(env_t *env, const uint8_t *actions) {
+  for (size_t p = 0; p < ENV_PLAYERS; p++) {
+    match_actions(env->state, p, env->held[p], actions[p]);
+    env->held[p] = actions[p];
+  }
+}
+
+void envs_step_job(envs_t *envs, size_t begin, size_t end) {
+  size_t observation_size = envs_observation_size();
+  for (size_t i = begin; i < end; i++) {
+    env_t *env = &envs->envs[i];
+    env_apply_actions(env, &envs->actions[i * ENV_PLAYERS]);
+    match_step(env->state, RUNTIME_TICK_DT);
+
+    bool done = match_is_over(env->state);
+    if (done) {
+      match_free(env->state);
+      env_start(env, envs->map);
+    }
+    if (envs->dones != NULL) {
+      envs->dones[i] = done;
+    }
+    if (envs->observations != NULL) {
+      env_observe(env, &envs->observations[i * observation_size]);
+    }
+  }
+}
+
+void envs_observe(envs_t *envs, float *observations) {
+  size_t observation_size = envs_observation_size();
+  for (size_t i = 0; i < envs->count; i++) {
+    env_observe(&envs->envs[i], &observations[i * observation_size]);
+  }
+}
+
+void envs_step(envs_t *envs, const uint8_t *actions, float *observations,
+               bool *dones) {
+  envs->actions = actions;
+  envs->observations = observations;
+  envs->dones = dones;
+  jobs_parallel_for(envs->jobs, envs->count, ENVS_JOB_GRAIN,
+                    (job_func_t)envs_step_job, envs);
+}
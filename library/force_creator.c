@@ -1,93 +1,137 @@
 #include "force_creator.h"
+#include "game_weapon.h"
+#include "scene.h"
+#include "snapshot.h"
+#include <assert.h>
 #include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// Tags saved in place of a bind's force and collision handler functions.
+// Append new tags at the end so older values keep their meaning.
+typedef enum {
+  FORCE_TAG_GRAVITY,
+  FORCE_TAG_SPRING,
+  FORCE_TAG_DRAG,
+  FORCE_TAG_NORMAL,
+  FORCE_TAG_COLLISION
+} force_tag_t;
+
+typedef enum {
+  HANDLER_TAG_PHYSICS,
+  HANDLER_TAG_DESTRUCTIVE,
+  HANDLER_TAG_PICKUP
+} handler_tag_t;
+
 typedef struct force_aux_2bodies {
   double Constant;
-  body_t *body1;
-  body_t *body2;
+  scene_t *scene;
+  body_handle_t body1;
+  body_handle_t body2;
 } force_aux_2bodies_t;
 
 typedef struct force_aux_1body {
   double Constant;
-  body_t *body;
+  scene_t *scene;
+  body_handle_t body;
 } force_aux_1body_t;
 
 typedef struct force_aux_collision_bodies {
-  body_t *body1;
-  body_t *body2;
+  scene_t *scene;
+  body_handle_t body1;
+  body_handle_t body2;
+  bool is_prepared;
+  collision_info_t prepared;
 } force_aux_collision_bodies_t;
 
 typedef struct force_aux_collision {
   collision_handler_t handler;
-  body_t *body1;
-  body_t *body2;
+  scene_t *scene;
+  body_handle_t body1;
+  body_handle_t body2;
   void *collision_aux;
   free_func_t freer;
   bool are_colliding;
+  bool is_prepared;
+  collision_info_t prepared;
 } force_aux_collision_t;
 
 typedef struct collision_aux_destructive {
+  scene_t *scene;
   bool body1_is_destroyable;
   bool body2_is_destroyable;
   size_t coll_before_destruct;
 } collision_aux_destructive_t;
 
 typedef struct collision_aux_physics {
+  scene_t *scene;
   double elasticity;
 } collision_aux_physics_t;
 
-force_aux_1body_t *force_aux_1body_init(double constant, body_t *body) {
-  force_aux_1body_t *aux = malloc(sizeof(force_aux_1body_t));
+force_aux_1body_t *force_aux_1body_init(scene_t *scene, double constant,
+                                        body_t *body) {
+  force_aux_1body_t *aux = scene_alloc(scene, sizeof(force_aux_1body_t));
   aux->Constant = constant;
-  aux->body = body;
+  aux->scene = scene;
+  aux->body = body_get_handle(body);
   return aux;
 }
 
-force_aux_2bodies_t *force_aux_2bodies_init(double constant, body_t *body1,
-                                            body_t *body2) {
-  force_aux_2bodies_t *aux = malloc(sizeof(force_aux_2bodies_t));
+force_aux_2bodies_t *force_aux_2bodies_init(scene_t *scene, double constant,
+                                            body_t *body1, body_t *body2) {
+  force_aux_2bodies_t *aux = scene_alloc(scene, sizeof(force_aux_2bodies_t));
   aux->Constant = constant;
-  aux->body1 = body1;
-  aux->body2 = body2;
+  aux->scene = scene;
+  aux->body1 = body_get_handle(body1);
+  aux->body2 = body_get_handle(body2);
   return aux;
 }
 
-force_aux_collision_bodies_t *force_aux_collision_bodies_init(body_t *body1,
-                                                              body_t *body2) {
+force_aux_collision_bodies_t *
+force_aux_collision_bodies_init(scene_t *scene, body_t *body1, body_t *body2) {
   force_aux_collision_bodies_t *aux =
-      malloc(sizeof(force_aux_collision_bodies_t));
-  aux->body1 = body1;
-  aux->body2 = body2;
+      scene_alloc(scene, sizeof(force_aux_collision_bodies_t));
+  aux->scene = scene;
+  aux->body1 = body_get_handle(body1);
+  aux->body2 = body_get_handle(body2);
+  aux->is_prepared = false;
   return aux;
 }
 
-force_aux_collision_t *force_aux_collision_init(body_t *body1, body_t *body2,
+force_aux_collision_t *force_aux_collision_init(scene_t *scene, body_t *body1,
+                                                body_t *body2,
                                                 collision_handler_t handler,
                                                 void *aux, free_func_t freer) {
-  force_aux_collision_t *collision_aux = malloc(sizeof(force_aux_collision_t));
-  collision_aux->body1 = body1;
-  collision_aux->body2 = body2;
+  force_aux_collision_t *collision_aux =
+      scene_alloc(scene, sizeof(force_aux_collision_t));
+  collision_aux->scene = scene;
+  collision_aux->body1 = body_get_handle(body1);
+  collision_aux->body2 = body_get_handle(body2);
   collision_aux->handler = handler;
   collision_aux->collision_aux = aux;
   collision_aux->freer = freer;
   collision_aux->are_colliding = false;
+  collision_aux->is_prepared = false;
   return collision_aux;
 }
 
-collision_aux_physics_t *collision_aux_physics_init(double elasticity) {
-  collision_aux_physics_t *aux = malloc(sizeof(collision_aux_physics_t));
+collision_aux_physics_t *collision_aux_physics_init(scene_t *scene,
+                                                    double elasticity) {
+  collision_aux_physics_t *aux =
+      scene_alloc(scene, sizeof(collision_aux_physics_t));
+  aux->scene = scene;
   aux->elasticity = elasticity;
   return aux;
 }
 
 collision_aux_destructive_t *
-collision_aux_destructive_init(bool body1_is_destroyable,
+collision_aux_destructive_init(scene_t *scene, bool body1_is_destroyable,
                                bool body2_is_destroyable,
                                size_t coll_before_destruct) {
   collision_aux_destructive_t *aux =
-      malloc(sizeof(collision_aux_destructive_t));
+      scene_alloc(scene, sizeof(collision_aux_destructive_t));
+  aux->scene = scene;
   aux->body1_is_destroyable = body1_is_destroyable;
   aux->body2_is_destroyable = body2_is_destroyable;
   aux->coll_before_destruct = coll_before_destruct;
@@ -97,8 +141,11 @@ collision_aux_destructive_init(bool body1_is_destroyable,
 void calc_gravity(void *void_aux) {
   force_aux_2bodies_t *aux = (force_aux_2bodies_t *)void_aux;
   double G = aux->Constant;
-  body_t *body1 = aux->body1;
-  body_t *body2 = aux->body2;
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
 
   vector_t diff =
       vec_subtract(body_get_centroid(body1), body_get_centroid(body2));
@@ -118,8 +165,11 @@ void calc_gravity(void *void_aux) {
 void calc_spring(void *void_aux) {
   force_aux_2bodies_t *aux = (force_aux_2bodies_t *)void_aux;
   double k = aux->Constant;
-  body_t *body1 = aux->body1;
-  body_t *body2 = aux->body2;
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
 
   vector_t body1_centroid = body_get_centroid(body1);
   vector_t body2_centroid = body_get_centroid(body2);
@@ -134,27 +184,55 @@ void calc_spring(void *void_aux) {
 void calc_drag(void *void_aux) {
   force_aux_1body_t *aux = (force_aux_1body_t *)void_aux;
   double gamma = aux->Constant;
-  body_t *body = aux->body;
+  body_t *body = scene_resolve(aux->scene, aux->body);
+  if (body == NULL) {
+    return;
+  }
 
   vector_t force = {-gamma * body_get_velocity(body).x,
                     -gamma * body_get_velocity(body).y};
   body_add_force(body, force);
 }
 
+/** Tests two bodies for collision, skipping pairs whose bounds are apart */
+collision_info_t scene_collision(scene_t *scene, body_t *body1,
+                                 body_t *body2) {
+  if (!scene_bounds_overlap(scene, body1, body2)) {
+    return (collision_info_t){.collided = false};
+  }
+  return find_collision(body_get_vertices(body1), body_get_vertices(body2));
+}
+
+void prepare_collision(void *void_aux) {
+  force_aux_collision_t *aux = (force_aux_collision_t *)void_aux;
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
+  aux->prepared = scene_collision(aux->scene, body1, body2);
+  aux->is_prepared = true;
+}
+
 void calc_collision(void *void_aux) {
   force_aux_collision_t *aux = (force_aux_collision_t *)void_aux;
-  list_t *shape1 = body_get_shape(aux->body1);
-  list_t *shape2 = body_get_shape(aux->body2);
-  collision_info_t info = find_collision(shape1, shape2);
-  if (!aux->are_colliding && info.collided && aux->body1 != aux->body2) {
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
+  collision_info_t info =
+      aux->is_prepared
+          ? aux->prepared
+          : find_collision(body_get_vertices(body1), body_get_vertices(body2));
+  aux->is_prepared = false;
+  if (!aux->are_colliding && info.collided && body1 != body2) {
     aux->are_colliding = true;
     vector_t axis = info.axis;
-    aux->handler(aux->body1, aux->body2, axis, aux->collision_aux);
+    aux->handler(body1, body2, axis, aux->collision_aux);
   } else if (!info.collided) {
     aux->are_colliding = false;
   }
-  list_free(shape1);
-  list_free(shape2);
 }
 
 void calc_destructive_collision(body_t *body1, body_t *body2, vector_t axis,
@@ -205,15 +283,30 @@ void calc_physics_collision(body_t *body1, body_t *body2, vector_t axis,
   body_add_impulse(body2, vec_negate(impulse_body1));
 }
 
-void calc_normal_force(void *void_aux) {
+void prepare_normal_force(void *void_aux) {
   force_aux_collision_bodies_t *aux = (force_aux_collision_bodies_t *)void_aux;
-  body_t *body1 = aux->body1;
-  body_t *body2 = aux->body2;
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
+  aux->prepared = scene_collision(aux->scene, body1, body2);
+  aux->is_prepared = true;
+}
 
-  list_t *shape1 = body_get_shape(body1);
-  list_t *shape2 = body_get_shape(body2);
+void calc_normal_force(void *void_aux) {
+  force_aux_collision_bodies_t *aux = (force_aux_collision_bodies_t *)void_aux;
+  body_t *body1 = scene_resolve(aux->scene, aux->body1);
+  body_t *body2 = scene_resolve(aux->scene, aux->body2);
+  if (body1 == NULL || body2 == NULL) {
+    return;
+  }
 
-  collision_info_t collision = find_collision(shape1, shape2);
+  collision_info_t collision =
+      aux->is_prepared
+          ? aux->prepared
+          : find_collision(body_get_vertices(body1), body_get_vertices(body2));
+  aux->is_prepared = false;
 
   vector_t center_diff =
       vec_subtract(body_get_centroid(body2), body_get_centroid(body1));
@@ -222,10 +315,9 @@ void calc_normal_force(void *void_aux) {
   }
 
   if (!collision.collided) {
-    list_free(shape1);
-    list_free(shape2);
     return;
   }
+
   double normal_force_abs_body1 =
       vec_dot(body_get_net_force(body1), collision.axis);
   double normal_force_abs_body2 =
@@ -254,17 +346,213 @@ void calc_normal_force(void *void_aux) {
   else {
     calc_physics_collision(body1, body2, collision.axis, aux);
   }
-
-  list_free(shape1);
-  list_free(shape2);
 }
 
 void standard_free_aux(void *aux) { free(aux); }
 
+// Each aux goes back to the scene it was allocated from, which hands arena
+// memory out again for the next bind of the same kind
+
+void free_aux_1body(void *aux) {
+  scene_release(((force_aux_1body_t *)aux)->scene, aux,
+                sizeof(force_aux_1body_t));
+}
+
+void free_aux_2bodies(void *aux) {
+  scene_release(((force_aux_2bodies_t *)aux)->scene, aux,
+                sizeof(force_aux_2bodies_t));
+}
+
+void free_aux_collision_bodies(void *aux) {
+  scene_release(((force_aux_collision_bodies_t *)aux)->scene, aux,
+                sizeof(force_aux_collision_bodies_t));
+}
+
+void free_aux_physics(void *aux) {
+  scene_release(((collision_aux_physics_t *)aux)->scene, aux,
+                sizeof(collision_aux_physics_t));
+}
+
+void free_aux_destructive(void *aux) {
+  scene_release(((collision_aux_destructive_t *)aux)->scene, aux,
+                sizeof(collision_aux_destructive_t));
+}
+
 void free_aux_collision(void *void_aux) {
   force_aux_collision_t *aux = (force_aux_collision_t *)void_aux;
   if (aux->freer != NULL) {
     aux->freer(aux->collision_aux);
   }
-  free(aux);
-}
\ No newline at end of file
+  scene_release(aux->scene, aux, sizeof(force_aux_collision_t));
+}
+
+// SNAPSHOTS
+// Only the parameters of each aux are saved. Handles stay valid because the
+// scene restores its slots exactly, and the scene pointer is the restoring
+// scene. Prepared collisions never outlive a tick, so they are not saved.
+// Loading returns false on a tag no save function writes.
+
+void collision_handler_save(snapshot_t *snapshot, force_aux_collision_t *aux) {
+  uint8_t tag;
+  if (aux->handler == (collision_handler_t)calc_physics_collision) {
+    tag = HANDLER_TAG_PHYSICS;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    collision_aux_physics_t *physics = aux->collision_aux;
+    snapshot_write(snapshot, &physics->elasticity, sizeof(double));
+  } else if (aux->handler ==
+             (collision_handler_t)calc_destructive_collision) {
+    tag = HANDLER_TAG_DESTRUCTIVE;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    // Field by field, so the struct padding never reaches the snapshot
+    collision_aux_destructive_t *destructive = aux->collision_aux;
+    snapshot_write(snapshot, &destructive->body1_is_destroyable, sizeof(bool));
+    snapshot_write(snapshot, &destructive->body2_is_destroyable, sizeof(bool));
+    snapshot_write(snapshot, &destructive->coll_before_destruct,
+                   sizeof(size_t));
+  } else {
+    // Every other handler must be listed here to be saved
+    assert(aux->handler == (collision_handler_t)calc_pickup_collision);
+    tag = HANDLER_TAG_PICKUP;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+  }
+}
+
+bool collision_handler_load(snapshot_t *snapshot, force_aux_collision_t *aux) {
+  uint8_t tag;
+  snapshot_read(snapshot, &tag, sizeof(tag));
+  switch (tag) {
+  case HANDLER_TAG_PHYSICS: {
+    double elasticity;
+    snapshot_read(snapshot, &elasticity, sizeof(elasticity));
+    aux->handler = (collision_handler_t)calc_physics_collision;
+    aux->collision_aux = collision_aux_physics_init(aux->scene, elasticity);
+    aux->freer = free_aux_physics;
+    break;
+  }
+  case HANDLER_TAG_DESTRUCTIVE: {
+    collision_aux_destructive_t *destructive =
+        collision_aux_destructive_init(aux->scene, false, false, 0);
+    snapshot_read(snapshot, &destructive->body1_is_destroyable, sizeof(bool));
+    snapshot_read(snapshot, &destructive->body2_is_destroyable, sizeof(bool));
+    snapshot_read(snapshot, &destructive->coll_before_destruct, sizeof(size_t));
+    aux->handler = (collision_handler_t)calc_destructive_collision;
+    aux->collision_aux = destructive;
+    aux->freer = free_aux_destructive;
+    break;
+  }
+  case HANDLER_TAG_PICKUP:
+    aux->handler = (collision_handler_t)calc_pickup_collision;
+    aux->collision_aux = NULL;
+    aux->freer = NULL;
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+void force_creator_save(snapshot_t *snapshot, force_creator_t forcer,
+                        void *aux) {
+  uint8_t tag;
+  if (forcer == (force_creator_t)calc_gravity ||
+      forcer == (force_creator_t)calc_spring) {
+    tag = forcer == (force_creator_t)calc_gravity ? FORCE_TAG_GRAVITY
+                                                  : FORCE_TAG_SPRING;
+    force_aux_2bodies_t *bodies_aux = aux;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    snapshot_write(snapshot, &bodies_aux->Constant, sizeof(double));
+    snapshot_write(snapshot, &bodies_aux->body1, sizeof(body_handle_t));
+    snapshot_write(snapshot, &bodies_aux->body2, sizeof(body_handle_t));
+  } else if (forcer == (force_creator_t)calc_drag) {
+    tag = FORCE_TAG_DRAG;
+    force_aux_1body_t *body_aux = aux;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    snapshot_write(snapshot, &body_aux->Constant, sizeof(double));
+    snapshot_write(snapshot, &body_aux->body, sizeof(body_handle_t));
+  } else if (forcer == (force_creator_t)calc_normal_force) {
+    tag = FORCE_TAG_NORMAL;
+    force_aux_collision_bodies_t *normal_aux = aux;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    snapshot_write(snapshot, &normal_aux->body1, sizeof(body_handle_t));
+    snapshot_write(snapshot, &normal_aux->body2, sizeof(body_handle_t));
+  } else {
+    // Every other force creator must be listed here to be saved
+    assert(forcer == (force_creator_t)calc_collision);
+    tag = FORCE_TAG_COLLISION;
+    force_aux_collision_t *collision_aux = aux;
+    snapshot_write(snapshot, &tag, sizeof(tag));
+    snapshot_write(snapshot, &collision_aux->body1, sizeof(body_handle_t));
+    snapshot_write(snapshot, &collision_aux->body2, sizeof(body_handle_t));
+    snapshot_write(snapshot, &collision_aux->are_colliding, sizeof(bool));
+    collision_handler_save(snapshot, collision_aux);
+  }
+}
+
+bool force_creator_load(snapshot_t *snapshot, scene_t *scene,
+                        force_creator_t *prepare, force_creator_t *forcer,
+                        void **aux, free_func_t *freer) {
+  uint8_t tag;
+  snapshot_read(snapshot, &tag, sizeof(tag));
+  *prepare = NULL;
+  switch (tag) {
+  case FORCE_TAG_GRAVITY:
+  case FORCE_TAG_SPRING: {
+    force_aux_2bodies_t *bodies_aux =
+        scene_alloc(scene, sizeof(force_aux_2bodies_t));
+    bodies_aux->scene = scene;
+    snapshot_read(snapshot, &bodies_aux->Constant, sizeof(double));
+    snapshot_read(snapshot, &bodies_aux->body1, sizeof(body_handle_t));
+    snapshot_read(snapshot, &bodies_aux->body2, sizeof(body_handle_t));
+    *forcer = tag == FORCE_TAG_GRAVITY ? (force_creator_t)calc_gravity
+                                       : (force_creator_t)calc_spring;
+    *aux = bodies_aux;
+    *freer = free_aux_2bodies;
+    break;
+  }
+  case FORCE_TAG_DRAG: {
+    force_aux_1body_t *body_aux = scene_alloc(scene, sizeof(force_aux_1body_t));
+    body_aux->scene = scene;
+    snapshot_read(snapshot, &body_aux->Constant, sizeof(double));
+    snapshot_read(snapshot, &body_aux->body, sizeof(body_handle_t));
+    *forcer = (force_creator_t)calc_drag;
+    *aux = body_aux;
+    *freer = free_aux_1body;
+    break;
+  }
+  case FORCE_TAG_NORMAL: {
+    force_aux_collision_bodies_t *normal_aux =
+        scene_alloc(scene, sizeof(force_aux_collision_bodies_t));
+    normal_aux->scene = scene;
+    normal_aux->is_prepared = false;
+    snapshot_read(snapshot, &normal_aux->body1, sizeof(body_handle_t));
+    snapshot_read(snapshot, &normal_aux->body2, sizeof(body_handle_t));
+    *prepare = (force_creator_t)prepare_normal_force;
+    *forcer = (force_creator_t)calc_normal_force;
+    *aux = normal_aux;
+    *freer = free_aux_collision_bodies;
+    break;
+  }
+  case FORCE_TAG_COLLISION: {
+    force_aux_collision_t *collision_aux =
+        scene_alloc(scene, sizeof(force_aux_collision_t));
+    collision_aux->scene = scene;
+    collision_aux->is_prepared = false;
+    snapshot_read(snapshot, &collision_aux->body1, sizeof(body_handle_t));
+    snapshot_read(snapshot, &collision_aux->body2, sizeof(body_handle_t));
+    snapshot_read(snapshot, &collision_aux->are_colliding, sizeof(bool));
+    if (!collision_handler_load(snapshot, collision_aux)) {
+      scene_release(scene, collision_aux, sizeof(force_aux_collision_t));
+      return false;
+    }
+    *prepare = (force_creator_t)prepare_collision;
+    *forcer = (force_creator_t)calc_collision;
+    *aux = collision_aux;
+    *freer = free_aux_collision;
+    break;
+  }
+  default:
+    return false;
+  }
+  return true;
+}
+// END OF SNAPSHOTS
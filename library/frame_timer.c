@@ -0,0 +1,103 @@
+#include "frame_timer.h"
+#include "runtime.h"
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct frame_timer {
+  double last;
+  bool has_ticked;
+  // The latest frame times, oldest overwritten first
+  double *times;
+  size_t window;
+  size_t count;
+  size_t next;
+  // Room to sort the window in without allocating
+  double *sorted;
+} frame_timer_t;
+
+frame_timer_t *frame_timer_init(size_t window) {
+  assert(window > 0);
+  frame_timer_t *timer = malloc(sizeof(frame_timer_t));
+  assert(timer != NULL);
+  *timer = (frame_timer_t){.has_ticked = false,
+                           .times = malloc(window * sizeof(double)),
+                           .window = window,
+                           .count = 0,
+                           .next = 0,
+                           .sorted = malloc(window * sizeof(double))};
+  assert(timer->times != NULL && timer->sorted != NULL);
+  return timer;
+}
+
+void frame_timer_free(frame_timer_t *timer) {
+  free(timer->times);
+  free(timer->sorted);
+  free(timer);
+}
+
+void frame_timer_add(frame_timer_t *timer, double seconds) {
+  timer->times[timer->next] = seconds;
+  timer->next = (timer->next + 1) % timer->window;
+  if (timer->count < timer->window) {
+    timer->count++;
+  }
+}
+
+double frame_timer_tick(frame_timer_t *timer) {
+  double now = runtime_now();
+  if (!timer->has_ticked) {
+    timer->last = now;
+    timer->has_ticked = true;
+    return 0.0;
+  }
+
+  double elapsed = now - timer->last;
+  timer->last = now;
+  frame_timer_add(timer, elapsed);
+  return elapsed;
+}
+
+int frame_time_compare(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/** Returns the time below which a fraction of the sorted times fall */
+double frame_time_percentile(const double *sorted, size_t count,
+                             double fraction) {
+  size_t rank = (size_t)ceil(fraction * count);
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+frame_stats_t frame_timer_stats(frame_timer_t *timer) {
+  size_t count = timer->count;
+  if (count == 0) {
+    return (frame_stats_t){0};
+  }
+  // The window is in arrival order; which end is oldest does not matter
+  double total = 0;
+  for (size_t i = 0; i < count; i++) {
+    timer->sorted[i] = timer->times[i];
+    total += timer->times[i];
+  }
+  qsort(timer->sorted, count, sizeof(double), frame_time_compare);
+  return (frame_stats_t){
+      .frames = count,
+      .min = timer->sorted[0],
+      .avg = total / count,
+      .p50 = frame_time_percentile(timer->sorted, count, 0.50),
+      .p95 = frame_time_percentile(timer->sorted, count, 0.95),
+      .p99 = frame_time_percentile(timer->sorted, count, 0.99),
+      .max = timer->sorted[count - 1]};
+}
+
+void frame_timer_print(frame_timer_t *timer, const char *name) {
+  frame_stats_t stats = frame_timer_stats(timer);
+  printf("%s: last %zu frames, ms min %.3f avg %.3f p50 %.3f p95 %.3f "
+         "p99 %.3f max %.3f\n",
+         name, stats.frames, stats.min * 1e3, stats.avg * 1e3,
+         stats.p50 * 1e3, stats.p95 * 1e3, stats.p99 * 1e3, stats.max * 1e3);
+}
@@ -0,0 +1,12 @@
+#include "hash.h"
+
+const uint64_t FNV_PRIME = 1099511628211ULL;
+
+uint64_t hash_bytes(uint64_t hash, const void *bytes, size_t size) {
+  const uint8_t *data = bytes;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
@@ -0,0 +1,88 @@
+#include "envs.h"
+#include "rng.h"
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Runs the game without a display as fast as the CPU allows, then reports
+ * how many simulated ticks it ran per second. Build it with sdl_headless.c
+ * and envs.c in place of emscripten.c and sdl_wrapper.c. HEADLESS_TICKS sets
+ * how many ticks to run.
+ *
+ * HEADLESS_ENVS=n times a batch of n training matches from envs.c instead,
+ * stepped on HEADLESS_THREADS threads with random held inputs and full
+ * observations, and reports env-steps per second.
+ */
+
+const size_t DEFAULT_HEADLESS_TICKS = 3600;
+const uint64_t HEADLESS_ENVS_SEED = 1;
+// Every combination of env_action_t
+const uint32_t HEADLESS_ACTIONS = 16;
+
+void headless_time_envs(size_t count, size_t threads, size_t max_ticks) {
+  envs_t *envs = envs_init(count, MAP2, HEADLESS_ENVS_SEED, threads);
+  rng_t *rng = rng_init(HEADLESS_ENVS_SEED, 0);
+  float *observations =
+      malloc(count * envs_observation_size() * sizeof(float));
+  uint8_t *actions = malloc(count * 2 * sizeof(uint8_t));
+  bool *dones = malloc(count * sizeof(bool));
+  assert(observations != NULL);
+  assert(actions != NULL);
+  assert(dones != NULL);
+
+  // Inputs are drawn before the clock starts, so only stepping is timed
+  size_t done_count = 0;
+  double elapsed = 0;
+  for (size_t tick = 0; tick < max_ticks; tick++) {
+    for (size_t i = 0; i < count * 2; i++) {
+      actions[i] = rng_below(rng, HEADLESS_ACTIONS);
+    }
+    double start = runtime_now();
+    envs_step(envs, actions, observations, dones);
+    elapsed += runtime_now() - start;
+    for (size_t i = 0; i < count; i++) {
+      done_count += dones[i];
+    }
+  }
+
+  double steps_per_s = elapsed > 0 ? count * max_ticks / elapsed : 0;
+  printf("headless: %zu envs on %zu threads, %zu ticks in %.3f s, "
+         "%.0f env-steps/s, %zu matches finished\n",
+         count, threads, max_ticks, elapsed, steps_per_s, done_count);
+  free(observations);
+  free(actions);
+  free(dones);
+  rng_free(rng);
+  envs_free(envs);
+}
+
+int main() {
+  size_t max_ticks = runtime_env("HEADLESS_TICKS", DEFAULT_HEADLESS_TICKS);
+  size_t env_count = runtime_env("HEADLESS_ENVS", 0);
+  if (env_count > 0) {
+    headless_time_envs(env_count, runtime_env("HEADLESS_THREADS", 1),
+                       max_ticks);
+    return 0;
+  }
+
+  state_t *state = emscripten_init();
+  double start = runtime_now();
+  size_t ticks = 0;
+  while (ticks < max_ticks) {
+    emscripten_main(state);
+    ticks++;
+    if (sdl_is_done((void *)state)) {
+      break;
+    }
+  }
+  double elapsed = runtime_now() - start;
+  emscripten_free(state);
+
+  double ticks_per_s = elapsed > 0 ? ticks / elapsed : 0;
+  printf("headless: %zu ticks in %.3f s, %.0f ticks/s (%.1fx real time)\n",
+         ticks, elapsed, ticks_per_s, ticks_per_s * RUNTIME_TICK_DT);
+  return 0;
+}
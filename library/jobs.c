@@ -0,0 +1,227 @@
+#include "jobs.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// Chunks handed out per thread, so threads that finish early can steal
+const size_t CHUNKS_PER_THREAD = 4;
+
+typedef struct job {
+  job_func_t func;
+  void *aux;
+  size_t begin;
+  size_t end;
+} job_t;
+
+/** A thread's chunks: the owner pops the back, thieves take the front */
+typedef struct job_queue {
+  pthread_mutex_t lock;
+  job_t *jobs;
+  size_t front;
+  size_t back;
+  size_t capacity;
+} job_queue_t;
+
+typedef struct worker {
+  jobs_t *jobs;
+  size_t index;
+} worker_t;
+
+typedef struct jobs {
+  size_t threads;
+  pthread_t *thread_ids;
+  worker_t *workers;
+  job_queue_t *queues;
+
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  size_t batch;
+  size_t pending;
+  bool stopping;
+} jobs_t;
+
+bool job_queue_pop(job_queue_t *queue, job_t *job) {
+  pthread_mutex_lock(&queue->lock);
+  bool found = queue->back > queue->front;
+  if (found) {
+    queue->back--;
+    *job = queue->jobs[queue->back];
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+bool job_queue_steal(job_queue_t *queue, job_t *job) {
+  pthread_mutex_lock(&queue->lock);
+  bool found = queue->back > queue->front;
+  if (found) {
+    *job = queue->jobs[queue->front];
+    queue->front++;
+  }
+  pthread_mutex_unlock(&queue->lock);
+  return found;
+}
+
+/** Takes a chunk from the thread's own queue, or steals one */
+bool jobs_take(jobs_t *jobs, size_t index, job_t *job) {
+  if (job_queue_pop(&jobs->queues[index], job)) {
+    return true;
+  }
+  for (size_t i = 1; i < jobs->threads; i++) {
+    if (job_queue_steal(&jobs->queues[(index + i) % jobs->threads], job)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/** Runs chunks until none are left to take */
+void jobs_run(jobs_t *jobs, size_t index) {
+  job_t job;
+  while (jobs_take(jobs, index, &job)) {
+    job.func(job.aux, job.begin, job.end);
+    pthread_mutex_lock(&jobs->lock);
+    jobs->pending--;
+    if (jobs->pending == 0) {
+      pthread_cond_signal(&jobs->done);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+  }
+}
+
+void *jobs_worker(void *void_worker) {
+  worker_t *worker = void_worker;
+  jobs_t *jobs = worker->jobs;
+  size_t seen_batch = 0;
+
+  pthread_mutex_lock(&jobs->lock);
+  while (true) {
+    while (!jobs->stopping && jobs->batch == seen_batch) {
+      pthread_cond_wait(&jobs->wake, &jobs->lock);
+    }
+    if (jobs->stopping) {
+      break;
+    }
+    seen_batch = jobs->batch;
+    pthread_mutex_unlock(&jobs->lock);
+    jobs_run(jobs, worker->index);
+    pthread_mutex_lock(&jobs->lock);
+  }
+  pthread_mutex_unlock(&jobs->lock);
+  return NULL;
+}
+
+jobs_t *jobs_init(size_t threads) {
+  assert(threads >= 1);
+  jobs_t *jobs = malloc(sizeof(jobs_t));
+  assert(jobs != NULL);
+  *jobs = (jobs_t){.threads = threads,
+                   .thread_ids = malloc(threads * sizeof(pthread_t)),
+                   .workers = malloc(threads * sizeof(worker_t)),
+                   .queues = malloc(threads * sizeof(job_queue_t)),
+                   .batch = 0,
+                   .pending = 0,
+                   .stopping = false};
+  assert(jobs->thread_ids != NULL);
+  assert(jobs->workers != NULL);
+  assert(jobs->queues != NULL);
+  pthread_mutex_init(&jobs->lock, NULL);
+  pthread_cond_init(&jobs->wake, NULL);
+  pthread_cond_init(&jobs->done, NULL);
+
+  for (size_t i = 0; i < threads; i++) {
+    jobs->queues[i] = (job_queue_t){
+        .jobs = NULL, .front = 0, .back = 0, .capacity = 0};
+    pthread_mutex_init(&jobs->queues[i].lock, NULL);
+    jobs->workers[i] = (worker_t){.jobs = jobs, .index = i};
+  }
+  // Thread 0 is whoever calls jobs_parallel_for()
+  for (size_t i = 1; i < threads; i++) {
+    int error = pthread_create(&jobs->thread_ids[i], NULL, jobs_worker,
+                               &jobs->workers[i]);
+    assert(error == 0);
+  }
+  return jobs;
+}
+
+void jobs_free(jobs_t *jobs) {
+  pthread_mutex_lock(&jobs->lock);
+  jobs->stopping = true;
+  pthread_cond_broadcast(&jobs->wake);
+  pthread_mutex_unlock(&jobs->lock);
+  for (size_t i = 1; i < jobs->threads; i++) {
+    pthread_join(jobs->thread_ids[i], NULL);
+  }
+
+  for (size_t i = 0; i < jobs->threads; i++) {
+    pthread_mutex_destroy(&jobs->queues[i].lock);
+    free(jobs->queues[i].jobs);
+  }
+  pthread_mutex_destroy(&jobs->lock);
+  pthread_cond_destroy(&jobs->wake);
+  pthread_cond_destroy(&jobs->done);
+  free(jobs->thread_ids);
+  free(jobs->workers);
+  free(jobs->queues);
+  free(jobs);
+}
+
+size_t jobs_threads(jobs_t *jobs) { return jobs->threads; }
+
+void jobs_parallel_for(jobs_t *jobs, size_t count, size_t grain,
+                       job_func_t func, void *aux) {
+  if (grain == 0) {
+    grain = 1;
+  }
+  if (jobs == NULL || jobs->threads == 1 || count <= grain) {
+    func(aux, 0, count);
+    return;
+  }
+
+  size_t chunks = jobs->threads * CHUNKS_PER_THREAD;
+  if (chunks > count / grain) {
+    chunks = count / grain;
+  }
+  size_t per_queue = (chunks + jobs->threads - 1) / jobs->threads;
+
+  // Count the chunks before any is visible, since a worker still leaving
+  // the previous loop may pick one up straight away
+  pthread_mutex_lock(&jobs->lock);
+  jobs->pending = chunks;
+  pthread_mutex_unlock(&jobs->lock);
+
+  for (size_t i = 0; i < jobs->threads; i++) {
+    job_queue_t *queue = &jobs->queues[i];
+    pthread_mutex_lock(&queue->lock);
+    if (queue->capacity < per_queue) {
+      queue->jobs = realloc(queue->jobs, per_queue * sizeof(job_t));
+      assert(queue->jobs != NULL);
+      queue->capacity = per_queue;
+    }
+    queue->front = 0;
+    queue->back = 0;
+    for (size_t c = i; c < chunks; c += jobs->threads) {
+      queue->jobs[queue->back] = (job_t){.func = func,
+                                         .aux = aux,
+                                         .begin = count * c / chunks,
+                                         .end = count * (c + 1) / chunks};
+      queue->back++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+  }
+
+  pthread_mutex_lock(&jobs->lock);
+  jobs->batch++;
+  pthread_cond_broadcast(&jobs->wake);
+  pthread_mutex_unlock(&jobs->lock);
+
+  jobs_run(jobs, 0);
+
+  pthread_mutex_lock(&jobs->lock);
+  while (jobs->pending > 0) {
+    pthread_cond_wait(&jobs->done, &jobs->lock);
+  }
+  pthread_mutex_unlock(&jobs->lock);
+}
@@ -1,7 +1,9 @@
 #include "list.h"
+#include "arena.h"
 #include "vector.h"
 #include <assert.h>
 #include <math.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -10,49 +12,67 @@ typedef struct list {
   size_t capacity;
   size_t size;
   free_func_t free_func;
+  arena_t *arena;
 } list_t;
 
 typedef void (*free_func_t)(void *);
 
-list_t *list_init(size_t initial_size, free_func_t freer) {
-  list_t *list = malloc(sizeof(list_t));
-  assert(list != NULL);
+/** Allocates from arena when there is one and from the heap otherwise */
+void *list_alloc(arena_t *arena, size_t size) {
+  void *memory = arena != NULL ? arena_alloc(arena, size) : malloc(size);
+  assert(memory != NULL);
+  return memory;
+}
+
+list_t *list_init_arena(arena_t *arena, size_t initial_size,
+                        free_func_t freer) {
+  list_t *list = list_alloc(arena, sizeof(list_t));
   list->free_func = freer;
+  list->arena = arena;
   if (initial_size == 0) {
     initial_size = 1;
   }
   list->capacity = initial_size;
   list->size = 0;
-  list->array = malloc(list->capacity * sizeof(void **));
-  assert(list->array != NULL);
+  list->array = list_alloc(arena, list->capacity * sizeof(void **));
   return list;
 }
 
-list_t *rect_init(double width, double height) {
+list_t *list_init(size_t initial_size, free_func_t freer) {
+  return list_init_arena(NULL, initial_size, freer);
+}
+
+list_t *rect_init_arena(arena_t *arena, double width, double height) {
+  // Arena vertices die with the arena, so the list must not free them
+  list_t *rect = list_init_arena(arena, 4, arena != NULL ? NULL : free);
+  for (size_t i = 0; i < 4; i++) {
+    list_add(rect, list_alloc(arena, sizeof(vector_t)));
+  }
+  rect_set(rect, width, height);
+  return rect;
+}
+
+void rect_set(list_t *rect, double width, double height) {
+  assert(rect->size == 4);
   vector_t half_width = {.x = width / 2, .y = 0.0},
            half_height = {.x = 0.0, .y = height / 2};
-  list_t *rect = list_init(4, free);
-  vector_t *v = malloc(sizeof(*v));
-  *v = vec_subtract(half_height, half_width);
-  list_add(rect, v);
-  v = malloc(sizeof(*v));
-  *v = vec_subtract(vec_negate(half_width), half_height);
-  list_add(rect, v);
-  v = malloc(sizeof(*v));
-  *v = vec_subtract(half_width, half_height);
-  list_add(rect, v);
-  v = malloc(sizeof(*v));
-  *v = vec_add(half_width, half_height);
-  list_add(rect, v);
-  return rect;
+  *(vector_t *)rect->array[0] = vec_subtract(half_height, half_width);
+  *(vector_t *)rect->array[1] =
+      vec_subtract(vec_negate(half_width), half_height);
+  *(vector_t *)rect->array[2] = vec_subtract(half_width, half_height);
+  *(vector_t *)rect->array[3] = vec_add(half_width, half_height);
 }
 
-list_t *circle_init(double radius, size_t points) {
-  list_t *circle = list_init(points, free);
+list_t *rect_init(double width, double height) {
+  return rect_init_arena(NULL, width, height);
+}
+
+list_t *circle_init_arena(arena_t *arena, double radius, size_t points) {
+  list_t *circle = list_init_arena(arena, points, arena != NULL ? NULL : free);
   double arc_angle = 2 * M_PI / points;
   vector_t point = {.x = radius, .y = 0.0};
   for (size_t i = 0; i < points; i++) {
-    vector_t *v = malloc(sizeof(*v));
+    vector_t *v = list_alloc(arena, sizeof(*v));
     *v = point;
     list_add(circle, v);
     point = vec_rotate(point, arc_angle);
@@ -60,6 +80,10 @@ list_t *circle_init(double radius, size_t points) {
   return circle;
 }
 
+list_t *circle_init(double radius, size_t points) {
+  return circle_init_arena(NULL, radius, points);
+}
+
 list_t *polygon_init(double radius, size_t num_of_points) {
   list_t *polygon = list_init(num_of_points, free);
   double arc_angle = 2 * M_PI / num_of_points;
@@ -79,6 +103,11 @@ void list_free(list_t *list) {
       list->free_func(list->array[i]);
     }
   }
+  if (list->arena != NULL) {
+    arena_release(list->arena, list->array, list->capacity * sizeof(void *));
+    arena_release(list->arena, list, sizeof(list_t));
+    return;
+  }
   free(list->array);
   free(list);
 }
@@ -86,13 +115,20 @@ void list_free(list_t *list) {
 void list_resize(list_t *list) {
   if (list->size >= list->capacity) {
 
-    void **new_array = malloc(list->capacity * 2 * sizeof(void *));
+    void **new_array =
+        list_alloc(list->arena, list->capacity * 2 * sizeof(void *));
     for (size_t i = 0; i < list->size; i += 1) {
       void *old = list_get(list, i);
       new_array[i] = old;
     }
 
-    free(list->array);
+    // Arena arrays go back to the arena for the next list that grows this big
+    if (list->arena == NULL) {
+      free(list->array);
+    } else {
+      arena_release(list->arena, list->array,
+                    list->capacity * sizeof(void *));
+    }
     list->array = new_array;
     list->capacity *= 2;
   }
@@ -118,6 +154,45 @@ void *list_remove(list_t *list, size_t index) {
   return temp;
 }
 
+void *list_swap_remove(list_t *list, size_t index) {
+  assert(index < list->size);
+
+  // Order is not preserved: the last element fills the hole
+  void *temp = list->array[index];
+  list->size--;
+  list->array[index] = list->array[list->size];
+  return temp;
+}
+
+size_t list_remove_if(list_t *list, list_pred_t pred) {
+  // Single stable compaction pass: survivors slide down over removed slots
+  size_t kept = 0;
+  for (size_t i = 0; i < list->size; i++) {
+    void *elem = list->array[i];
+    if (pred(elem)) {
+      if (list->free_func != NULL) {
+        list->free_func(elem);
+      }
+      continue;
+    }
+    list->array[kept] = elem;
+    kept++;
+  }
+
+  size_t removed = list->size - kept;
+  list->size = kept;
+  return removed;
+}
+
+void list_clear(list_t *list) {
+  if (list->free_func != NULL) {
+    for (size_t i = 0; i < list->size; i++) {
+      list->free_func(list->array[i]);
+    }
+  }
+  list->size = 0;
+}
+
 void list_add(list_t *list, void *value) {
   assert(value != NULL);
   list_resize(list);
@@ -1,5 +1,7 @@
 #include "map.h"
+#include "arena.h"
 #include "game_const.h"
+#include "game_weapon.h"
 
 #include <assert.h>
 #include <math.h>
@@ -15,10 +17,11 @@ const double GRAVITY_CONST = 150; // m / s^2
 void add_gravity_body(scene_t *scene) {
   double GRAVITY_R = (sqrt(G * GRAVITY_M / GRAVITY_CONST));
 
-  list_t *gravity_player = rect_init(1, 1);
-  body_t *body =
-      body_init_with_info(gravity_player, GRAVITY_M, WALL_COLOR,
-                          info_init(GRAVITY, NO_SIDE, NO_WEAPON), free);
+  arena_t *arena = scene_get_arena(scene);
+  list_t *gravity_player = rect_init_arena(arena, 1, 1);
+  body_t *body = body_init_arena(
+      arena, gravity_player, GRAVITY_M, WALL_COLOR,
+      info_init_arena(arena, GRAVITY, NO_SIDE, NO_WEAPON), free);
 
   // Move a distance R below the scene
   vector_t gravity_center = {.x = MAX1.x / 2, .y = -GRAVITY_R};
@@ -28,19 +31,22 @@ void add_gravity_body(scene_t *scene) {
 
 // Menu
 void generate_menu(scene_t *scene) {
-  list_t *rect = rect_init(MAX_MENU.x, MAX_MENU.y);
-  body_t *body =
-      body_init_with_info(rect, INFINITY, BACKGROUND_COLOR,
-                          info_init(BACKGROUND, NO_SIDE, NO_WEAPON), free);
+  arena_t *arena = scene_get_arena(scene);
+  list_t *rect = rect_init_arena(arena, MAX_MENU.x, MAX_MENU.y);
+  body_t *body = body_init_arena(
+      arena, rect, INFINITY, BACKGROUND_COLOR,
+      info_init_arena(arena, BACKGROUND, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(body, (vector_t){.x = MAX_MENU.x / 2, .y = MAX_MENU.y / 2});
   scene_add_body(scene, body);
 }
 
 void add_platform(scene_t *scene, double width, double height, double mass,
-                  vector_t position, rgb_color_t color,
-                  body_info_t *body_info) {
-  list_t *rect = rect_init(width, height);
-  body_t *body = body_init_with_info(rect, mass, color, body_info, free);
+                  vector_t position, rgb_color_t color, body_type_t type) {
+  arena_t *arena = scene_get_arena(scene);
+  list_t *rect = rect_init_arena(arena, width, height);
+  body_t *body =
+      body_init_arena(arena, rect, mass, color,
+                      info_init_arena(arena, type, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(body, position);
   scene_add_body(scene, body);
 }
@@ -66,53 +72,50 @@ void generate_map1(scene_t *scene) {
   // Background
   add_platform(scene, MAX1.x, MAX1.y, INFINITY,
                (vector_t){.x = MAX1.x / 2, .y = MAX1.y / 2}, BACKGROUND_COLOR,
-               info_init(BACKGROUND, NO_SIDE, NO_WEAPON));
+               BACKGROUND);
 
   // Left wall]
   add_platform(scene, WALL_WIDTH, 2 * MAX1.y, INFINITY,
-               (vector_t){.x = 0.0, .y = 0.0}, WALL_COLOR,
-               info_init(WALL, NO_SIDE, NO_WEAPON));
+               (vector_t){.x = 0.0, .y = 0.0}, WALL_COLOR, WALL);
 
   // Left platform
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM1_X, .y = PLATFORM1_Y}, PLATFORM_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   // Right wall
 
   add_platform(scene, WALL_WIDTH, 2 * MAX1.y, INFINITY,
-               (vector_t){.x = MAX1.x, .y = 0.0}, WALL_COLOR,
-               info_init(WALL, NO_SIDE, NO_WEAPON));
+               (vector_t){.x = MAX1.x, .y = 0.0}, WALL_COLOR, WALL);
 
   // Right platform
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM2_X, .y = PLATFORM2_Y}, PLATFORM_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   // Ground (left)
   add_platform(scene, MAX1.x / 2, 2 * PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = MAX1.x / 4, .y = PLATFORM_WIDTH}, PLATFORM_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   // Ground (right)
   add_platform(scene, MAX1.x / 2, 2 * PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = 3 * MAX1.x / 4, .y = PLATFORM_WIDTH},
-               PLATFORM_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               PLATFORM_COLOR, GROUND);
 
   // Separating wall
   add_platform(scene, SEPARATING_WALL_WIDTH, SEPARATING_WALL_HEIGHT, INFINITY,
                (vector_t){.x = SEPARATING_WALL_X, .y = SEPARATING_WALL_Y},
-               WALL_COLOR, info_init(WALL, NO_SIDE, NO_WEAPON));
+               WALL_COLOR, WALL);
 
   // Ceiling
   add_platform(scene, MAX1.x, WALL_WIDTH, INFINITY,
-               (vector_t){.x = MAX1.x / 2.0, .y = MAX1.y}, WALL_COLOR,
-               info_init(WALL, NO_SIDE, NO_WEAPON));
+               (vector_t){.x = MAX1.x / 2.0, .y = MAX1.y}, WALL_COLOR, WALL);
 
   // Central platform
   add_platform(scene, PLATFORM3_LENGTH, 1.5 * WALL_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM3_X, .y = PLATFORM3_Y}, WALL_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 }
 
 /* -------------------- Map 2 ---------------------------------------
@@ -142,46 +145,47 @@ void generate_map2(scene_t *scene) {
   // Background
   add_platform(scene, MAX2.x, MAX2.y, INFINITY,
                (vector_t){.x = MAX2.x / 2, .y = MAX2.y / 2}, BACKGROUND_COLOR,
-               info_init(BACKGROUND, NO_SIDE, NO_WEAPON));
+               BACKGROUND);
 
   // Ground (left)
   add_platform(scene, 2 * MAX2.x / 3.0, GROUND_WIDTH, INFINITY,
                (vector_t){.x = 0.0, .y = GROUND_WIDTH / 25}, WALL_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   // Ground (right)
   add_platform(scene, 2 * MAX2.x / 3.0, GROUND_WIDTH, INFINITY,
                (vector_t){.x = MAX2.x, .y = GROUND_WIDTH / 25}, WALL_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   // Ceiling (left)
   add_platform(scene, 2 * MAX2.x / 3.0, WALL_WIDTH, INFINITY,
-               (vector_t){.x = MAX2.x / 6.0, .y = MAX2.y}, WALL_COLOR,
-               info_init(WALL, NO_SIDE, NO_WEAPON));
+               (vector_t){.x = MAX2.x / 6.0, .y = MAX2.y}, WALL_COLOR, WALL);
 
   // Ceiling (right)
   add_platform(scene, 2 * MAX2.x / 3.0, WALL_WIDTH, INFINITY,
                (vector_t){.x = MAX2.x * 5 / 6.0, .y = MAX2.y}, WALL_COLOR,
-               info_init(WALL, NO_SIDE, NO_WEAPON));
+               WALL);
 
   // Clock Background
-  list_t *rect = circle_init(MAX2.x / 5.5, CIRCLE_POINTS);
-  body_t *body =
-      body_init_with_info(rect, INFINITY, ((rgb_color_t){0.0, 0.0, 0.0}),
-                          info_init(CLOCK, NO_SIDE, NO_WEAPON), free);
+  arena_t *arena = scene_get_arena(scene);
+  list_t *rect = circle_init_arena(arena, MAX2.x / 5.5, CIRCLE_POINTS);
+  body_t *body = body_init_arena(
+      arena, rect, INFINITY, ((rgb_color_t){0.0, 0.0, 0.0}),
+      info_init_arena(arena, CLOCK, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(body, (vector_t){.x = MAX2.x / 2.0, .y = MAX2.y / 2.0});
   scene_add_body(scene, body);
-  rect = circle_init(MAX2.x / 5.7, CIRCLE_POINTS);
-  body = body_init_with_info(rect, INFINITY, CLOCK_BACKGROUND_COLOR,
-                             info_init(CLOCK, NO_SIDE, NO_WEAPON), free);
+  rect = circle_init_arena(arena, MAX2.x / 5.7, CIRCLE_POINTS);
+  body = body_init_arena(arena, rect, INFINITY, CLOCK_BACKGROUND_COLOR,
+                         info_init_arena(arena, CLOCK, NO_SIDE, NO_WEAPON),
+                         free);
   body_set_centroid(body, (vector_t){.x = MAX2.x / 2.0, .y = MAX2.y / 2.0});
   scene_add_body(scene, body);
 
   // Clock big arm
-  rect = rect_init(MAX2.x / 6.0, WALL_WIDTH);
-  body =
-      body_init_with_info(rect, INFINITY, ((rgb_color_t){0, 0, 0}),
-                          info_init(CLOCK_BIG_ARM, NO_SIDE, NO_WEAPON), free);
+  rect = rect_init_arena(arena, MAX2.x / 6.0, WALL_WIDTH);
+  body = body_init_arena(
+      arena, rect, INFINITY, ((rgb_color_t){0, 0, 0}),
+      info_init_arena(arena, CLOCK_BIG_ARM, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(
       body, (vector_t){.x = MAX2.x / 2.0 - MAX2.x / 12.0, .y = MAX2.y / 2.0});
   body_set_rot_velocity(body, 0.001);
@@ -190,10 +194,10 @@ void generate_map2(scene_t *scene) {
   scene_add_body(scene, body);
 
   // Clock small arm
-  rect = rect_init(MAX2.x / 8.0, WALL_WIDTH / 2);
-  body =
-      body_init_with_info(rect, INFINITY, ((rgb_color_t){1, 0, 0}),
-                          info_init(CLOCK_SMALL_ARM, NO_SIDE, NO_WEAPON), free);
+  rect = rect_init_arena(arena, MAX2.x / 8.0, WALL_WIDTH / 2);
+  body = body_init_arena(
+      arena, rect, INFINITY, ((rgb_color_t){1, 0, 0}),
+      info_init_arena(arena, CLOCK_SMALL_ARM, NO_SIDE, NO_WEAPON), free);
   body_set_centroid(
       body, (vector_t){.x = MAX2.x / 2.0 - MAX2.x / 16, .y = MAX2.y / 2.0});
   body_set_rot_velocity(body, 0.01);
@@ -204,46 +208,46 @@ void generate_map2(scene_t *scene) {
   // Right platforms
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM2_X, .y = PLATFORM2_Y}, PLATFORM_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM2_X, .y = PLATFORM2_Y + MAX2.y / 3},
-               PLATFORM_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               PLATFORM_COLOR, GROUND);
 
   // Left platforms
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM1_X, .y = PLATFORM1_Y}, PLATFORM_COLOR,
-               info_init(GROUND, NO_SIDE, NO_WEAPON));
+               GROUND);
 
   add_platform(scene, PLATFORM_LENGTH, PLATFORM_WIDTH, INFINITY,
                (vector_t){.x = PLATFORM1_X, .y = PLATFORM1_Y + MAX2.y / 3},
-               PLATFORM_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               PLATFORM_COLOR, GROUND);
 
   // Teleporter Platforms Left
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER1_X, .y = TELEPORTER1_Y},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER1_X, .y = MAX2.y / 2},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER1_X, .y = MAX2.y - TELEPORTER1_Y},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 
   // Teleporter Platforms Right
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER2_X, .y = TELEPORTER2_Y},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER2_X, .y = MAX2.y / 2},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 
   add_platform(scene, TELEPORTER_LENGTH, TELEPORTER_WIDTH, INFINITY,
                (vector_t){.x = TELEPORTER2_X, .y = MAX2.y - TELEPORTER2_Y},
-               TELEPORTER_COLOR, info_init(GROUND, NO_SIDE, NO_WEAPON));
+               TELEPORTER_COLOR, GROUND);
 }
 
 //-----------------------------------------------------
@@ -266,6 +270,7 @@ void create_map(scene_t *scene, game_state_t game_state) {
     list_t *players_list = list_init(2, (free_func_t)body_free);
 
     add_gravity_body(scene);
+    game_weapon_pools_init(scene);
 
     if (game_state == MAP1) {
       generate_map1(scene);
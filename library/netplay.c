@@ -0,0 +1,233 @@
+#include "rng.h"
+#include "rollback.h"
+#include "runtime.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Plays one side of a rollback match against another process over UDP,
+ * with bots holding random inputs. Start two copies on the same machine,
+ * one with NETPLAY_PLAYER=0 and one with NETPLAY_PLAYER=1; each prints the
+ * hash of the final tick, which must match, and its rollback costs. Like
+ * headless.c, it runs with sdl_headless.c and without a display.
+ *
+ * NETPLAY_PORT and NETPLAY_PEER_PORT set the loopback ports each side
+ * listens on (defaults 7000 + player and 7000 + other player).
+ * NETPLAY_LATENCY_MS and NETPLAY_LOSS add one-way delay and a fraction of
+ * packets dropped on send. NETPLAY_TICKS, NETPLAY_DELAY, NETPLAY_ROLLBACK
+ * and NETPLAY_SEED set the match length, input delay, maximum rollback and
+ * match seed.
+ */
+
+const uint16_t NETPLAY_BASE_PORT = 7000;
+const uint32_t NETPLAY_MAGIC = 0x4b425452;
+// Inputs resent in every packet, so one that is lost arrives with the next
+#define NETPLAY_REDUNDANCY 32
+// Packets held back to simulate latency
+#define NETPLAY_QUEUE_SIZE 256
+// How long to keep sending once the match is over, so the other side can
+// finish too
+const double NETPLAY_LINGER = 2.0;
+// Ticks between bot input changes, on average
+const uint32_t NETPLAY_BOT_PERIOD = 8;
+
+typedef struct packet {
+  uint32_t magic;
+  // The first tick the sender is still missing an input for
+  uint32_t ack;
+  uint32_t first_tick;
+  uint8_t count;
+  uint8_t inputs[NETPLAY_REDUNDANCY];
+} packet_t;
+
+typedef struct delayed_packet {
+  double due;
+  packet_t packet;
+} delayed_packet_t;
+
+typedef struct netplay {
+  int socket;
+  struct sockaddr_in peer;
+  double latency;
+  double loss;
+  rng_t *rng;
+  delayed_packet_t queue[NETPLAY_QUEUE_SIZE];
+  size_t queue_size;
+  // Every input this side has scheduled, by tick
+  uint8_t *inputs;
+  size_t inputs_size;
+  size_t peer_ack;
+} netplay_t;
+
+int netplay_open(uint16_t port) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  struct sockaddr_in address = {.sin_family = AF_INET,
+                                .sin_port = htons(port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  struct timeval timeout = {.tv_sec = 0, .tv_usec = 1000};
+  setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+/** Queues every input the peer has not acknowledged, dropping some */
+void netplay_send(netplay_t *net, size_t ack, size_t end_tick) {
+  size_t first = net->peer_ack;
+  if (end_tick > NETPLAY_REDUNDANCY && first < end_tick - NETPLAY_REDUNDANCY) {
+    first = end_tick - NETPLAY_REDUNDANCY;
+  }
+  if (first >= end_tick || rng_double(net->rng) < net->loss ||
+      net->queue_size == NETPLAY_QUEUE_SIZE) {
+    return;
+  }
+  delayed_packet_t *delayed = &net->queue[net->queue_size++];
+  delayed->due = runtime_now() + net->latency;
+  // The whole packet is sent, so its padding is zeroed rather than left
+  // holding whatever the queue slot did before
+  packet_t *packet = &delayed->packet;
+  memset(packet, 0, sizeof(*packet));
+  packet->magic = NETPLAY_MAGIC;
+  packet->ack = ack;
+  packet->first_tick = first;
+  packet->count = end_tick - first;
+  memcpy(packet->inputs, &net->inputs[first], end_tick - first);
+}
+
+/** Sends every queued packet whose delay has passed */
+void netplay_flush(netplay_t *net) {
+  double now = runtime_now();
+  size_t kept = 0;
+  for (size_t i = 0; i < net->queue_size; i++) {
+    if (net->queue[i].due > now) {
+      net->queue[kept++] = net->queue[i];
+      continue;
+    }
+    sendto(net->socket, &net->queue[i].packet, sizeof(packet_t), 0,
+           (struct sockaddr *)&net->peer, sizeof(net->peer));
+  }
+  net->queue_size = kept;
+}
+
+void netplay_receive(netplay_t *net, rollback_t *rollback) {
+  packet_t packet;
+  while (recv(net->socket, &packet, sizeof(packet), MSG_DONTWAIT) ==
+         sizeof(packet)) {
+    if (packet.magic != NETPLAY_MAGIC || packet.count > NETPLAY_REDUNDANCY) {
+      continue;
+    }
+    if (packet.ack > net->peer_ack) {
+      net->peer_ack = packet.ack;
+    }
+    for (size_t i = 0; i < packet.count; i++) {
+      rollback_add_remote_input(rollback, packet.first_tick + i,
+                                packet.inputs[i]);
+    }
+  }
+}
+
+int main() {
+  size_t player = runtime_env("NETPLAY_PLAYER", 0);
+  size_t ticks = runtime_env("NETPLAY_TICKS", 1800);
+  size_t delay = runtime_env("NETPLAY_DELAY", 2);
+  size_t max_rollback = runtime_env("NETPLAY_ROLLBACK", 8);
+  uint64_t seed = runtime_env("NETPLAY_SEED", 1);
+  uint16_t port = runtime_env("NETPLAY_PORT", NETPLAY_BASE_PORT + player);
+  uint16_t peer_port =
+      runtime_env("NETPLAY_PEER_PORT", NETPLAY_BASE_PORT + 1 - player);
+  if (player > 1) {
+    fprintf(stderr, "netplay: NETPLAY_PLAYER must be 0 or 1\n");
+    return 1;
+  }
+
+  netplay_t net = {
+      .socket = netplay_open(port),
+      .peer = {.sin_family = AF_INET,
+               .sin_port = htons(peer_port),
+               .sin_addr.s_addr = htonl(INADDR_LOOPBACK)},
+      .latency = runtime_env_double("NETPLAY_LATENCY_MS", 0) / 1000,
+      .loss = runtime_env_double("NETPLAY_LOSS", 0),
+      .rng = rng_init(seed, player + 1),
+      .queue_size = 0,
+      .inputs_size = ticks + delay,
+      .inputs = calloc(ticks + delay, sizeof(uint8_t)),
+      .peer_ack = 0};
+  if (net.socket < 0) {
+    fprintf(stderr, "netplay: cannot listen on port %u: %s\n", port,
+            strerror(errno));
+    return 1;
+  }
+
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  rollback_t *rollback = rollback_init(MAP2, seed, player, delay, max_rollback);
+  uint8_t actions = 0;
+  size_t scheduled = delay;
+  double longest_frame = 0;
+  double next_frame = runtime_now();
+  double linger_until = 0;
+  while (true) {
+    double frame_start = runtime_now();
+    netplay_receive(&net, rollback);
+
+    if (rollback_get_tick(rollback) < ticks) {
+      if (rng_below(net.rng, NETPLAY_BOT_PERIOD) == 0) {
+        actions = rng_below(net.rng, 16);
+      }
+      size_t tick = rollback_add_local_input(rollback, actions);
+      if (tick == scheduled && tick < net.inputs_size) {
+        net.inputs[tick] = actions;
+        scheduled++;
+      }
+      rollback_advance(rollback, RUNTIME_TICK_DT);
+    }
+    size_t confirmed = rollback_get_confirmed_tick(rollback);
+    size_t sent_end = scheduled < ticks ? scheduled : ticks;
+    netplay_send(&net, confirmed, sent_end);
+    netplay_flush(&net);
+
+    double frame_time = runtime_now() - frame_start;
+    if (frame_time > longest_frame) {
+      longest_frame = frame_time;
+    }
+    bool is_done = rollback_get_tick(rollback) >= ticks && confirmed >= ticks;
+    if (is_done && linger_until == 0) {
+      linger_until = runtime_now() + NETPLAY_LINGER;
+    }
+    if (is_done && (net.peer_ack >= ticks || runtime_now() > linger_until)) {
+      break;
+    }
+
+    next_frame += RUNTIME_TICK_DT;
+    double wait = next_frame - runtime_now();
+    if (wait > 0) {
+      struct timespec sleep = {.tv_sec = 0, .tv_nsec = wait * 1e9};
+      nanosleep(&sleep, NULL);
+    }
+  }
+
+  rollback_sync(rollback, RUNTIME_TICK_DT);
+  printf("netplay: player %zu, tick %zu hash %016llx\n", player + 1,
+         rollback_get_tick(rollback),
+         (unsigned long long)match_hash(rollback_get_state(rollback)));
+  rollback_print_stats(rollback);
+  printf("netplay: longest frame %.3f ms of a %.3f ms budget\n",
+         longest_frame * 1e3, RUNTIME_TICK_DT * 1e3);
+
+  rollback_free(rollback);
+  rng_free(net.rng);
+  free(net.inputs);
+  close(net.socket);
+  return 0;
+}
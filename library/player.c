@@ -1,6 +1,9 @@
 #include "player.h"
+#include "arena.h"
 #include "game_const.h"
 
+#include <assert.h>
+
 const double PLAYER_WIDTH = 6.0;
 const double PLAYER_HEIGHT = 9.0;
 const vector_t START_VELOCITY = {.x = 0.0, .y = 15.0};
@@ -10,27 +13,41 @@ const double PLAYER_DRAG = 0.5;
 const double WALL_ELASTICITY = 0.5;
 const double GROUND_ELASTICITY = 0.0;
 
-body_info_t *info_init(body_type_t type, side_t side,
-                       game_weapon_type_t weapon) {
-  body_info_t *info = malloc(sizeof(body_info_t));
+body_info_t *info_init_arena(arena_t *arena, body_type_t type, side_t side,
+                             game_weapon_type_t weapon) {
+  body_info_t *info = arena != NULL ? arena_alloc(arena, sizeof(body_info_t))
+                                    : malloc(sizeof(body_info_t));
+  assert(info != NULL);
+  info_reset(info, type, side, weapon);
+  return info;
+}
+
+void info_reset(body_info_t *info, body_type_t type, side_t side,
+                game_weapon_type_t weapon) {
   info->type = type;
   info->side = side;
   info->weapon_type = weapon;
   info->time_since_last_shot = 0;
   info->shots_left = INFINITY;
-  return info;
+}
+
+body_info_t *info_init(body_type_t type, side_t side,
+                       game_weapon_type_t weapon) {
+  return info_init_arena(NULL, type, side, weapon);
 }
 
 body_info_t *get_info(body_t *body) {
   return (body_info_t *)body_get_info(body);
 }
 
-body_t *get_player(vector_t center, vector_t velocity, body_type_t type,
-                   side_t dir) {
-  list_t *shape = rect_init(PLAYER_WIDTH, PLAYER_HEIGHT);
+body_t *get_player(scene_t *scene, vector_t center, vector_t velocity,
+                   body_type_t type, side_t dir) {
+  arena_t *arena = scene_get_arena(scene);
+  list_t *shape = rect_init_arena(arena, PLAYER_WIDTH, PLAYER_HEIGHT);
   rgb_color_t color = type == PLAYER1 ? PLAYER_1_COLOR : PLAYER_2_COLOR;
-  body_t *player = body_init_with_info(shape, PLAYER_MASS, color,
-                                       info_init(type, dir, PISTOL), free);
+  body_t *player =
+      body_init_arena(arena, shape, PLAYER_MASS, color,
+                      info_init_arena(arena, type, dir, PISTOL), free);
 
   body_set_centroid(player, center);
 
@@ -42,14 +59,14 @@ body_t *add_player(scene_t *scene, body_type_t type, vector_t spawn) {
   // Add the player to the scene.
   body_t *player;
   if (type == PLAYER1) {
-    player = get_player(spawn, START_VELOCITY, type, RIGHT);
+    player = get_player(scene, spawn, START_VELOCITY, type, RIGHT);
   } else {
-    player = get_player(spawn, START_VELOCITY, type, LEFT);
+    player = get_player(scene, spawn, START_VELOCITY, type, LEFT);
   }
 
-  create_drag(scene, PLAYER_DRAG, player);
   size_t body_count = scene_bodies(scene);
   scene_add_body(scene, player);
+  create_drag(scene, PLAYER_DRAG, player);
 
   // Add force creators with other bodies
   for (size_t i = 0; i < body_count; i++) {
@@ -91,30 +108,20 @@ body_t *get_player_feet(body_t *player) {
   return player_feet;
 }
 
+/** Returns a handle to the first body of the specified type */
+body_handle_t fetch_handle(scene_t *scene, body_type_t body_type) {
+  body_t *body = scene_first_of_type(scene, body_type);
+  return body != NULL ? body_get_handle(body) : BODY_HANDLE_NONE;
+}
+
 /** Returns pointer to specified player */
 body_t *fetch_object(scene_t *scene, body_type_t body_type) {
-  body_t *obj = NULL;
-  for (size_t i = 0; i < scene_bodies(scene); i++) {
-    if (get_info(scene_get_body(scene, i))->type == body_type) {
-      obj = scene_get_body(scene, i);
-      break;
-    }
-  }
-  return obj;
+  return scene_first_of_type(scene, body_type);
 }
 
 /** Returns pointer to specified body_type
  * Undefined behavior when there are multiple bodies of the same type in scene
  */
 sprite_t *fetch_sprite(scene_t *scene, body_type_t body_type) {
-  sprite_t *obj = NULL;
-  size_t sprites_size = list_size(scene_get_sprites(scene));
-  for (size_t i = 0; i < sprites_size; i++) {
-    sprite_t *sprite = scene_get_sprite(scene, i);
-    if (get_info(sprite_get_body(sprite))->type == body_type) {
-      obj = sprite;
-      break;
-    }
-  }
-  return obj;
+  return scene_first_sprite_of_type(scene, body_type);
 }
\ No newline at end of file
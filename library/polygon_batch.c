@@ -0,0 +1,109 @@
+#include "polygon_batch.h"
+#include <SDL2/SDL2_gfxPrimitives.h>
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t POLYGON_BATCH_INITIAL_VERTICES = 256;
+
+typedef struct polygon_batch {
+  SDL_Renderer *renderer;
+  SDL_Vertex *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+  // Three per triangle
+  int *indices;
+  size_t index_count;
+  size_t index_capacity;
+  // Where the polygon being added starts in vertices
+  size_t polygon_start;
+  SDL_Color color;
+  size_t draw_calls;
+} polygon_batch_t;
+
+polygon_batch_t *polygon_batch_init(SDL_Renderer *renderer) {
+  polygon_batch_t *batch = malloc(sizeof(polygon_batch_t));
+  assert(batch != NULL);
+  size_t capacity = POLYGON_BATCH_INITIAL_VERTICES;
+  *batch = (polygon_batch_t){
+      .renderer = renderer,
+      .vertices = malloc(capacity * sizeof(SDL_Vertex)),
+      .vertex_count = 0,
+      .vertex_capacity = capacity,
+      // A polygon of n vertices makes n - 2 triangles
+      .indices = malloc(3 * capacity * sizeof(int)),
+      .index_count = 0,
+      .index_capacity = 3 * capacity,
+      .polygon_start = 0,
+      .color = {.r = 0, .g = 0, .b = 0, .a = 255},
+      .draw_calls = 0};
+  assert(batch->vertices != NULL && batch->indices != NULL);
+  return batch;
+}
+
+void polygon_batch_free(polygon_batch_t *batch) {
+  free(batch->vertices);
+  free(batch->indices);
+  free(batch);
+}
+
+void polygon_batch_start(polygon_batch_t *batch, SDL_Color color) {
+  batch->polygon_start = batch->vertex_count;
+  batch->color = color;
+}
+
+void polygon_batch_add_vertex(polygon_batch_t *batch, SDL_FPoint point) {
+  if (batch->vertex_count == batch->vertex_capacity) {
+    batch->vertex_capacity *= 2;
+    batch->vertices = realloc(batch->vertices,
+                              batch->vertex_capacity * sizeof(SDL_Vertex));
+    assert(batch->vertices != NULL);
+  }
+  if (batch->index_count + 3 > batch->index_capacity) {
+    batch->index_capacity *= 2;
+    batch->indices =
+        realloc(batch->indices, batch->index_capacity * sizeof(int));
+    assert(batch->indices != NULL);
+  }
+  size_t index = batch->vertex_count++;
+  batch->vertices[index] = (SDL_Vertex){
+      .position = point, .color = batch->color, .tex_coord = {0, 0}};
+  // From the third vertex on, each one closes a triangle with the first
+  // vertex and the one before it
+  if (index >= batch->polygon_start + 2) {
+    batch->indices[batch->index_count++] = batch->polygon_start;
+    batch->indices[batch->index_count++] = index - 1;
+    batch->indices[batch->index_count++] = index;
+  }
+}
+
+void polygon_batch_flush(polygon_batch_t *batch) {
+  if (batch->index_count > 0) {
+    int result = SDL_RenderGeometry(batch->renderer, NULL, batch->vertices,
+                                    batch->vertex_count, batch->indices,
+                                    batch->index_count);
+    if (result == 0) {
+      batch->draw_calls++;
+    } else {
+      // Renderers without geometry support still fill triangles one by one
+      for (size_t i = 0; i < batch->index_count; i += 3) {
+        SDL_Vertex *a = &batch->vertices[batch->indices[i]];
+        SDL_Vertex *b = &batch->vertices[batch->indices[i + 1]];
+        SDL_Vertex *c = &batch->vertices[batch->indices[i + 2]];
+        filledTrigonRGBA(batch->renderer, a->position.x, a->position.y,
+                         b->position.x, b->position.y, c->position.x,
+                         c->position.y, a->color.r, a->color.g, a->color.b,
+                         a->color.a);
+        batch->draw_calls++;
+      }
+    }
+  }
+  batch->vertex_count = 0;
+  batch->index_count = 0;
+  batch->polygon_start = 0;
+}
+
+size_t polygon_batch_take_draw_calls(polygon_batch_t *batch) {
+  size_t draw_calls = batch->draw_calls;
+  batch->draw_calls = 0;
+  return draw_calls;
+}
@@ -0,0 +1,71 @@
+#include "pool.h"
+#include <assert.h>
+#include <stdlib.h>
+
+typedef struct pool {
+  void **objects;
+  size_t size;
+  size_t capacity;
+  size_t stocked;
+  size_t high_water;
+  size_t misses;
+  arena_t *arena;
+} pool_t;
+
+pool_t *pool_init(arena_t *arena, size_t capacity) {
+  pool_t *pool = arena != NULL ? arena_alloc(arena, sizeof(pool_t))
+                               : malloc(sizeof(pool_t));
+  assert(pool != NULL);
+  void **objects = arena != NULL ? arena_alloc(arena, capacity * sizeof(void *))
+                                 : malloc(capacity * sizeof(void *));
+  assert(objects != NULL);
+  *pool = (pool_t){.objects = objects,
+                   .size = 0,
+                   .capacity = capacity,
+                   .stocked = 0,
+                   .high_water = 0,
+                   .misses = 0,
+                   .arena = arena};
+  return pool;
+}
+
+void pool_free(pool_t *pool) {
+  if (pool->arena != NULL) {
+    return;
+  }
+  free(pool->objects);
+  free(pool);
+}
+
+void pool_put(pool_t *pool, void *object) {
+  assert(object != NULL);
+  assert(pool->size < pool->capacity);
+  pool->objects[pool->size] = object;
+  pool->size++;
+  // Objects beyond what was ever taken out are new stock
+  if (pool->size > pool->stocked) {
+    pool->stocked = pool->size;
+  }
+}
+
+void *pool_take(pool_t *pool) {
+  if (pool->size == 0) {
+    pool->misses++;
+    return NULL;
+  }
+
+  pool->size--;
+  size_t in_use = pool->stocked - pool->size;
+  if (in_use > pool->high_water) {
+    pool->high_water = in_use;
+  }
+  return pool->objects[pool->size];
+}
+
+size_t pool_capacity(pool_t *pool) { return pool->capacity; }
+
+size_t pool_in_use(pool_t *pool) { return pool->stocked - pool->size; }
+
+size_t pool_high_water(pool_t *pool) { return pool->high_water; }
+
+size_t pool_misses(pool_t *pool) { return pool->misses; }
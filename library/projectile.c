@@ -0,0 +1,700 @@
+#include "projectile.h"
+#include "game_const.h"
+#include "snapshot.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const double PROJECTILE_LENGTH = 3.0;
+const double SHOTGUN_RADIUS = 30.0;
+// Matches the distance clamp in calc_gravity()
+const double MIN_GRAVITY_DISTANCE = 5.0;
+// How far a bounced ricochet is pushed off the surface it hit
+const double BOUNCE_OFFSET = 1E-3;
+const size_t INITIAL_COLLIDERS = 32;
+const size_t INITIAL_VERTICES = 128;
+// How many of the surfaces it bounced off a ricochet remembers
+const size_t RICOCHET_SURFACES = 8;
+
+/** A convex body projectiles are swept against, copied once per tick */
+typedef struct collider {
+  body_t *body;
+  body_type_t type;
+  size_t first_vertex;
+  size_t vertex_count;
+  double winding;
+  vector_t min;
+  vector_t max;
+} collider_t;
+
+typedef struct projectiles {
+  size_t size;
+  size_t capacity;
+  size_t high_water;
+  double *x;
+  double *y;
+  double *vx;
+  double *vy;
+  double *angle;
+  double *height;
+  rgb_color_t *color;
+  game_weapon_type_t *weapon;
+  body_handle_t *owner;
+  // The last RICOCHET_SURFACES bodies projectile i bounced off start at
+  // bounced[i * RICOCHET_SURFACES], overwritten oldest first
+  body_handle_t *bounced;
+  size_t *bounces;
+  bool *removed;
+
+  // Scratch space reused by every tick
+  double *next_x;
+  double *next_y;
+  size_t *cell_of;
+  size_t *cell_start;
+  size_t *cell_order;
+  size_t cells_capacity;
+  collider_t *colliders;
+  size_t colliders_size;
+  size_t colliders_capacity;
+  vector_t *vertices;
+  size_t vertices_size;
+  size_t vertices_capacity;
+} projectiles_t;
+
+void *projectiles_resize_array(void *array, size_t count, size_t size) {
+  void *resized = realloc(array, count * size);
+  assert(resized != NULL);
+  return resized;
+}
+
+void projectiles_reserve(projectiles_t *projectiles, size_t capacity) {
+  if (capacity <= projectiles->capacity) {
+    return;
+  }
+  projectiles->x = projectiles_resize_array(projectiles->x, capacity,
+                                            sizeof(double));
+  projectiles->y = projectiles_resize_array(projectiles->y, capacity,
+                                            sizeof(double));
+  projectiles->vx = projectiles_resize_array(projectiles->vx, capacity,
+                                             sizeof(double));
+  projectiles->vy = projectiles_resize_array(projectiles->vy, capacity,
+                                             sizeof(double));
+  projectiles->angle = projectiles_resize_array(projectiles->angle, capacity,
+                                                sizeof(double));
+  projectiles->height = projectiles_resize_array(projectiles->height,
+                                                 capacity, sizeof(double));
+  projectiles->color = projectiles_resize_array(projectiles->color, capacity,
+                                                sizeof(rgb_color_t));
+  projectiles->weapon = projectiles_resize_array(
+      projectiles->weapon, capacity, sizeof(game_weapon_type_t));
+  projectiles->owner = projectiles_resize_array(projectiles->owner, capacity,
+                                                sizeof(body_handle_t));
+  projectiles->bounced = projectiles_resize_array(
+      projectiles->bounced, capacity * RICOCHET_SURFACES,
+      sizeof(body_handle_t));
+  projectiles->bounces = projectiles_resize_array(projectiles->bounces,
+                                                  capacity, sizeof(size_t));
+  projectiles->removed = projectiles_resize_array(projectiles->removed,
+                                                  capacity, sizeof(bool));
+  projectiles->next_x = projectiles_resize_array(projectiles->next_x,
+                                                 capacity, sizeof(double));
+  projectiles->next_y = projectiles_resize_array(projectiles->next_y,
+                                                 capacity, sizeof(double));
+  projectiles->cell_of = projectiles_resize_array(projectiles->cell_of,
+                                                  capacity, sizeof(size_t));
+  projectiles->cell_order = projectiles_resize_array(
+      projectiles->cell_order, capacity, sizeof(size_t));
+  projectiles->capacity = capacity;
+}
+
+projectiles_t *projectiles_init(size_t initial_capacity) {
+  projectiles_t *projectiles = calloc(1, sizeof(projectiles_t));
+  assert(projectiles != NULL);
+  projectiles_reserve(projectiles,
+                      initial_capacity > 0 ? initial_capacity : 1);
+  projectiles->colliders = projectiles_resize_array(
+      NULL, INITIAL_COLLIDERS, sizeof(collider_t));
+  projectiles->colliders_capacity = INITIAL_COLLIDERS;
+  projectiles->vertices =
+      projectiles_resize_array(NULL, INITIAL_VERTICES, sizeof(vector_t));
+  projectiles->vertices_capacity = INITIAL_VERTICES;
+  return projectiles;
+}
+
+void projectiles_free(projectiles_t *projectiles) {
+  free(projectiles->x);
+  free(projectiles->y);
+  free(projectiles->vx);
+  free(projectiles->vy);
+  free(projectiles->angle);
+  free(projectiles->height);
+  free(projectiles->color);
+  free(projectiles->weapon);
+  free(projectiles->owner);
+  free(projectiles->bounced);
+  free(projectiles->bounces);
+  free(projectiles->removed);
+  free(projectiles->next_x);
+  free(projectiles->next_y);
+  free(projectiles->cell_of);
+  free(projectiles->cell_start);
+  free(projectiles->cell_order);
+  free(projectiles->colliders);
+  free(projectiles->vertices);
+  free(projectiles);
+}
+
+void projectiles_add(projectiles_t *projectiles, vector_t position,
+                     vector_t velocity, double angle, double height,
+                     rgb_color_t color, game_weapon_type_t weapon,
+                     body_handle_t owner) {
+  if (projectiles->size == projectiles->capacity) {
+    projectiles_reserve(projectiles, projectiles->capacity * 2);
+  }
+  size_t i = projectiles->size;
+  projectiles->x[i] = position.x;
+  projectiles->y[i] = position.y;
+  projectiles->vx[i] = velocity.x;
+  projectiles->vy[i] = velocity.y;
+  projectiles->angle[i] = angle;
+  projectiles->height[i] = height;
+  projectiles->color[i] = color;
+  projectiles->weapon[i] = weapon;
+  projectiles->owner[i] = owner;
+  for (size_t k = 0; k < RICOCHET_SURFACES; k++) {
+    projectiles->bounced[i * RICOCHET_SURFACES + k] = BODY_HANDLE_NONE;
+  }
+  projectiles->bounces[i] = 0;
+  projectiles->removed[i] = false;
+  projectiles->size++;
+  if (projectiles->size > projectiles->high_water) {
+    projectiles->high_water = projectiles->size;
+  }
+}
+
+size_t projectiles_size(projectiles_t *projectiles) {
+  return projectiles->size;
+}
+
+size_t projectiles_high_water(projectiles_t *projectiles) {
+  return projectiles->high_water;
+}
+
+vector_t projectiles_get_position(projectiles_t *projectiles, size_t index) {
+  assert(index < projectiles->size);
+  return (vector_t){projectiles->x[index], projectiles->y[index]};
+}
+
+vector_t projectiles_get_velocity(projectiles_t *projectiles, size_t index) {
+  assert(index < projectiles->size);
+  return (vector_t){projectiles->vx[index], projectiles->vy[index]};
+}
+
+game_weapon_type_t projectiles_get_weapon(projectiles_t *projectiles,
+                                          size_t index) {
+  assert(index < projectiles->size);
+  return projectiles->weapon[index];
+}
+
+rgb_color_t projectiles_get_color(projectiles_t *projectiles, size_t index) {
+  assert(index < projectiles->size);
+  return projectiles->color[index];
+}
+
+void projectiles_save(projectiles_t *projectiles, snapshot_t *snapshot) {
+  size_t size = projectiles->size;
+  snapshot_write(snapshot, &size, sizeof(size));
+  snapshot_write(snapshot, &projectiles->high_water, sizeof(size_t));
+  snapshot_write(snapshot, projectiles->x, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->y, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->vx, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->vy, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->angle, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->height, size * sizeof(double));
+  snapshot_write(snapshot, projectiles->color, size * sizeof(rgb_color_t));
+  snapshot_write(snapshot, projectiles->weapon,
+                 size * sizeof(game_weapon_type_t));
+  snapshot_write(snapshot, projectiles->owner, size * sizeof(body_handle_t));
+  snapshot_write(snapshot, projectiles->bounced,
+                 size * RICOCHET_SURFACES * sizeof(body_handle_t));
+  snapshot_write(snapshot, projectiles->bounces, size * sizeof(size_t));
+}
+
+void projectiles_restore(projectiles_t *projectiles, snapshot_t *snapshot) {
+  size_t size = snapshot_read_count(snapshot, sizeof(double));
+  projectiles_reserve(projectiles, size);
+  projectiles->size = size;
+  snapshot_read(snapshot, &projectiles->high_water, sizeof(size_t));
+  snapshot_read(snapshot, projectiles->x, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->y, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->vx, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->vy, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->angle, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->height, size * sizeof(double));
+  snapshot_read(snapshot, projectiles->color, size * sizeof(rgb_color_t));
+  snapshot_read(snapshot, projectiles->weapon,
+                size * sizeof(game_weapon_type_t));
+  snapshot_read(snapshot, projectiles->owner, size * sizeof(body_handle_t));
+  snapshot_read(snapshot, projectiles->bounced,
+                size * RICOCHET_SURFACES * sizeof(body_handle_t));
+  snapshot_read(snapshot, projectiles->bounces, size * sizeof(size_t));
+  // Removal only happens within a tick, so no saved projectile is removed
+  for (size_t i = 0; i < size; i++) {
+    projectiles->removed[i] = false;
+  }
+}
+
+void projectiles_get_corners(projectiles_t *projectiles, size_t index,
+                             vector_t corners[4]) {
+  assert(index < projectiles->size);
+  vector_t half_width = {.x = PROJECTILE_LENGTH / 2, .y = 0.0},
+           half_height = {.x = 0.0, .y = projectiles->height[index] / 2};
+  corners[0] = vec_subtract(half_height, half_width);
+  corners[1] = vec_subtract(vec_negate(half_width), half_height);
+  corners[2] = vec_subtract(half_width, half_height);
+  corners[3] = vec_add(half_width, half_height);
+
+  vector_t center = projectiles_get_position(projectiles, index);
+  for (size_t i = 0; i < 4; i++) {
+    corners[i] = vec_add(vec_rotate(corners[i], projectiles->angle[index]),
+                         center);
+  }
+}
+
+/* --------------------- COLLIDERS START ---------------------------
+------------------------------------------------------------------*/
+bool is_projectile_target(body_type_t type) {
+  switch (type) {
+  case PLAYER1:
+  case PLAYER2:
+  case WALL:
+  case GROUND:
+  case CLOCK_BIG_ARM:
+  case CLOCK_SMALL_ARM:
+  case POWERUP_RICOCHET:
+  case POWERUP_SHOTGUN:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/** Snapshots every body projectiles can hit, and finds the gravity body */
+body_t *projectiles_gather(projectiles_t *projectiles, scene_t *scene) {
+  body_t *gravity = NULL;
+  projectiles->colliders_size = 0;
+  projectiles->vertices_size = 0;
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    body_type_t type = get_info(body)->type;
+    if (type == GRAVITY && gravity == NULL) {
+      gravity = body;
+    }
+    if (!is_projectile_target(type) || body_is_removed(body)) {
+      continue;
+    }
+
+    list_t *shape = body_get_vertices(body);
+    size_t count = list_size(shape);
+    if (projectiles->colliders_size == projectiles->colliders_capacity) {
+      projectiles->colliders_capacity *= 2;
+      projectiles->colliders = projectiles_resize_array(
+          projectiles->colliders, projectiles->colliders_capacity,
+          sizeof(collider_t));
+    }
+    while (projectiles->vertices_size + count >
+           projectiles->vertices_capacity) {
+      projectiles->vertices_capacity *= 2;
+      projectiles->vertices = projectiles_resize_array(
+          projectiles->vertices, projectiles->vertices_capacity,
+          sizeof(vector_t));
+    }
+
+    collider_t *collider = &projectiles->colliders[projectiles->colliders_size];
+    *collider = (collider_t){.body = body,
+                             .type = type,
+                             .first_vertex = projectiles->vertices_size,
+                             .vertex_count = count,
+                             .min = {INFINITY, INFINITY},
+                             .max = {-INFINITY, -INFINITY}};
+    double area = 0;
+    for (size_t j = 0; j < count; j++) {
+      vector_t v = *(vector_t *)list_get(shape, j);
+      vector_t next = *(vector_t *)list_get(shape, (j + 1) % count);
+      area += vec_cross(v, next);
+      collider->min = (vector_t){fmin(collider->min.x, v.x),
+                                 fmin(collider->min.y, v.y)};
+      collider->max = (vector_t){fmax(collider->max.x, v.x),
+                                 fmax(collider->max.y, v.y)};
+      projectiles->vertices[projectiles->vertices_size + j] = v;
+    }
+    collider->winding = area >= 0 ? 1.0 : -1.0;
+    projectiles->vertices_size += count;
+    projectiles->colliders_size++;
+  }
+  return gravity;
+}
+
+/**
+ * Clips the segment from start to end against a convex collider.
+ * On a hit, stores the fraction of the segment travelled before entering
+ * and the outward normal of the face entered. A segment that starts inside
+ * reports a fraction of 0 and the face it is closest to.
+ */
+bool segment_cast(projectiles_t *projectiles, collider_t *collider,
+                  vector_t start, vector_t end, double *fraction,
+                  vector_t *normal) {
+  vector_t *vertices = &projectiles->vertices[collider->first_vertex];
+  size_t count = collider->vertex_count;
+  vector_t direction = vec_subtract(end, start);
+  double t_enter = 0;
+  double t_exit = 1;
+  bool entered = false;
+  double shallowest = -INFINITY;
+  vector_t enter_normal = VEC_ZERO;
+  vector_t inside_normal = VEC_ZERO;
+
+  for (size_t i = 0; i < count; i++) {
+    vector_t edge = vec_subtract(vertices[(i + 1) % count], vertices[i]);
+    vector_t outward = vec_unit_vector(
+        vec_multiply(collider->winding, (vector_t){edge.y, -edge.x}));
+    double distance = vec_dot(outward, vec_subtract(start, vertices[i]));
+    double rate = vec_dot(outward, direction);
+    if (distance > shallowest) {
+      shallowest = distance;
+      inside_normal = outward;
+    }
+
+    if (rate == 0) {
+      if (distance > 0) {
+        return false;
+      }
+      continue;
+    }
+    double t = -distance / rate;
+    if (rate < 0) {
+      if (t > t_enter) {
+        t_enter = t;
+        enter_normal = outward;
+        entered = true;
+      }
+    } else if (t < t_exit) {
+      t_exit = t;
+    }
+    if (t_enter > t_exit) {
+      return false;
+    }
+  }
+
+  *fraction = entered ? t_enter : 0;
+  *normal = entered ? enter_normal : inside_normal;
+  return true;
+}
+
+/* --------------------- TICK START --------------------------------
+------------------------------------------------------------------*/
+void projectiles_integrate(projectiles_t *projectiles, body_t *gravity,
+                           double dt) {
+  vector_t gravity_center =
+      gravity != NULL ? body_get_centroid(gravity) : VEC_ZERO;
+  double gravity_mu = gravity != NULL ? G * body_get_mass(gravity) : 0;
+
+  for (size_t i = 0; i < projectiles->size; i++) {
+    double ax = 0;
+    double ay = 0;
+    // Shotgun pellets were never bound to gravity
+    if (gravity != NULL && projectiles->weapon[i] != SHOTGUN) {
+      double dx = gravity_center.x - projectiles->x[i];
+      double dy = gravity_center.y - projectiles->y[i];
+      double distance = fmax(sqrt(dx * dx + dy * dy), MIN_GRAVITY_DISTANCE);
+      double scale = gravity_mu / (distance * distance * distance);
+      ax = dx * scale;
+      ay = dy * scale;
+    }
+
+    // Same scheme as body_tick(): move by the average of the two velocities
+    double vx = projectiles->vx[i] + ax * dt;
+    double vy = projectiles->vy[i] + ay * dt;
+    projectiles->next_x[i] =
+        projectiles->x[i] + (projectiles->vx[i] + vx) / 2 * dt;
+    projectiles->next_y[i] =
+        projectiles->y[i] + (projectiles->vy[i] + vy) / 2 * dt;
+    projectiles->vx[i] = vx;
+    projectiles->vy[i] = vy;
+  }
+}
+
+/** Whether projectile i remembers bouncing off the body with this handle */
+bool projectile_has_bounced(projectiles_t *projectiles, size_t i,
+                            body_handle_t surface) {
+  body_handle_t *bounced = &projectiles->bounced[i * RICOCHET_SURFACES];
+  for (size_t k = 0; k < RICOCHET_SURFACES; k++) {
+    if (bounced[k].index == surface.index &&
+        bounced[k].generation == surface.generation) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void projectile_hit_collider(projectiles_t *projectiles, size_t i,
+                             collider_t *collider, vector_t center,
+                             vector_t normal) {
+  switch (collider->type) {
+  case PLAYER1:
+  case PLAYER2:
+    body_remove(collider->body);
+    projectiles->removed[i] = true;
+    break;
+  case POWERUP_RICOCHET:
+  case POWERUP_SHOTGUN:
+    projectiles->removed[i] = true;
+    break;
+  default: {
+    // Ricochets bounce off each surface once and die on the second hit.
+    // Surfaces are told apart by handle, which colliders are rebuilt from
+    // every tick but which stays the same for as long as the body lives.
+    body_handle_t surface = body_get_handle(collider->body);
+    if (projectiles->weapon[i] != RICOCHET ||
+        projectile_has_bounced(projectiles, i, surface)) {
+      projectiles->removed[i] = true;
+      break;
+    }
+    size_t oldest = projectiles->bounces[i] % RICOCHET_SURFACES;
+    projectiles->bounced[i * RICOCHET_SURFACES + oldest] = surface;
+    projectiles->bounces[i]++;
+    vector_t velocity = projectiles_get_velocity(projectiles, i);
+    double into = vec_dot(velocity, normal);
+    if (into < 0) {
+      velocity = vec_subtract(velocity, vec_multiply(2 * into, normal));
+    }
+    center = vec_add(center, vec_multiply(BOUNCE_OFFSET, normal));
+    projectiles->vx[i] = velocity.x;
+    projectiles->vy[i] = velocity.y;
+    projectiles->next_x[i] = center.x;
+    projectiles->next_y[i] = center.y;
+    break;
+  }
+  }
+}
+
+void projectiles_collide_bodies(projectiles_t *projectiles) {
+  for (size_t i = 0; i < projectiles->size; i++) {
+    vector_t start = projectiles_get_position(projectiles, i);
+    vector_t end = {projectiles->next_x[i], projectiles->next_y[i]};
+    vector_t travel = vec_subtract(end, start);
+    double travel_length = vec_length(travel);
+    // Sweep the leading tip so the projectile's length is accounted for
+    vector_t tip = VEC_ZERO;
+    if (travel_length > 0) {
+      tip = vec_multiply(PROJECTILE_LENGTH / 2 / travel_length, travel);
+    }
+    vector_t sweep_end = vec_add(end, tip);
+    vector_t sweep_min = {fmin(start.x, sweep_end.x),
+                          fmin(start.y, sweep_end.y)};
+    vector_t sweep_max = {fmax(start.x, sweep_end.x),
+                          fmax(start.y, sweep_end.y)};
+
+    size_t hit = projectiles->colliders_size;
+    double hit_fraction = INFINITY;
+    vector_t hit_normal = VEC_ZERO;
+    for (size_t c = 0; c < projectiles->colliders_size; c++) {
+      collider_t *collider = &projectiles->colliders[c];
+      if (sweep_max.x < collider->min.x || sweep_min.x > collider->max.x ||
+          sweep_max.y < collider->min.y || sweep_min.y > collider->max.y) {
+        continue;
+      }
+      double fraction;
+      vector_t normal;
+      if (segment_cast(projectiles, collider, start, sweep_end, &fraction,
+                       &normal) &&
+          fraction < hit_fraction) {
+        hit = c;
+        hit_fraction = fraction;
+        hit_normal = normal;
+      }
+    }
+
+    if (hit < projectiles->colliders_size) {
+      vector_t contact = vec_add(
+          start, vec_multiply(hit_fraction, vec_subtract(sweep_end, start)));
+      vector_t center = vec_subtract(contact, tip);
+      if (hit_fraction == 0) {
+        center = start;
+      }
+      projectile_hit_collider(projectiles, i, &projectiles->colliders[hit],
+                              center, hit_normal);
+    }
+  }
+}
+
+/** Applies the bullet-on-bullet rules to a pair that touched this tick */
+void projectiles_hit_each_other(projectiles_t *projectiles, size_t i,
+                                size_t j) {
+  // Shotgun pellets destroy any other bullet and pass through each other,
+  // while two other bullets destroy each other
+  if (projectiles->weapon[i] != SHOTGUN) {
+    projectiles->removed[i] = true;
+  }
+  if (projectiles->weapon[j] != SHOTGUN) {
+    projectiles->removed[j] = true;
+  }
+}
+
+/** Whether two projectiles come within touching distance during the tick */
+bool projectiles_touch(projectiles_t *projectiles, size_t i, size_t j) {
+  double px = projectiles->x[j] - projectiles->x[i];
+  double py = projectiles->y[j] - projectiles->y[i];
+  double dx = (projectiles->next_x[j] - projectiles->x[j]) -
+              (projectiles->next_x[i] - projectiles->x[i]);
+  double dy = (projectiles->next_y[j] - projectiles->y[j]) -
+              (projectiles->next_y[i] - projectiles->y[i]);
+  // Closest approach of the relative motion over the tick
+  double rate = dx * dx + dy * dy;
+  double t = rate > 0 ? -(px * dx + py * dy) / rate : 0;
+  t = fmin(fmax(t, 0), 1);
+  double cx = px + t * dx;
+  double cy = py + t * dy;
+  return cx * cx + cy * cy <= PROJECTILE_LENGTH * PROJECTILE_LENGTH;
+}
+
+size_t projectiles_cell_hash(long cell_x, long cell_y, size_t mask) {
+  return ((size_t)cell_x * 73856093u ^ (size_t)cell_y * 19349663u) & mask;
+}
+
+/**
+ * Finds touching projectile pairs with a uniform grid. Cells are sized so
+ * that any pair that can touch this tick starts in neighbouring cells.
+ */
+void projectiles_collide_each_other(projectiles_t *projectiles) {
+  size_t size = projectiles->size;
+  if (size < 2) {
+    return;
+  }
+
+  double max_step = 0;
+  for (size_t i = 0; i < size; i++) {
+    double dx = projectiles->next_x[i] - projectiles->x[i];
+    double dy = projectiles->next_y[i] - projectiles->y[i];
+    max_step = fmax(max_step, dx * dx + dy * dy);
+  }
+  double cell_size = PROJECTILE_LENGTH + 2 * sqrt(max_step);
+
+  size_t buckets = 1;
+  while (buckets < 2 * size) {
+    buckets *= 2;
+  }
+  if (buckets + 1 > projectiles->cells_capacity) {
+    projectiles->cell_start = projectiles_resize_array(
+        projectiles->cell_start, buckets + 1, sizeof(size_t));
+    projectiles->cells_capacity = buckets + 1;
+  }
+  size_t mask = buckets - 1;
+
+  // Counting sort of projectile indices by bucket
+  size_t *cell_start = projectiles->cell_start;
+  for (size_t b = 0; b <= buckets; b++) {
+    cell_start[b] = 0;
+  }
+  for (size_t i = 0; i < size; i++) {
+    long cell_x = (long)floor(projectiles->x[i] / cell_size);
+    long cell_y = (long)floor(projectiles->y[i] / cell_size);
+    projectiles->cell_of[i] = projectiles_cell_hash(cell_x, cell_y, mask);
+    cell_start[projectiles->cell_of[i] + 1]++;
+  }
+  for (size_t b = 0; b < buckets; b++) {
+    cell_start[b + 1] += cell_start[b];
+  }
+  for (size_t i = 0; i < size; i++) {
+    size_t b = projectiles->cell_of[i];
+    projectiles->cell_order[cell_start[b]] = i;
+    cell_start[b]++;
+  }
+  // Filling shifted each start to the next bucket's; shift them back
+  for (size_t b = buckets; b > 0; b--) {
+    cell_start[b] = cell_start[b - 1];
+  }
+  cell_start[0] = 0;
+
+  for (size_t i = 0; i < size; i++) {
+    long cell_x = (long)floor(projectiles->x[i] / cell_size);
+    long cell_y = (long)floor(projectiles->y[i] / cell_size);
+    for (long dx = -1; dx <= 1; dx++) {
+      for (long dy = -1; dy <= 1; dy++) {
+        size_t b = projectiles_cell_hash(cell_x + dx, cell_y + dy, mask);
+        for (size_t k = cell_start[b]; k < cell_start[b + 1]; k++) {
+          size_t j = projectiles->cell_order[k];
+          // Each pair is tested from its lower index only
+          if (j <= i) {
+            continue;
+          }
+          if (projectiles_touch(projectiles, i, j)) {
+            projectiles_hit_each_other(projectiles, i, j);
+          }
+        }
+      }
+    }
+  }
+}
+
+void projectiles_check_range(projectiles_t *projectiles, scene_t *scene) {
+  for (size_t i = 0; i < projectiles->size; i++) {
+    if (projectiles->weapon[i] != SHOTGUN) {
+      continue;
+    }
+    // Pellets die once they stray too far from whoever fired them
+    body_t *owner = scene_resolve(scene, projectiles->owner[i]);
+    if (owner == NULL) {
+      continue;
+    }
+    vector_t offset = vec_subtract(body_get_centroid(owner),
+                                   projectiles_get_position(projectiles, i));
+    if (vec_length(offset) > SHOTGUN_RADIUS) {
+      projectiles->removed[i] = true;
+    }
+  }
+}
+
+/** Commits the moves and swap-removes dead projectiles */
+void projectiles_compact(projectiles_t *projectiles) {
+  size_t i = 0;
+  while (i < projectiles->size) {
+    if (!projectiles->removed[i]) {
+      projectiles->x[i] = projectiles->next_x[i];
+      projectiles->y[i] = projectiles->next_y[i];
+      i++;
+      continue;
+    }
+    size_t last = projectiles->size - 1;
+    projectiles->x[i] = projectiles->x[last];
+    projectiles->y[i] = projectiles->y[last];
+    projectiles->next_x[i] = projectiles->next_x[last];
+    projectiles->next_y[i] = projectiles->next_y[last];
+    projectiles->vx[i] = projectiles->vx[last];
+    projectiles->vy[i] = projectiles->vy[last];
+    projectiles->angle[i] = projectiles->angle[last];
+    projectiles->height[i] = projectiles->height[last];
+    projectiles->color[i] = projectiles->color[last];
+    projectiles->weapon[i] = projectiles->weapon[last];
+    projectiles->owner[i] = projectiles->owner[last];
+    for (size_t k = 0; k < RICOCHET_SURFACES; k++) {
+      projectiles->bounced[i * RICOCHET_SURFACES + k] =
+          projectiles->bounced[last * RICOCHET_SURFACES + k];
+    }
+    projectiles->bounces[i] = projectiles->bounces[last];
+    projectiles->removed[i] = projectiles->removed[last];
+    projectiles->size--;
+  }
+}
+
+void projectiles_tick(projectiles_t *projectiles, scene_t *scene, double dt) {
+  if (projectiles->size == 0) {
+    return;
+  }
+  body_t *gravity = projectiles_gather(projectiles, scene);
+  projectiles_integrate(projectiles, gravity, dt);
+  projectiles_collide_bodies(projectiles);
+  projectiles_collide_each_other(projectiles);
+  projectiles_check_range(projectiles, scene);
+  projectiles_compact(projectiles);
+}
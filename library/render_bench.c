@@ -0,0 +1,117 @@
+#include "frame_timer.h"
+#include "map.h"
+#include "match.h"
+#include "projectile.h"
+#include "runtime.h"
+#include "sdl_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Measures what drawing costs on its own, without a display: renders scripted
+ * scenes through sdl_render_game() with SDL's dummy video driver, which makes
+ * sdl_wrapper.c draw with the software renderer into an offscreen surface.
+ * Reports the time each frame took to draw and the draw calls it made. Build
+ * it like the game, with this file in place of emscripten.c.
+ *
+ * The scenes are the main menu, map 1 and map 2 with RENDER_BENCH_BULLETS
+ * bullets in flight, each drawn RENDER_BENCH_FRAMES times. Nothing moves
+ * between frames but the players' animations, which RENDER_BENCH_SEED
+ * decides, so the same build always draws the same frames. RENDER_BENCH_OUT
+ * writes each scene's last frame to <RENDER_BENCH_OUT><scene>.ppm, to diff
+ * against another build's, e.g.
+ *
+ *   RENDER_BENCH_OUT=before_ ./render_bench
+ */
+
+const size_t RENDER_BENCH_DEFAULT_FRAMES = 300;
+const size_t RENDER_BENCH_DEFAULT_BULLETS = 200;
+// Ticks the maps run first, so the players land and the clock starts
+const size_t RENDER_BENCH_SETTLE_TICKS = 60;
+const double RENDER_BENCH_BULLET_HEIGHT = 1.0;
+const rgb_color_t RENDER_BENCH_BULLET_COLOR = {.r = 0.01, .g = 0.98, .b = 0.05};
+
+/** Spreads bullets evenly over a map, in rows twice as long as the map */
+void bench_add_bullets(scene_t *scene, vector_t max, size_t count) {
+  projectiles_t *projectiles = scene_get_projectiles(scene);
+  size_t columns = (size_t)ceil(sqrt(2.0 * count));
+  size_t rows = columns > 0 ? (count + columns - 1) / columns : 0;
+  for (size_t i = 0; i < count; i++) {
+    vector_t position = {.x = (i % columns + 0.5) * max.x / columns,
+                         .y = (i / columns + 0.5) * max.y / rows};
+    projectiles_add(projectiles, position, (vector_t)VEC_ZERO, 0,
+                    RENDER_BENCH_BULLET_HEIGHT, RENDER_BENCH_BULLET_COLOR,
+                    PISTOL, BODY_HANDLE_NONE);
+  }
+}
+
+/** Draws a scene over and over, then reports how long drawing took */
+void bench_scene(scene_t *scene, const char *name, size_t frames) {
+  frame_timer_t *timer = frame_timer_init(frames);
+  sdl_take_draw_calls();
+  frame_timer_tick(timer);
+  for (size_t i = 0; i < frames; i++) {
+    sdl_render_game(scene);
+    frame_timer_tick(timer);
+  }
+  double draw_calls = (double)sdl_take_draw_calls() / frames;
+  frame_timer_print(timer, name);
+  printf("%s: %zu bullets, %.1f draw calls per frame\n", name,
+         projectiles_size(scene_get_projectiles(scene)), draw_calls);
+  frame_timer_free(timer);
+
+  const char *out_prefix = getenv("RENDER_BENCH_OUT");
+  if (out_prefix != NULL) {
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s%s.ppm", out_prefix, name);
+    if (!sdl_write_frame(path)) {
+      fprintf(stderr, "render_bench: cannot write %s\n", path);
+    }
+  }
+}
+
+/** Starts a match on a map and runs it until it looks like a match */
+state_t *bench_match(game_state_t map, uint64_t seed) {
+  state_t *state = match_init(map, seed);
+  for (size_t i = 0; i < RENDER_BENCH_SETTLE_TICKS; i++) {
+    match_step(state, RUNTIME_TICK_DT);
+  }
+  return state;
+}
+
+int main() {
+  size_t frames =
+      runtime_env("RENDER_BENCH_FRAMES", RENDER_BENCH_DEFAULT_FRAMES);
+  size_t bullets =
+      runtime_env("RENDER_BENCH_BULLETS", RENDER_BENCH_DEFAULT_BULLETS);
+  uint64_t seed = runtime_env("RENDER_BENCH_SEED", 1);
+  if (frames == 0) {
+    fprintf(stderr, "render_bench: RENDER_BENCH_FRAMES must be positive\n");
+    return 1;
+  }
+  // No display and no sound card needed
+  setenv("SDL_VIDEODRIVER", "dummy", 1);
+  setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX_MENU);
+  scene_t *menu = scene_init();
+  create_map(menu, MAIN_MENU);
+  sdl_sprites_init(menu, MAIN_MENU);
+  bench_scene(menu, "menu", frames);
+  scene_free(menu);
+
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX1);
+  state_t *map1 = bench_match(MAP1, seed);
+  bench_scene(match_get_scene(map1), "map1", frames);
+  match_free(map1);
+
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  state_t *map2 = bench_match(MAP2, seed);
+  bench_add_bullets(match_get_scene(map2), (vector_t)MAX2, bullets);
+  bench_scene(match_get_scene(map2), "map2", frames);
+  match_free(map2);
+
+  sdl_clean();
+  return 0;
+}
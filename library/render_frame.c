@@ -0,0 +1,216 @@
+#include "render_frame.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t RENDER_FRAME_INITIAL_COMMANDS = 64;
+const size_t RENDER_FRAME_INITIAL_VERTICES = 256;
+// Sort keys hold the layer above the low bits of the texture's id
+const size_t RENDER_FRAME_TEXTURE_BITS = 16;
+const size_t RENDER_FRAME_KEY_BYTES = 3;
+const size_t RENDER_FRAME_RADIX = 256;
+
+typedef enum { RENDER_SPRITE, RENDER_POLYGON } render_kind_t;
+
+typedef struct render_command {
+  render_kind_t kind;
+  union {
+    struct {
+      const texture_region_t *region;
+      SDL_Rect dest;
+      bool flip;
+    } sprite;
+    struct {
+      SDL_Color color;
+      // The polygon's vertices in the frame's vertex buffer
+      size_t first;
+      size_t count;
+    } polygon;
+  };
+} render_command_t;
+
+typedef struct render_frame {
+  render_command_t *commands;
+  // Each command's sort key, and the commands' indices in drawing order
+  uint32_t *keys;
+  size_t *order;
+  // Where each sorting pass puts the indices before they are swapped back
+  size_t *sorted;
+  size_t command_count;
+  size_t command_capacity;
+  SDL_FPoint *vertices;
+  size_t vertex_count;
+  size_t vertex_capacity;
+} render_frame_t;
+
+render_frame_t *render_frame_init(void) {
+  render_frame_t *frame = malloc(sizeof(render_frame_t));
+  assert(frame != NULL);
+  size_t capacity = RENDER_FRAME_INITIAL_COMMANDS;
+  *frame = (render_frame_t){
+      .commands = malloc(capacity * sizeof(render_command_t)),
+      .keys = malloc(capacity * sizeof(uint32_t)),
+      .order = malloc(capacity * sizeof(size_t)),
+      .sorted = malloc(capacity * sizeof(size_t)),
+      .command_count = 0,
+      .command_capacity = capacity,
+      .vertices = malloc(RENDER_FRAME_INITIAL_VERTICES * sizeof(SDL_FPoint)),
+      .vertex_count = 0,
+      .vertex_capacity = RENDER_FRAME_INITIAL_VERTICES};
+  assert(frame->commands != NULL && frame->keys != NULL);
+  assert(frame->order != NULL && frame->sorted != NULL);
+  assert(frame->vertices != NULL);
+  return frame;
+}
+
+void render_frame_free(render_frame_t *frame) {
+  free(frame->commands);
+  free(frame->keys);
+  free(frame->order);
+  free(frame->sorted);
+  free(frame->vertices);
+  free(frame);
+}
+
+void render_frame_clear(render_frame_t *frame) {
+  frame->command_count = 0;
+  frame->vertex_count = 0;
+}
+
+render_command_t *render_frame_add_command(render_frame_t *frame,
+                                           render_kind_t kind, uint8_t layer,
+                                           size_t texture_id) {
+  if (frame->command_count == frame->command_capacity) {
+    frame->command_capacity *= 2;
+    size_t capacity = frame->command_capacity;
+    frame->commands =
+        realloc(frame->commands, capacity * sizeof(render_command_t));
+    frame->keys = realloc(frame->keys, capacity * sizeof(uint32_t));
+    frame->order = realloc(frame->order, capacity * sizeof(size_t));
+    frame->sorted = realloc(frame->sorted, capacity * sizeof(size_t));
+    assert(frame->commands != NULL && frame->keys != NULL);
+    assert(frame->order != NULL && frame->sorted != NULL);
+  }
+  // Textures whose ids share their low bits only cost an extra draw call
+  uint32_t texture_bits =
+      texture_id & (((uint32_t)1 << RENDER_FRAME_TEXTURE_BITS) - 1);
+  frame->keys[frame->command_count] =
+      (uint32_t)layer << RENDER_FRAME_TEXTURE_BITS | texture_bits;
+  render_command_t *command = &frame->commands[frame->command_count++];
+  command->kind = kind;
+  return command;
+}
+
+void render_frame_add_sprite(render_frame_t *frame, uint8_t layer,
+                             const texture_region_t *region, SDL_Rect dest,
+                             bool flip) {
+  render_command_t *command = render_frame_add_command(
+      frame, RENDER_SPRITE, layer, region->texture_id);
+  command->sprite.region = region;
+  command->sprite.dest = dest;
+  command->sprite.flip = flip;
+}
+
+void render_frame_start_polygon(render_frame_t *frame, uint8_t layer,
+                                SDL_Color color) {
+  // Polygons use no texture, and texture ids start at 1
+  render_command_t *command =
+      render_frame_add_command(frame, RENDER_POLYGON, layer, 0);
+  command->polygon.color = color;
+  command->polygon.first = frame->vertex_count;
+  command->polygon.count = 0;
+}
+
+void render_frame_add_vertex(render_frame_t *frame, SDL_FPoint point) {
+  assert(frame->command_count > 0);
+  render_command_t *command = &frame->commands[frame->command_count - 1];
+  assert(command->kind == RENDER_POLYGON);
+  if (frame->vertex_count == frame->vertex_capacity) {
+    frame->vertex_capacity *= 2;
+    frame->vertices = realloc(frame->vertices,
+                              frame->vertex_capacity * sizeof(SDL_FPoint));
+    assert(frame->vertices != NULL);
+  }
+  frame->vertices[frame->vertex_count++] = point;
+  command->polygon.count++;
+}
+
+const size_t *render_frame_sort(render_frame_t *frame) {
+  // A least significant digit radix sort, one byte of the keys per pass.
+  // Each pass is stable, so commands with equal keys keep the order they
+  // were recorded in.
+  size_t count = frame->command_count;
+  if (count == 0) {
+    return frame->order;
+  }
+  for (size_t i = 0; i < count; i++) {
+    frame->order[i] = i;
+  }
+  for (size_t byte = 0; byte < RENDER_FRAME_KEY_BYTES; byte++) {
+    size_t shift = 8 * byte;
+    size_t starts[RENDER_FRAME_RADIX];
+    for (size_t digit = 0; digit < RENDER_FRAME_RADIX; digit++) {
+      starts[digit] = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+      starts[(frame->keys[i] >> shift) & (RENDER_FRAME_RADIX - 1)]++;
+    }
+    // A pass where every key has the same digit would move nothing
+    if (starts[(frame->keys[0] >> shift) & (RENDER_FRAME_RADIX - 1)] ==
+        count) {
+      continue;
+    }
+    size_t start = 0;
+    for (size_t digit = 0; digit < RENDER_FRAME_RADIX; digit++) {
+      size_t digit_count = starts[digit];
+      starts[digit] = start;
+      start += digit_count;
+    }
+    for (size_t i = 0; i < count; i++) {
+      size_t index = frame->order[i];
+      size_t digit = (frame->keys[index] >> shift) & (RENDER_FRAME_RADIX - 1);
+      frame->sorted[starts[digit]++] = index;
+    }
+    size_t *swap = frame->order;
+    frame->order = frame->sorted;
+    frame->sorted = swap;
+  }
+  return frame->order;
+}
+
+void render_frame_draw(render_frame_t *frame, sprite_batch_t *sprites,
+                       polygon_batch_t *polygons) {
+  if (frame->command_count == 0) {
+    return;
+  }
+  const size_t *order = render_frame_sort(frame);
+
+  // Each batch is flushed before the other draws over it, and not before,
+  // so runs of sprites or of polygons still take one draw call each
+  render_kind_t last = RENDER_SPRITE;
+  for (size_t i = 0; i < frame->command_count; i++) {
+    render_command_t *command = &frame->commands[order[i]];
+    if (command->kind != last) {
+      if (last == RENDER_SPRITE) {
+        sprite_batch_flush(sprites);
+      } else {
+        polygon_batch_flush(polygons);
+      }
+      last = command->kind;
+    }
+
+    if (command->kind == RENDER_SPRITE) {
+      if (command->sprite.region->texture != NULL) {
+        sprite_batch_add(sprites, command->sprite.region,
+                         &command->sprite.dest, command->sprite.flip);
+      }
+    } else {
+      polygon_batch_start(polygons, command->polygon.color);
+      for (size_t j = 0; j < command->polygon.count; j++) {
+        polygon_batch_add_vertex(
+            polygons, frame->vertices[command->polygon.first + j]);
+      }
+    }
+  }
+  sprite_batch_flush(sprites);
+  polygon_batch_flush(polygons);
+}
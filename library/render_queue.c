@@ -0,0 +1,338 @@
+#include "render_queue.h"
+#include "polygon_batch.h"
+#include "sprite_batch.h"
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// One snapshot being recorded, the newest published and one being drawn
+const size_t RENDER_QUEUE_SNAPSHOTS = 3;
+
+typedef struct render_queue {
+  SDL_Window *window;
+  render_mode_t mode;
+  // Only touched on the thread that draws
+  SDL_Renderer *renderer;
+  // What RENDER_OFFSCREEN draws into, otherwise NULL
+  SDL_Surface *surface;
+  sprite_batch_t *sprites;
+  polygon_batch_t *polygons;
+  SDL_Texture *static_layer;
+  int static_layer_width;
+  int static_layer_height;
+  size_t static_layer_generation;
+  size_t layer_copies;
+  // Shared with the game's thread, which only borrows and gives back images
+  texture_cache_t *textures;
+
+  render_snapshot_t *snapshots;
+  size_t writing;
+  size_t ready;
+  size_t reading;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t published;
+  bool has_published;
+  bool stopping;
+  // Set by the render thread once it has tried to create its renderer
+  pthread_cond_t opened;
+  bool has_opened;
+  bool is_open;
+} render_queue_t;
+
+/**
+ * Creates the renderer and what draws with it, on the thread that draws.
+ * Returns false, having created nothing, if SDL cannot create the renderer.
+ */
+bool render_queue_open(render_queue_t *queue) {
+  if (queue->mode == RENDER_OFFSCREEN) {
+    int width, height;
+    SDL_GetWindowSize(queue->window, &width, &height);
+    queue->surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                                                    SDL_PIXELFORMAT_RGBA32);
+    if (queue->surface == NULL) {
+      return false;
+    }
+    queue->renderer = SDL_CreateSoftwareRenderer(queue->surface);
+  } else {
+    queue->renderer =
+        SDL_CreateRenderer(queue->window, -1, SDL_RENDERER_PRESENTVSYNC);
+  }
+  if (queue->renderer == NULL) {
+    if (queue->surface != NULL) {
+      SDL_FreeSurface(queue->surface);
+      queue->surface = NULL;
+    }
+    return false;
+  }
+  queue->sprites = sprite_batch_init(queue->renderer);
+  queue->polygons = polygon_batch_init(queue->renderer);
+  return true;
+}
+
+/** Undoes render_queue_open(), on the same thread */
+void render_queue_close(render_queue_t *queue) {
+  if (queue->static_layer != NULL) {
+    SDL_DestroyTexture(queue->static_layer);
+  }
+  sprite_batch_free(queue->sprites);
+  polygon_batch_free(queue->polygons);
+  texture_cache_free(queue->textures);
+  SDL_DestroyRenderer(queue->renderer);
+  if (queue->surface != NULL) {
+    SDL_FreeSurface(queue->surface);
+  }
+}
+
+/**
+ * Draws a snapshot's static bodies into the static layer, unless the layer
+ * already shows them at this size. Returns false if the renderer cannot draw
+ * into textures, in which case they must be drawn every frame.
+ */
+bool render_queue_update_layer(render_queue_t *queue,
+                               render_snapshot_t *snapshot) {
+  if (!SDL_RenderTargetSupported(queue->renderer)) {
+    return false;
+  }
+  int width = snapshot->width, height = snapshot->height;
+  bool is_resized = queue->static_layer == NULL ||
+                    width != queue->static_layer_width ||
+                    height != queue->static_layer_height;
+  if (!is_resized &&
+      snapshot->static_generation == queue->static_layer_generation) {
+    return true;
+  }
+
+  if (is_resized) {
+    if (queue->static_layer != NULL) {
+      SDL_DestroyTexture(queue->static_layer);
+    }
+    queue->static_layer =
+        SDL_CreateTexture(queue->renderer, SDL_PIXELFORMAT_RGBA8888,
+                          SDL_TEXTUREACCESS_TARGET, width, height);
+    if (queue->static_layer == NULL) {
+      return false;
+    }
+    // The layer covers the whole window, so copying it needs no blending
+    SDL_SetTextureBlendMode(queue->static_layer, SDL_BLENDMODE_NONE);
+    queue->static_layer_width = width;
+    queue->static_layer_height = height;
+  }
+  SDL_SetRenderTarget(queue->renderer, queue->static_layer);
+  SDL_SetRenderDrawColor(queue->renderer, 255, 255, 255, 255);
+  SDL_RenderClear(queue->renderer);
+  render_frame_draw(snapshot->statics, queue->sprites, queue->polygons);
+  SDL_SetRenderTarget(queue->renderer, NULL);
+  queue->static_layer_generation = snapshot->static_generation;
+  return true;
+}
+
+void render_queue_draw(render_queue_t *queue, render_snapshot_t *snapshot) {
+  texture_cache_upload(queue->textures, queue->renderer);
+  // Nothing older than this snapshot will be drawn again
+  texture_cache_collect(queue->textures, snapshot->texture_generation);
+
+  if (snapshot->has_statics && render_queue_update_layer(queue, snapshot)) {
+    SDL_RenderCopy(queue->renderer, queue->static_layer, NULL, NULL);
+    queue->layer_copies++;
+  } else {
+    SDL_SetRenderDrawColor(queue->renderer, 255, 255, 255, 255);
+    SDL_RenderClear(queue->renderer);
+    if (snapshot->has_statics) {
+      render_frame_draw(snapshot->statics, queue->sprites, queue->polygons);
+    }
+  }
+  render_frame_draw(snapshot->frame, queue->sprites, queue->polygons);
+
+  SDL_SetRenderDrawColor(queue->renderer, 0, 0, 0, 255);
+  SDL_RenderDrawRect(queue->renderer, &snapshot->boundary);
+  SDL_RenderPresent(queue->renderer);
+}
+
+/** Draws the newest snapshot each time one is published, until stopped */
+void *render_queue_run(void *aux) {
+  render_queue_t *queue = aux;
+  bool is_open = render_queue_open(queue);
+  pthread_mutex_lock(&queue->lock);
+  queue->has_opened = true;
+  queue->is_open = is_open;
+  pthread_cond_signal(&queue->opened);
+  while (is_open) {
+    while (!queue->has_published && !queue->stopping) {
+      pthread_cond_wait(&queue->published, &queue->lock);
+    }
+    if (!queue->has_published) {
+      break;
+    }
+    size_t reading = queue->ready;
+    queue->ready = queue->reading;
+    queue->reading = reading;
+    queue->has_published = false;
+    pthread_mutex_unlock(&queue->lock);
+
+    render_queue_draw(queue, &queue->snapshots[reading]);
+
+    pthread_mutex_lock(&queue->lock);
+  }
+  pthread_mutex_unlock(&queue->lock);
+  if (is_open) {
+    render_queue_close(queue);
+  }
+  return NULL;
+}
+
+/** Frees what render_queue_init() allocates besides the renderer */
+void render_queue_free_snapshots(render_queue_t *queue) {
+  for (size_t i = 0; i < RENDER_QUEUE_SNAPSHOTS; i++) {
+    render_frame_free(queue->snapshots[i].statics);
+    render_frame_free(queue->snapshots[i].frame);
+  }
+  free(queue->snapshots);
+  pthread_cond_destroy(&queue->opened);
+  pthread_cond_destroy(&queue->published);
+  pthread_mutex_destroy(&queue->lock);
+  free(queue);
+}
+
+render_queue_t *render_queue_init(SDL_Window *window, render_mode_t mode) {
+  render_queue_t *queue = malloc(sizeof(render_queue_t));
+  assert(queue != NULL);
+  *queue = (render_queue_t){
+      .window = window,
+      .mode = mode,
+      .renderer = NULL,
+      .surface = NULL,
+      .sprites = NULL,
+      .polygons = NULL,
+      .static_layer = NULL,
+      .static_layer_width = 0,
+      .static_layer_height = 0,
+      .static_layer_generation = 0,
+      .layer_copies = 0,
+      .textures = texture_cache_init(),
+      .snapshots = malloc(RENDER_QUEUE_SNAPSHOTS * sizeof(render_snapshot_t)),
+      .writing = 0,
+      .ready = 1,
+      .reading = 2,
+      .has_published = false,
+      .stopping = false,
+      .has_opened = false,
+      .is_open = false};
+  assert(queue->snapshots != NULL);
+  for (size_t i = 0; i < RENDER_QUEUE_SNAPSHOTS; i++) {
+    queue->snapshots[i] = (render_snapshot_t){.statics = render_frame_init(),
+                                              .has_statics = false,
+                                              .static_generation = 0,
+                                              .frame = render_frame_init(),
+                                              .width = 0,
+                                              .height = 0,
+                                              .texture_generation = 0};
+  }
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->published, NULL);
+  pthread_cond_init(&queue->opened, NULL);
+
+  // Builds without threads fail to start one, and platforms that cannot
+  // render off the main thread fail to create a renderer on it; both draw
+  // inline instead
+  if (mode == RENDER_THREADED) {
+    bool is_open = false;
+    if (pthread_create(&queue->thread, NULL, render_queue_run, queue) == 0) {
+      pthread_mutex_lock(&queue->lock);
+      while (!queue->has_opened) {
+        pthread_cond_wait(&queue->opened, &queue->lock);
+      }
+      is_open = queue->is_open;
+      pthread_mutex_unlock(&queue->lock);
+      if (!is_open) {
+        pthread_join(queue->thread, NULL);
+        fprintf(stderr, "render: no renderer on a render thread (%s), "
+                        "drawing inline\n",
+                SDL_GetError());
+      }
+    }
+    if (!is_open) {
+      queue->mode = RENDER_INLINE;
+    }
+  }
+  if (queue->mode != RENDER_THREADED && !render_queue_open(queue)) {
+    texture_cache_free(queue->textures);
+    render_queue_free_snapshots(queue);
+    return NULL;
+  }
+  return queue;
+}
+
+void render_queue_free(render_queue_t *queue) {
+  if (queue->mode == RENDER_THREADED) {
+    pthread_mutex_lock(&queue->lock);
+    queue->stopping = true;
+    pthread_cond_signal(&queue->published);
+    pthread_mutex_unlock(&queue->lock);
+    pthread_join(queue->thread, NULL);
+  } else {
+    render_queue_close(queue);
+  }
+  render_queue_free_snapshots(queue);
+}
+
+texture_cache_t *render_queue_get_textures(render_queue_t *queue) {
+  return queue->textures;
+}
+
+render_snapshot_t *render_queue_begin(render_queue_t *queue) {
+  render_snapshot_t *snapshot = &queue->snapshots[queue->writing];
+  // The statics stay as they were last recorded into this snapshot, to be
+  // recorded again only when static_generation moves on
+  render_frame_clear(snapshot->frame);
+  snapshot->has_statics = false;
+  return snapshot;
+}
+
+void render_queue_publish(render_queue_t *queue) {
+  if (queue->mode != RENDER_THREADED) {
+    render_queue_draw(queue, &queue->snapshots[queue->writing]);
+    return;
+  }
+  // A snapshot the render thread has not picked up yet is replaced by this
+  // newer one and recorded over next
+  pthread_mutex_lock(&queue->lock);
+  size_t ready = queue->writing;
+  queue->writing = queue->ready;
+  queue->ready = ready;
+  queue->has_published = true;
+  pthread_cond_signal(&queue->published);
+  pthread_mutex_unlock(&queue->lock);
+}
+
+size_t render_queue_take_draw_calls(render_queue_t *queue) {
+  assert(queue->mode != RENDER_THREADED);
+  size_t draw_calls = sprite_batch_take_draw_calls(queue->sprites) +
+                      polygon_batch_take_draw_calls(queue->polygons) +
+                      queue->layer_copies;
+  queue->layer_copies = 0;
+  return draw_calls;
+}
+
+bool render_queue_write_ppm(render_queue_t *queue, const char *path) {
+  assert(queue->mode != RENDER_THREADED);
+  int width, height;
+  if (SDL_GetRendererOutputSize(queue->renderer, &width, &height) != 0) {
+    return false;
+  }
+  size_t pitch = (size_t)width * 3;
+  uint8_t *pixels = malloc(pitch * height);
+  assert(pixels != NULL);
+  bool is_written = false;
+  FILE *file = NULL;
+  if (SDL_RenderReadPixels(queue->renderer, NULL, SDL_PIXELFORMAT_RGB24,
+                           pixels, pitch) == 0 &&
+      (file = fopen(path, "wb")) != NULL) {
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    is_written = fwrite(pixels, pitch, height, file) == (size_t)height;
+    is_written = fclose(file) == 0 && is_written;
+  }
+  free(pixels);
+  return is_written;
+}
@@ -0,0 +1,226 @@
+#include "replay.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char REPLAY_MAGIC[4] = {'R', 'P', 'L', 'Y'};
+const uint32_t REPLAY_VERSION = 1;
+const size_t INITIAL_REPLAY_KEYS = 8;
+
+typedef struct replay_key {
+  char key;
+  key_event_type_t type;
+  double held_time;
+} replay_key_t;
+
+typedef struct replay {
+  FILE *file;
+  bool is_recording;
+  uint64_t seed;
+  double dt;
+  size_t ticks;
+
+  // Key events of the tick being recorded or played
+  replay_key_t *keys;
+  size_t keys_size;
+  size_t keys_capacity;
+
+  // What the tick being played ended in when it was recorded
+  game_state_t expected_state;
+  uint64_t expected_hash;
+  size_t divergences;
+  size_t first_divergence;
+} replay_t;
+
+replay_t *replay_init(FILE *file, bool is_recording) {
+  replay_t *replay = malloc(sizeof(replay_t));
+  assert(replay != NULL);
+  *replay = (replay_t){.file = file,
+                       .is_recording = is_recording,
+                       .seed = 0,
+                       .dt = 0,
+                       .ticks = 0,
+                       .keys = malloc(INITIAL_REPLAY_KEYS *
+                                      sizeof(replay_key_t)),
+                       .keys_size = 0,
+                       .keys_capacity = INITIAL_REPLAY_KEYS,
+                       .divergences = 0,
+                       .first_divergence = 0};
+  assert(replay->keys != NULL);
+  return replay;
+}
+
+bool replay_write(replay_t *replay, const void *data, size_t size) {
+  return fwrite(data, size, 1, replay->file) == 1;
+}
+
+bool replay_read(replay_t *replay, void *data, size_t size) {
+  return fread(data, size, 1, replay->file) == 1;
+}
+
+replay_t *replay_record(const char *path, uint64_t seed, double dt) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return NULL;
+  }
+  replay_t *replay = replay_init(file, true);
+  replay->seed = seed;
+  replay->dt = dt;
+  if (!replay_write(replay, REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) ||
+      !replay_write(replay, &REPLAY_VERSION, sizeof(REPLAY_VERSION)) ||
+      !replay_write(replay, &seed, sizeof(seed)) ||
+      !replay_write(replay, &dt, sizeof(dt))) {
+    replay_free(replay);
+    return NULL;
+  }
+  return replay;
+}
+
+replay_t *replay_play(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+  replay_t *replay = replay_init(file, false);
+  char magic[sizeof(REPLAY_MAGIC)];
+  uint32_t version;
+  if (!replay_read(replay, magic, sizeof(magic)) ||
+      memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 ||
+      !replay_read(replay, &version, sizeof(version)) ||
+      version != REPLAY_VERSION ||
+      !replay_read(replay, &replay->seed, sizeof(replay->seed)) ||
+      !replay_read(replay, &replay->dt, sizeof(replay->dt))) {
+    replay_free(replay);
+    return NULL;
+  }
+  return replay;
+}
+
+void replay_free(replay_t *replay) {
+  fclose(replay->file);
+  free(replay->keys);
+  free(replay);
+}
+
+bool replay_is_recording(replay_t *replay) { return replay->is_recording; }
+
+uint64_t replay_get_seed(replay_t *replay) { return replay->seed; }
+
+double replay_get_dt(replay_t *replay) { return replay->dt; }
+
+size_t replay_get_ticks(replay_t *replay) { return replay->ticks; }
+
+void replay_push_key(replay_t *replay, replay_key_t key) {
+  if (replay->keys_size == replay->keys_capacity) {
+    replay->keys_capacity *= 2;
+    replay->keys =
+        realloc(replay->keys, replay->keys_capacity * sizeof(replay_key_t));
+    assert(replay->keys != NULL);
+  }
+  replay->keys[replay->keys_size] = key;
+  replay->keys_size++;
+}
+
+void replay_add_key(replay_t *replay, char key, key_event_type_t type,
+                    double held_time) {
+  assert(replay->is_recording);
+  replay_push_key(replay, (replay_key_t){.key = key,
+                                         .type = type,
+                                         .held_time = held_time});
+}
+
+bool replay_end_tick(replay_t *replay, game_state_t game_state,
+                     uint64_t hash) {
+  assert(replay->is_recording);
+  uint32_t keys_size = replay->keys_size;
+  bool is_written = replay_write(replay, &keys_size, sizeof(keys_size));
+  for (size_t i = 0; i < replay->keys_size && is_written; i++) {
+    replay_key_t *key = &replay->keys[i];
+    uint8_t key_code = key->key;
+    uint8_t type = key->type;
+    is_written = replay_write(replay, &key_code, sizeof(key_code)) &&
+                 replay_write(replay, &type, sizeof(type)) &&
+                 replay_write(replay, &key->held_time, sizeof(key->held_time));
+  }
+  uint8_t state_code = game_state;
+  is_written = is_written &&
+               replay_write(replay, &state_code, sizeof(state_code)) &&
+               replay_write(replay, &hash, sizeof(hash));
+  replay->keys_size = 0;
+  if (is_written) {
+    replay->ticks++;
+  }
+  return is_written;
+}
+
+bool replay_play_tick(replay_t *replay, key_handler_t handler,
+                      state_t *state) {
+  assert(!replay->is_recording);
+  uint32_t keys_size;
+  if (!replay_read(replay, &keys_size, sizeof(keys_size))) {
+    return false;
+  }
+  replay->keys_size = 0;
+  for (size_t i = 0; i < keys_size; i++) {
+    uint8_t key_code;
+    uint8_t type;
+    double held_time;
+    if (!replay_read(replay, &key_code, sizeof(key_code)) ||
+        !replay_read(replay, &type, sizeof(type)) ||
+        !replay_read(replay, &held_time, sizeof(held_time))) {
+      return false;
+    }
+    replay_push_key(replay, (replay_key_t){.key = key_code,
+                                           .type = type,
+                                           .held_time = held_time});
+  }
+  uint8_t state_code;
+  if (!replay_read(replay, &state_code, sizeof(state_code)) ||
+      !replay_read(replay, &replay->expected_hash,
+                   sizeof(replay->expected_hash))) {
+    return false;
+  }
+  replay->expected_state = state_code;
+
+  // Only dispatch once the whole record has been read, so a truncated file
+  // never plays half a tick
+  for (size_t i = 0; i < replay->keys_size; i++) {
+    replay_key_t *key = &replay->keys[i];
+    handler(key->key, key->type, key->held_time, state);
+  }
+  return true;
+}
+
+bool replay_check_tick(replay_t *replay, game_state_t game_state,
+                       uint64_t hash) {
+  assert(!replay->is_recording);
+  size_t tick = replay->ticks;
+  replay->ticks++;
+  if (game_state == replay->expected_state && hash == replay->expected_hash) {
+    return true;
+  }
+  if (replay->divergences == 0) {
+    replay->first_divergence = tick;
+    fprintf(stderr,
+            "replay: diverged at tick %zu: state %d (recorded %d), "
+            "hash %016llx (recorded %016llx)\n",
+            tick, game_state, replay->expected_state,
+            (unsigned long long)hash,
+            (unsigned long long)replay->expected_hash);
+  }
+  replay->divergences++;
+  return false;
+}
+
+void replay_print_summary(replay_t *replay) {
+  if (replay->is_recording) {
+    printf("replay: recorded %zu ticks, seed %llu\n", replay->ticks,
+           (unsigned long long)replay->seed);
+  } else if (replay->divergences == 0) {
+    printf("replay: played %zu ticks, all matched\n", replay->ticks);
+  } else {
+    printf("replay: played %zu ticks, %zu diverged (first at tick %zu)\n",
+           replay->ticks, replay->divergences, replay->first_divergence);
+  }
+}
@@ -0,0 +1,55 @@
+#include "rng.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+const uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+
+typedef struct rng {
+  uint64_t state;
+  // Always odd; picks which sequence the generator walks
+  uint64_t increment;
+} rng_t;
+
+rng_t *rng_init(uint64_t seed, uint64_t stream) {
+  rng_t *rng = malloc(sizeof(rng_t));
+  assert(rng != NULL);
+  rng->increment = (stream << 1) | 1;
+  rng_seed(rng, seed);
+  return rng;
+}
+
+void rng_free(rng_t *rng) { free(rng); }
+
+void rng_seed(rng_t *rng, uint64_t seed) {
+  rng->state = 0;
+  rng_next(rng);
+  rng->state += seed;
+  rng_next(rng);
+}
+
+uint64_t rng_get_state(rng_t *rng) { return rng->state; }
+
+void rng_set_state(rng_t *rng, uint64_t state) { rng->state = state; }
+
+uint32_t rng_next(rng_t *rng) {
+  uint64_t old = rng->state;
+  rng->state = old * PCG_MULTIPLIER + rng->increment;
+  uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+  uint32_t rotation = old >> 59;
+  return (xorshifted >> rotation) | (xorshifted << ((-rotation) & 31));
+}
+
+uint32_t rng_below(rng_t *rng, uint32_t bound) {
+  assert(bound > 0);
+  // Reject the few values at the bottom that would make some results likelier
+  uint32_t threshold = -bound % bound;
+  while (true) {
+    uint32_t value = rng_next(rng);
+    if (value >= threshold) {
+      return value % bound;
+    }
+  }
+}
+
+double rng_double(rng_t *rng) { return rng_next(rng) / 4294967296.0; }
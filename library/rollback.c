@@ -0,0 +1,234 @@
+#include "rollback.h"
+#include "runtime.h"
+#include "snapshot.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+const size_t ROLLBACK_PLAYERS = 2;
+// Room for one snapshot of a full map before it first grows
+const size_t ROLLBACK_SNAPSHOT_SIZE = 1 << 15;
+// Marks empty input slots, and that no rollback is pending
+const size_t NO_TICK = SIZE_MAX;
+
+typedef struct rollback {
+  state_t *state;
+  size_t local_player;
+  size_t input_delay;
+  size_t max_rollback;
+
+  // The next tick to simulate; every earlier tick has been simulated
+  size_t tick;
+  // The first tick whose remote input has not arrived
+  size_t confirmed;
+  // The earliest simulated tick whose remote input was mispredicted
+  size_t rollback_from;
+
+  // Input rings indexed by tick % inputs_size. Each slot is stamped with
+  // the tick it holds, so stale slots from an earlier lap are never read.
+  size_t inputs_size;
+  uint8_t *local_inputs;
+  size_t *local_ticks;
+  uint8_t *remote_inputs;
+  size_t *remote_ticks;
+  // The remote input each simulated tick actually used, real or predicted
+  uint8_t *remote_used;
+
+  // snapshots[tick % (max_rollback + 1)] is the match just before tick
+  snapshot_t **snapshots;
+
+  rollback_stats_t stats;
+} rollback_t;
+
+rollback_t *rollback_init(game_state_t map, uint64_t seed, size_t local_player,
+                          size_t input_delay, size_t max_rollback) {
+  assert(local_player < ROLLBACK_PLAYERS);
+  assert(max_rollback > 0);
+  rollback_t *rollback = malloc(sizeof(rollback_t));
+  assert(rollback != NULL);
+  // The other side may run max_rollback ticks past our last input, which is
+  // input_delay ticks ahead, and schedule its own input_delay ticks further.
+  // Inputs are also read back max_rollback + 1 ticks into the past.
+  size_t inputs_size = 2 * (max_rollback + input_delay) + 4;
+  *rollback = (rollback_t){
+      .state = match_init(map, seed),
+      .local_player = local_player,
+      .input_delay = input_delay,
+      .max_rollback = max_rollback,
+      .tick = 0,
+      .confirmed = input_delay,
+      .rollback_from = NO_TICK,
+      .inputs_size = inputs_size,
+      .local_inputs = calloc(inputs_size, sizeof(uint8_t)),
+      .local_ticks = malloc(inputs_size * sizeof(size_t)),
+      .remote_inputs = calloc(inputs_size, sizeof(uint8_t)),
+      .remote_ticks = malloc(inputs_size * sizeof(size_t)),
+      .remote_used = calloc(inputs_size, sizeof(uint8_t)),
+      .snapshots = malloc((max_rollback + 1) * sizeof(snapshot_t *)),
+      .stats = {0}};
+  assert(rollback->local_inputs != NULL);
+  assert(rollback->local_ticks != NULL);
+  assert(rollback->remote_inputs != NULL);
+  assert(rollback->remote_ticks != NULL);
+  assert(rollback->remote_used != NULL);
+  assert(rollback->snapshots != NULL);
+
+  // Nobody can give an input for the first input_delay ticks, so both sides
+  // start them with nothing held
+  for (size_t i = 0; i < inputs_size; i++) {
+    rollback->local_ticks[i] = i < input_delay ? i : NO_TICK;
+    rollback->remote_ticks[i] = i < input_delay ? i : NO_TICK;
+  }
+  for (size_t i = 0; i <= max_rollback; i++) {
+    rollback->snapshots[i] = snapshot_init(ROLLBACK_SNAPSHOT_SIZE);
+  }
+  return rollback;
+}
+
+void rollback_free(rollback_t *rollback) {
+  for (size_t i = 0; i <= rollback->max_rollback; i++) {
+    snapshot_free(rollback->snapshots[i]);
+  }
+  free(rollback->snapshots);
+  free(rollback->local_inputs);
+  free(rollback->local_ticks);
+  free(rollback->remote_inputs);
+  free(rollback->remote_ticks);
+  free(rollback->remote_used);
+  match_free(rollback->state);
+  free(rollback);
+}
+
+size_t rollback_get_tick(rollback_t *rollback) { return rollback->tick; }
+
+size_t rollback_get_confirmed_tick(rollback_t *rollback) {
+  return rollback->confirmed;
+}
+
+state_t *rollback_get_state(rollback_t *rollback) { return rollback->state; }
+
+rollback_stats_t rollback_get_stats(rollback_t *rollback) {
+  return rollback->stats;
+}
+
+size_t rollback_add_local_input(rollback_t *rollback, uint8_t actions) {
+  size_t tick = rollback->tick + rollback->input_delay;
+  size_t slot = tick % rollback->inputs_size;
+  if (rollback->local_ticks[slot] != tick) {
+    rollback->local_inputs[slot] = actions;
+    rollback->local_ticks[slot] = tick;
+  }
+  return tick;
+}
+
+void rollback_add_remote_input(rollback_t *rollback, size_t tick,
+                               uint8_t actions) {
+  // Duplicates, and inputs too far ahead to have come from a well-behaved
+  // peer, are dropped
+  if (tick < rollback->confirmed ||
+      tick >= rollback->tick + rollback->max_rollback +
+                  2 * rollback->input_delay + 2) {
+    return;
+  }
+  size_t slot = tick % rollback->inputs_size;
+  if (rollback->remote_ticks[slot] == tick) {
+    return;
+  }
+  rollback->remote_inputs[slot] = actions;
+  rollback->remote_ticks[slot] = tick;
+
+  if (tick < rollback->tick && rollback->remote_used[slot] != actions &&
+      (rollback->rollback_from == NO_TICK ||
+       tick < rollback->rollback_from)) {
+    rollback->rollback_from = tick;
+  }
+  while (rollback->remote_ticks[rollback->confirmed % rollback->inputs_size] ==
+         rollback->confirmed) {
+    rollback->confirmed++;
+  }
+}
+
+/** Simulates one tick from the snapshot taken just before it */
+void rollback_simulate(rollback_t *rollback, size_t tick, double dt) {
+  size_t slot = tick % rollback->inputs_size;
+  size_t previous_slot = (tick + rollback->inputs_size - 1) %
+                         rollback->inputs_size;
+  assert(rollback->local_ticks[slot] == tick);
+
+  // Unknown remote inputs repeat the one used on the tick before
+  uint8_t remote_previous = tick > 0 ? rollback->remote_used[previous_slot] : 0;
+  rollback->remote_used[slot] = rollback->remote_ticks[slot] == tick
+                                    ? rollback->remote_inputs[slot]
+                                    : remote_previous;
+  uint8_t local_previous = tick > 0 ? rollback->local_inputs[previous_slot] : 0;
+
+  snapshot_t *snapshot =
+      rollback->snapshots[tick % (rollback->max_rollback + 1)];
+  match_save(rollback->state, snapshot);
+  if (match_is_over(rollback->state)) {
+    return;
+  }
+  size_t remote_player = 1 - rollback->local_player;
+  match_actions(rollback->state, rollback->local_player, local_previous,
+                rollback->local_inputs[slot]);
+  match_actions(rollback->state, remote_player, remote_previous,
+                rollback->remote_used[slot]);
+  match_step(rollback->state, dt);
+}
+
+void rollback_sync(rollback_t *rollback, double dt) {
+  if (rollback->rollback_from == NO_TICK) {
+    return;
+  }
+  size_t from = rollback->rollback_from;
+  rollback->rollback_from = NO_TICK;
+  assert(from + rollback->max_rollback >= rollback->tick);
+
+  double start = runtime_now();
+  snapshot_t *snapshot =
+      rollback->snapshots[from % (rollback->max_rollback + 1)];
+  bool restored = match_restore(rollback->state, snapshot);
+  assert(restored);
+  for (size_t tick = from; tick < rollback->tick; tick++) {
+    rollback_simulate(rollback, tick, dt);
+  }
+  double elapsed = runtime_now() - start;
+
+  size_t resimulated = rollback->tick - from;
+  rollback_stats_t *stats = &rollback->stats;
+  stats->rollbacks++;
+  stats->resimulated_ticks += resimulated;
+  stats->resimulation_time += elapsed;
+  if (resimulated > stats->max_rollback_ticks) {
+    stats->max_rollback_ticks = resimulated;
+  }
+  if (elapsed > stats->max_rollback_time) {
+    stats->max_rollback_time = elapsed;
+  }
+}
+
+bool rollback_advance(rollback_t *rollback, double dt) {
+  rollback_sync(rollback, dt);
+  // Past this point a late input would need a snapshot already overwritten
+  if (rollback->tick + 1 > rollback->confirmed + rollback->max_rollback) {
+    rollback->stats.stalls++;
+    return false;
+  }
+  rollback_simulate(rollback, rollback->tick, dt);
+  rollback->tick++;
+  rollback->stats.ticks++;
+  return true;
+}
+
+void rollback_print_stats(rollback_t *rollback) {
+  rollback_stats_t *stats = &rollback->stats;
+  double per_tick = stats->resimulated_ticks > 0
+                        ? stats->resimulation_time / stats->resimulated_ticks
+                        : 0;
+  printf("rollback: %zu ticks, %zu rollbacks, %zu ticks resimulated "
+         "(most %zu at once), %zu stalls\n",
+         stats->ticks, stats->rollbacks, stats->resimulated_ticks,
+         stats->max_rollback_ticks, stats->stalls);
+  printf("rollback: %.1f us per resimulated tick, longest rollback %.3f ms\n",
+         per_tick * 1e6, stats->max_rollback_time * 1e3);
+}
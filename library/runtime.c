@@ -0,0 +1,21 @@
+#include "runtime.h"
+#include <stdlib.h>
+#include <time.h>
+
+const double RUNTIME_TICK_DT = 1.0 / 60.0;
+
+double runtime_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+size_t runtime_env(const char *name, size_t fallback) {
+  const char *value = getenv(name);
+  return value != NULL ? strtoul(value, NULL, 10) : fallback;
+}
+
+double runtime_env_double(const char *name, double fallback) {
+  const char *value = getenv(name);
+  return value != NULL ? strtod(value, NULL) : fallback;
+}
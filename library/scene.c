@@ -1,17 +1,49 @@
 #include "scene.h"
+#include "arena.h"
 #include "game.h"
+#include "jobs.h"
+#include "pool.h"
+#include "projectile.h"
+#include "rng.h"
+#include "snapshot.h"
 #include <assert.h>
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 const size_t INITIAL_CAPACITY_S = 20;
+const size_t INITIAL_POOLS = 2;
+const size_t INITIAL_PROJECTILES = 64;
+const size_t INITIAL_TYPE_CAPACITY = 4;
+// Smallest number of bodies or binds worth handing to another thread
+const size_t TICK_JOB_GRAIN = 32;
+// Slot 0 is never handed out, so BODY_HANDLE_NONE never resolves
+const size_t FIRST_GENERATION = 1;
+// Most body types a loaded scene may index; a saved type past it can only
+// come from corrupt bytes
+const size_t MAX_LOADED_TYPES = 256;
+
+// BODY SLOT DEFINITION
+typedef struct body_slot {
+  body_t *body;
+  size_t generation;
+  // Axis-aligned bounds of the body, refreshed at the start of each tick
+  vector_t min;
+  vector_t max;
+} body_slot_t;
+// END OF BODY SLOT DEFINITION
 
 // FORCE BIND DEFINITION AND FUNCTIONS
 typedef struct force_bind {
+  force_creator_t prepare;
   force_creator_t force_function;
   void *aux;
   list_t *body_targets;
+  // target_slots[i] is this bind's index in body_targets[i]'s bind list
+  size_t *target_slots;
   free_func_t freer;
+  bool is_removed;
+  scene_t *scene;
 } force_bind_t;
 
 void force_bind_free(force_bind_t *force_bind) {
@@ -19,23 +51,59 @@ void force_bind_free(force_bind_t *force_bind) {
     force_bind->freer(force_bind->aux);
   }
   if (force_bind->body_targets != NULL) {
+    scene_release(force_bind->scene, force_bind->target_slots,
+                  list_size(force_bind->body_targets) * sizeof(size_t));
     list_free(force_bind->body_targets);
   }
-  free(force_bind);
+  scene_release(force_bind->scene, force_bind, sizeof(force_bind_t));
 }
 
 bool bind_is_removed(force_bind_t *force_bind) {
-  if (force_bind->body_targets == NULL) {
-    return false;
+  return force_bind->is_removed;
+}
+
+/** Unlinks force_bind from the bind list of its target at target_idx */
+void bind_detach(force_bind_t *force_bind, size_t target_idx) {
+  body_t *body = list_get(force_bind->body_targets, target_idx);
+  list_t *body_binds = body_get_binds(body);
+  size_t slot = force_bind->target_slots[target_idx];
+  list_swap_remove(body_binds, slot);
+  if (slot == list_size(body_binds)) {
+    return;
   }
-  for (size_t j = 0; j < list_size(force_bind->body_targets); j++) {
-    body_t *body = list_get(force_bind->body_targets, j);
-    if (body_is_removed(body)) {
-      return true;
+
+  // Another bind was moved into the freed slot; fix its back-reference
+  force_bind_t *moved = list_get(body_binds, slot);
+  for (size_t i = 0; i < list_size(moved->body_targets); i++) {
+    if (list_get(moved->body_targets, i) == body &&
+        moved->target_slots[i] == list_size(body_binds)) {
+      moved->target_slots[i] = slot;
+      break;
     }
   }
+}
 
-  return false;
+/**
+ * Marks every bind referencing a removed body as removed and unlinks it from
+ * the bind lists of its other targets. Returns the number of binds marked.
+ */
+size_t body_retire_binds(body_t *body) {
+  list_t *body_binds = body_get_binds(body);
+  size_t retired = 0;
+  for (size_t i = 0; i < list_size(body_binds); i++) {
+    force_bind_t *force_bind = list_get(body_binds, i);
+    if (force_bind->is_removed) {
+      continue;
+    }
+    force_bind->is_removed = true;
+    retired++;
+    for (size_t j = 0; j < list_size(force_bind->body_targets); j++) {
+      if (list_get(force_bind->body_targets, j) != body) {
+        bind_detach(force_bind, j);
+      }
+    }
+  }
+  return retired;
 }
 // END OF FORCE_BIND DEFINITION
 
@@ -43,27 +111,228 @@ typedef struct scene {
   list_t *bodies;
   list_t *force_binds;
   list_t *list_of_sprites;
+  body_slot_t *slots;
+  size_t slots_size;
+  size_t slots_capacity;
+  size_t *free_slots;
+  size_t free_slots_size;
+  list_t *pools;
+  // Non-owning lists of the bodies and sprites of each body_type_t, in the
+  // same order as the main lists
+  list_t **bodies_by_type;
+  list_t **sprites_by_type;
+  size_t types_size;
+  projectiles_t *projectiles;
+  rng_t *rngs[RNG_STREAMS];
+  jobs_t *jobs;
+  arena_t *arena;
 } scene_t;
 
-scene_t *scene_init(void) {
+scene_t *scene_init_arena(arena_t *arena) {
   scene_t *scene = malloc(sizeof(scene_t));
-  *scene =
-      (scene_t){.bodies = list_init(INITIAL_CAPACITY_S, (free_func_t)body_free),
-                .force_binds =
-                    list_init(INITIAL_CAPACITY_S, (free_func_t)force_bind_free),
-                .list_of_sprites =
-                    list_init(INITIAL_CAPACITY_S, (free_func_t)sprite_free)};
   assert(scene != NULL);
+  *scene = (scene_t){
+      .bodies = list_init_arena(arena, INITIAL_CAPACITY_S,
+                                (free_func_t)body_free),
+      .force_binds = list_init_arena(arena, INITIAL_CAPACITY_S,
+                                     (free_func_t)force_bind_free),
+      .list_of_sprites =
+          list_init_arena(arena, INITIAL_CAPACITY_S, (free_func_t)sprite_free),
+      .slots = malloc(INITIAL_CAPACITY_S * sizeof(body_slot_t)),
+      .slots_size = 1,
+      .slots_capacity = INITIAL_CAPACITY_S,
+      .free_slots = malloc(INITIAL_CAPACITY_S * sizeof(size_t)),
+      .free_slots_size = 0,
+      .pools = list_init_arena(arena, INITIAL_POOLS,
+                               arena != NULL ? NULL : (free_func_t)pool_free),
+      .bodies_by_type = NULL,
+      .sprites_by_type = NULL,
+      .types_size = 0,
+      .projectiles = projectiles_init(INITIAL_PROJECTILES),
+      .jobs = NULL,
+      .arena = arena};
+  assert(scene->slots != NULL);
+  assert(scene->free_slots != NULL);
+  scene->slots[0] = (body_slot_t){.body = NULL, .generation = 0};
+  for (size_t i = 0; i < RNG_STREAMS; i++) {
+    scene->rngs[i] = rng_init(0, i);
+  }
 
   return scene;
 }
 
+scene_t *scene_init(void) { return scene_init_arena(NULL); }
+
+scene_t *scene_init_with_arena(size_t arena_block_size) {
+  return scene_init_arena(arena_init(arena_block_size));
+}
+
+arena_t *scene_get_arena(scene_t *scene) { return scene->arena; }
+
+projectiles_t *scene_get_projectiles(scene_t *scene) {
+  return scene->projectiles;
+}
+
+void scene_seed(scene_t *scene, uint64_t seed) {
+  for (size_t i = 0; i < RNG_STREAMS; i++) {
+    rng_seed(scene->rngs[i], seed);
+  }
+}
+
+rng_t *scene_get_rng(scene_t *scene, rng_stream_t stream) {
+  assert(stream < RNG_STREAMS);
+  return scene->rngs[stream];
+}
+
+void scene_set_jobs(scene_t *scene, jobs_t *jobs) { scene->jobs = jobs; }
+
+jobs_t *scene_get_jobs(scene_t *scene) { return scene->jobs; }
+
+void *scene_alloc(scene_t *scene, size_t size) {
+  void *memory = scene->arena != NULL ? arena_alloc(scene->arena, size)
+                                      : malloc(size);
+  assert(memory != NULL);
+  return memory;
+}
+
+void scene_release(scene_t *scene, void *memory, size_t size) {
+  if (scene->arena != NULL) {
+    arena_release(scene->arena, memory, size);
+  } else {
+    free(memory);
+  }
+}
+
+void scene_add_pool(scene_t *scene, pool_t *pool) {
+  list_add(scene->pools, pool);
+}
+
+pool_t *scene_get_pool(scene_t *scene, size_t index) {
+  if (index >= list_size(scene->pools)) {
+    return NULL;
+  }
+  return list_get(scene->pools, index);
+}
+
+/** Hands out a slot for body and stamps the body with its new handle */
+void scene_acquire_slot(scene_t *scene, body_t *body) {
+  size_t index;
+  if (scene->free_slots_size > 0) {
+    scene->free_slots_size--;
+    index = scene->free_slots[scene->free_slots_size];
+  } else {
+    if (scene->slots_size >= scene->slots_capacity) {
+      scene->slots_capacity *= 2;
+      scene->slots =
+          realloc(scene->slots, scene->slots_capacity * sizeof(body_slot_t));
+      scene->free_slots =
+          realloc(scene->free_slots, scene->slots_capacity * sizeof(size_t));
+      assert(scene->slots != NULL);
+      assert(scene->free_slots != NULL);
+    }
+    index = scene->slots_size;
+    scene->slots_size++;
+    scene->slots[index].generation = FIRST_GENERATION;
+  }
+
+  scene->slots[index].body = body;
+  body_set_handle(body, (body_handle_t){.index = index,
+                                        .generation =
+                                            scene->slots[index].generation});
+}
+
+/** Frees body's slot; bumping the generation invalidates old handles */
+void scene_release_slot(scene_t *scene, body_t *body) {
+  body_handle_t handle = body_get_handle(body);
+  assert(scene_resolve(scene, handle) == body);
+  scene->slots[handle.index].body = NULL;
+  scene->slots[handle.index].generation++;
+  scene->free_slots[scene->free_slots_size] = handle.index;
+  scene->free_slots_size++;
+  body_set_handle(body, BODY_HANDLE_NONE);
+}
+
+body_t *scene_resolve(scene_t *scene, body_handle_t handle) {
+  if (handle.index >= scene->slots_size ||
+      scene->slots[handle.index].generation != handle.generation) {
+    return NULL;
+  }
+  return scene->slots[handle.index].body;
+}
+
+/** Makes room in the type index for every type up to and including type */
+void scene_reserve_type(scene_t *scene, size_t type) {
+  if (type < scene->types_size) {
+    return;
+  }
+  size_t types_size = type + 1;
+  scene->bodies_by_type =
+      realloc(scene->bodies_by_type, types_size * sizeof(list_t *));
+  scene->sprites_by_type =
+      realloc(scene->sprites_by_type, types_size * sizeof(list_t *));
+  assert(scene->bodies_by_type != NULL);
+  assert(scene->sprites_by_type != NULL);
+  for (size_t i = scene->types_size; i < types_size; i++) {
+    scene->bodies_by_type[i] =
+        list_init_arena(scene->arena, INITIAL_TYPE_CAPACITY, NULL);
+    scene->sprites_by_type[i] =
+        list_init_arena(scene->arena, INITIAL_TYPE_CAPACITY, NULL);
+  }
+  scene->types_size = types_size;
+}
+
+/**
+ * Looks up a body's type and makes room for it in the type index.
+ * Returns false for bodies without info, which are not indexed.
+ */
+bool scene_index_type(scene_t *scene, body_t *body, body_type_t *type) {
+  body_info_t *info = body_get_info(body);
+  if (info == NULL) {
+    return false;
+  }
+  scene_reserve_type(scene, info->type);
+  *type = info->type;
+  return true;
+}
+
+size_t scene_count_type(scene_t *scene, body_type_t type) {
+  if (type >= scene->types_size) {
+    return 0;
+  }
+  return list_size(scene->bodies_by_type[type]);
+}
+
+body_t *scene_first_of_type(scene_t *scene, body_type_t type) {
+  if (scene_count_type(scene, type) == 0) {
+    return NULL;
+  }
+  return list_get(scene->bodies_by_type[type], 0);
+}
+
+sprite_t *scene_first_sprite_of_type(scene_t *scene, body_type_t type) {
+  if (type >= scene->types_size ||
+      list_size(scene->sprites_by_type[type]) == 0) {
+    return NULL;
+  }
+  return list_get(scene->sprites_by_type[type], 0);
+}
+
+bool scene_bounds_overlap(scene_t *scene, body_t *body1, body_t *body2) {
+  body_slot_t *slot1 = &scene->slots[body_get_handle(body1).index];
+  body_slot_t *slot2 = &scene->slots[body_get_handle(body2).index];
+  return slot1->min.x <= slot2->max.x && slot2->min.x <= slot1->max.x &&
+         slot1->min.y <= slot2->max.y && slot2->min.y <= slot1->max.y;
+}
+
 void sprite_list_init(scene_t *scene) {
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    if (((body_info_t *)body_get_info(body))->type != GRAVITY) {
-      sprite_t *new_sprite = sprite_init(body);
+    body_type_t type = ((body_info_t *)body_get_info(body))->type;
+    // Powerups and lives get their sprites from sprite_img_add()
+    if (type != GRAVITY && type != POWERUP_RICOCHET &&
+        type != POWERUP_SHOTGUN && type != P1_LIFE && type != P2_LIFE) {
+      sprite_t *new_sprite = sprite_init(scene, body);
       scene_add_sprite(scene, new_sprite);
     }
   }
@@ -78,9 +347,29 @@ void sprite_list_update(scene_t *scene) {
 }
 
 void scene_free(scene_t *scene) {
-  list_free(scene->bodies);
-  list_free(scene->force_binds);
-  list_free(scene->list_of_sprites);
+  // Everything in an arena scene lives in the arena, so only sprites, which
+  // give back the textures they borrowed, need to be visited one by one
+  if (scene->arena != NULL) {
+    list_free(scene->list_of_sprites);
+    arena_free(scene->arena);
+  } else {
+    list_free(scene->bodies);
+    list_free(scene->force_binds);
+    list_free(scene->list_of_sprites);
+    list_free(scene->pools);
+    for (size_t i = 0; i < scene->types_size; i++) {
+      list_free(scene->bodies_by_type[i]);
+      list_free(scene->sprites_by_type[i]);
+    }
+  }
+  free(scene->bodies_by_type);
+  free(scene->sprites_by_type);
+  projectiles_free(scene->projectiles);
+  for (size_t i = 0; i < RNG_STREAMS; i++) {
+    rng_free(scene->rngs[i]);
+  }
+  free(scene->slots);
+  free(scene->free_slots);
   free(scene);
 }
 
@@ -92,7 +381,12 @@ body_t *scene_get_body(scene_t *scene, size_t index) {
 }
 
 void scene_add_body(scene_t *scene, body_t *body) {
+  scene_acquire_slot(scene, body);
   list_add(scene->bodies, body);
+  body_type_t type;
+  if (scene_index_type(scene, body, &type)) {
+    list_add(scene->bodies_by_type[type], body);
+  }
 }
 
 void scene_remove_body(scene_t *scene, size_t index) {
@@ -100,10 +394,24 @@ void scene_remove_body(scene_t *scene, size_t index) {
 }
 void scene_add_sprite(scene_t *scene, sprite_t *sprite) {
   list_add(scene->list_of_sprites, sprite);
+  body_type_t type;
+  if (scene_index_type(scene, sprite_get_body(sprite), &type)) {
+    list_add(scene->sprites_by_type[type], sprite);
+  }
 }
 
 void scene_remove_sprite(scene_t *scene, size_t index) {
-  sprite_free((sprite_t *)list_remove(scene->list_of_sprites, index));
+  sprite_t *sprite = list_remove(scene->list_of_sprites, index);
+  for (size_t i = 0; i < scene->types_size; i++) {
+    list_t *by_type = scene->sprites_by_type[i];
+    for (size_t j = 0; j < list_size(by_type); j++) {
+      if (list_get(by_type, j) == sprite) {
+        list_remove(by_type, j);
+        break;
+      }
+    }
+  }
+  sprite_free(sprite);
 }
 
 list_t *scene_get_sprites(scene_t *scene) { return scene->list_of_sprites; }
@@ -113,58 +421,309 @@ sprite_t *scene_get_sprite(scene_t *scene, size_t index) {
   return (sprite_t *)(list_get(scene->list_of_sprites, index));
 }
 
-void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
-                                    void *aux, list_t *bodies,
-                                    free_func_t freer) {
-  force_bind_t *force_bind = malloc(sizeof(force_bind_t));
+void scene_add_prepared_force_creator(scene_t *scene, force_creator_t prepare,
+                                      force_creator_t forcer, void *aux,
+                                      list_t *bodies, free_func_t freer) {
+  force_bind_t *force_bind = scene_alloc(scene, sizeof(force_bind_t));
+  force_bind->prepare = prepare;
   force_bind->aux = aux;
   force_bind->body_targets = bodies;
+  force_bind->target_slots = NULL;
   force_bind->freer = freer;
   force_bind->force_function = forcer;
+  force_bind->is_removed = false;
+  force_bind->scene = scene;
+
+  // Register the bind with each target so removal can find it directly
+  if (bodies != NULL) {
+    force_bind->target_slots =
+        scene_alloc(scene, list_size(bodies) * sizeof(size_t));
+    for (size_t i = 0; i < list_size(bodies); i++) {
+      list_t *body_binds = body_get_binds(list_get(bodies, i));
+      force_bind->target_slots[i] = list_size(body_binds);
+      list_add(body_binds, force_bind);
+    }
+  }
   list_add(scene->force_binds, force_bind);
 }
 
+void scene_add_bodies_force_creator(scene_t *scene, force_creator_t forcer,
+                                    void *aux, list_t *bodies,
+                                    free_func_t freer) {
+  scene_add_prepared_force_creator(scene, NULL, forcer, aux, bodies, freer);
+}
+
 void scene_add_force_creator(scene_t *scene, force_creator_t forcer, void *aux,
                              free_func_t freer) {
   scene_add_bodies_force_creator(scene, forcer, aux, NULL, freer);
 }
 
+typedef struct tick_job {
+  scene_t *scene;
+  double dt;
+} tick_job_t;
+
+/** Broadphase: refreshes the bounds of every live body */
+void scene_bounds_job(tick_job_t *job, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    body_slot_t *slot = &job->scene->slots[i];
+    if (slot->body == NULL) {
+      continue;
+    }
+    list_t *shape = body_get_vertices(slot->body);
+    slot->min = (vector_t){INFINITY, INFINITY};
+    slot->max = (vector_t){-INFINITY, -INFINITY};
+    for (size_t j = 0; j < list_size(shape); j++) {
+      vector_t *vertex = list_get(shape, j);
+      slot->min = (vector_t){fmin(slot->min.x, vertex->x),
+                             fmin(slot->min.y, vertex->y)};
+      slot->max = (vector_t){fmax(slot->max.x, vertex->x),
+                             fmax(slot->max.y, vertex->y)};
+    }
+  }
+}
+
+/** Narrowphase: lets each bind precompute what only reads its bodies */
+void scene_prepare_job(tick_job_t *job, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    force_bind_t *force_bind = list_get(job->scene->force_binds, i);
+    if (force_bind->prepare != NULL) {
+      force_bind->prepare(force_bind->aux);
+    }
+  }
+}
+
+/** Integration: each body only touches its own state */
+void scene_integrate_job(tick_job_t *job, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    body_tick(list_get(job->scene->bodies, i), job->dt);
+  }
+}
+
 void scene_tick(scene_t *scene, double dt) {
+  // Shapes do not move until integration, so bounds and collision tests
+  // taken now hold for the whole force phase. The parallel phases only
+  // write to their own slot, bind or body, and everything order-dependent
+  // runs serially below, so the result does not depend on thread count.
+  tick_job_t job = {.scene = scene, .dt = dt};
+  jobs_parallel_for(scene->jobs, scene->slots_size, TICK_JOB_GRAIN,
+                    (job_func_t)scene_bounds_job, &job);
+  jobs_parallel_for(scene->jobs, list_size(scene->force_binds),
+                    TICK_JOB_GRAIN, (job_func_t)scene_prepare_job, &job);
 
-  // Execute all forces in scene
+  // Forces accumulate and collision handlers fire in bind order
   for (size_t i = 0; i < list_size(scene->force_binds); i++) {
     force_bind_t *force_bind = (force_bind_t *)list_get(scene->force_binds, i);
     force_bind->force_function(force_bind->aux);
   }
+  // Projectiles collide at the same point as force creators, so anything
+  // they hit is removed in this tick's pass below
+  projectiles_tick(scene->projectiles, scene, dt);
 
-  // Remove force binds if body is_removed == true
-  for (int i = 0; i < list_size(scene->force_binds); i++) {
-    force_bind_t *force_bind = (force_bind_t *)list_get(scene->force_binds, i);
-    if (bind_is_removed(force_bind)) {
-      force_bind_free(list_remove(scene->force_binds, i));
-      i -= 1; // fix current index after removal of item from list
+  // Removal is deferred until every force has run. Binds are retired through
+  // the removed bodies that reference them, then each list is compacted in
+  // one pass. Sprites go before bodies since they dereference them.
+  size_t removed_bodies = 0;
+  size_t retired_binds = 0;
+  for (size_t i = 0; i < list_size(scene->bodies); i++) {
+    body_t *body = (body_t *)list_get(scene->bodies, i);
+    if (body_is_removed(body)) {
+      removed_bodies++;
+      retired_binds += body_retire_binds(body);
+      scene_release_slot(scene, body);
+    }
+  }
+  if (retired_binds > 0) {
+    list_remove_if(scene->force_binds, (list_pred_t)bind_is_removed);
+  }
+  if (removed_bodies > 0) {
+    for (size_t i = 0; i < scene->types_size; i++) {
+      list_remove_if(scene->sprites_by_type[i],
+                     (list_pred_t)sprite_is_removed);
+      list_remove_if(scene->bodies_by_type[i], (list_pred_t)body_is_removed);
     }
+    list_remove_if(scene->list_of_sprites, (list_pred_t)sprite_is_removed);
+    list_remove_if(scene->bodies, (list_pred_t)body_is_removed);
   }
 
-  // Remove bodies where is_removed == true and have a sprite
-  for (int i = 0; i < list_size(scene->list_of_sprites); i++) {
-    sprite_t *sprite = list_get(scene->list_of_sprites, i);
-    if (sprite_is_removed(sprite)) {
-      sprite_free(list_remove(scene->list_of_sprites, i));
-      i -= 1;
+  jobs_parallel_for(scene->jobs, list_size(scene->bodies), TICK_JOB_GRAIN,
+                    (job_func_t)scene_integrate_job, &job);
+}
+
+// SNAPSHOTS
+// Slots are saved exactly, including free ones and their generations, so
+// every handle saved in binds and projectiles resolves to the same body
+// after a restore. Bodies and binds keep their order, which is the order
+// forces accumulate and collisions fire in.
+
+void scene_save(scene_t *scene, snapshot_t *snapshot) {
+  snapshot_write(snapshot, &scene->slots_size, sizeof(size_t));
+  for (size_t i = 0; i < scene->slots_size; i++) {
+    snapshot_write(snapshot, &scene->slots[i].generation, sizeof(size_t));
+  }
+  snapshot_write(snapshot, &scene->free_slots_size, sizeof(size_t));
+  snapshot_write(snapshot, scene->free_slots,
+                 scene->free_slots_size * sizeof(size_t));
+
+  size_t body_count = list_size(scene->bodies);
+  snapshot_write(snapshot, &body_count, sizeof(body_count));
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = list_get(scene->bodies, i);
+    body_handle_t handle = body_get_handle(body);
+    snapshot_write(snapshot, &handle, sizeof(handle));
+    body_info_t *info = body_get_info(body);
+    bool has_info = info != NULL;
+    snapshot_write(snapshot, &has_info, sizeof(has_info));
+    if (has_info) {
+      // Field by field, so the struct padding never reaches the snapshot
+      snapshot_write(snapshot, &info->type, sizeof(body_type_t));
+      snapshot_write(snapshot, &info->side, sizeof(side_t));
+      snapshot_write(snapshot, &info->weapon_type, sizeof(game_weapon_type_t));
+      snapshot_write(snapshot, &info->time_since_last_shot, sizeof(double));
+      snapshot_write(snapshot, &info->shots_left, sizeof(double));
     }
+    body_save(body, snapshot);
   }
 
-  // Remove bodies where is_removed == true
-  for (int i = 0; i < list_size(scene->bodies); i++) {
-    body_t *body = (body_t *)list_get(scene->bodies, i);
+  size_t bind_count = list_size(scene->force_binds);
+  snapshot_write(snapshot, &bind_count, sizeof(bind_count));
+  for (size_t i = 0; i < bind_count; i++) {
+    force_bind_t *force_bind = list_get(scene->force_binds, i);
+    size_t target_count = force_bind->body_targets != NULL
+                              ? list_size(force_bind->body_targets)
+                              : 0;
+    snapshot_write(snapshot, &target_count, sizeof(target_count));
+    for (size_t j = 0; j < target_count; j++) {
+      body_handle_t handle =
+          body_get_handle(list_get(force_bind->body_targets, j));
+      snapshot_write(snapshot, &handle.index, sizeof(size_t));
+    }
+    force_creator_save(snapshot, force_bind->force_function, force_bind->aux);
+  }
 
-    if (body_is_removed(body)) {
-      body_free(list_remove(scene->bodies, i));
-      i -= 1; // fix current index after removal of item from list
-      continue;
+  projectiles_save(scene->projectiles, snapshot);
+  for (size_t i = 0; i < RNG_STREAMS; i++) {
+    uint64_t rng_state = rng_get_state(scene->rngs[i]);
+    snapshot_write(snapshot, &rng_state, sizeof(rng_state));
+  }
+}
+
+scene_t *scene_load(snapshot_t *snapshot, size_t arena_block_size) {
+  scene_t *scene = arena_block_size > 0
+                       ? scene_init_with_arena(arena_block_size)
+                       : scene_init();
+  size_t slots_size = snapshot_read_count(snapshot, sizeof(size_t));
+  if (slots_size > scene->slots_capacity) {
+    scene->slots_capacity = slots_size;
+    scene->slots =
+        realloc(scene->slots, scene->slots_capacity * sizeof(body_slot_t));
+    scene->free_slots =
+        realloc(scene->free_slots, scene->slots_capacity * sizeof(size_t));
+    assert(scene->slots != NULL);
+    assert(scene->free_slots != NULL);
+  }
+  scene->slots_size = slots_size;
+  for (size_t i = 0; i < slots_size; i++) {
+    scene->slots[i].body = NULL;
+    snapshot_read(snapshot, &scene->slots[i].generation, sizeof(size_t));
+  }
+  scene->free_slots_size = snapshot_read_count(snapshot, sizeof(size_t));
+  if (scene->free_slots_size > slots_size) {
+    snapshot_fail(snapshot);
+    scene->free_slots_size = 0;
+  }
+  snapshot_read(snapshot, scene->free_slots,
+                scene->free_slots_size * sizeof(size_t));
+  for (size_t i = 0; i < scene->free_slots_size; i++) {
+    if (scene->free_slots[i] >= slots_size) {
+      snapshot_fail(snapshot);
+    }
+  }
+
+  size_t body_count = snapshot_read_count(snapshot, sizeof(body_handle_t));
+  for (size_t i = 0; i < body_count && !snapshot_has_failed(snapshot); i++) {
+    body_handle_t handle;
+    snapshot_read(snapshot, &handle, sizeof(handle));
+    bool has_info;
+    snapshot_read(snapshot, &has_info, sizeof(has_info));
+    body_info_t loaded_info;
+    if (has_info) {
+      snapshot_read(snapshot, &loaded_info.type, sizeof(body_type_t));
+      snapshot_read(snapshot, &loaded_info.side, sizeof(side_t));
+      snapshot_read(snapshot, &loaded_info.weapon_type,
+                    sizeof(game_weapon_type_t));
+      snapshot_read(snapshot, &loaded_info.time_since_last_shot,
+                    sizeof(double));
+      snapshot_read(snapshot, &loaded_info.shots_left, sizeof(double));
+    }
+    // Each body must fill a slot of its own, and a type the type index
+    // could not hold means the bytes are not a saved body
+    if (handle.index >= slots_size ||
+        scene->slots[handle.index].generation != handle.generation ||
+        scene->slots[handle.index].body != NULL ||
+        (has_info && (size_t)loaded_info.type >= MAX_LOADED_TYPES)) {
+      snapshot_fail(snapshot);
+      break;
+    }
+    body_info_t *info = NULL;
+    if (has_info) {
+      info = scene_alloc(scene, sizeof(body_info_t));
+      *info = loaded_info;
+    }
+    body_t *body = body_load(snapshot, scene->arena, info,
+                             scene->arena != NULL ? NULL : free);
+    scene->slots[handle.index].body = body;
+    body_set_handle(body, handle);
+    list_add(scene->bodies, body);
+    body_type_t type;
+    if (scene_index_type(scene, body, &type)) {
+      list_add(scene->bodies_by_type[type], body);
     }
+  }
+
+  size_t bind_count = snapshot_read_count(snapshot, sizeof(size_t));
+  for (size_t i = 0; i < bind_count && !snapshot_has_failed(snapshot); i++) {
+    size_t target_count = snapshot_read_count(snapshot, sizeof(size_t));
+    list_t *bodies = NULL;
+    if (target_count > 0) {
+      bodies = list_init_arena(scene->arena, target_count, NULL);
+      for (size_t j = 0; j < target_count; j++) {
+        size_t index;
+        snapshot_read(snapshot, &index, sizeof(index));
+        if (index >= slots_size || scene->slots[index].body == NULL) {
+          snapshot_fail(snapshot);
+          break;
+        }
+        list_add(bodies, scene->slots[index].body);
+      }
+    }
+    force_creator_t prepare;
+    force_creator_t forcer;
+    void *aux;
+    free_func_t freer;
+    if (snapshot_has_failed(snapshot) ||
+        !force_creator_load(snapshot, scene, &prepare, &forcer, &aux,
+                            &freer)) {
+      snapshot_fail(snapshot);
+      if (bodies != NULL) {
+        list_free(bodies);
+      }
+      break;
+    }
+    scene_add_prepared_force_creator(scene, prepare, forcer, aux, bodies,
+                                     freer);
+  }
 
-    body_tick(body, dt);
+  projectiles_restore(scene->projectiles, snapshot);
+  for (size_t i = 0; i < RNG_STREAMS; i++) {
+    uint64_t rng_state;
+    snapshot_read(snapshot, &rng_state, sizeof(rng_state));
+    rng_set_state(scene->rngs[i], rng_state);
+  }
+  if (snapshot_has_failed(snapshot)) {
+    scene_free(scene);
+    return NULL;
   }
-}
\ No newline at end of file
+  return scene;
+}
+// END OF SNAPSHOTS
@@ -0,0 +1,194 @@
+#include "sdl_wrapper.h"
+#include "list.h"
+#include "projectile.h"
+#include "rng.h"
+#include "runtime.h"
+#include "texture_cache.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * A drop-in replacement for sdl_wrapper.c that opens no window or audio
+ * device and loads no textures. Link it instead of sdl_wrapper.c (and
+ * headless.c instead of emscripten.c) to run matches on machines without a
+ * display. Only SDL's headers are needed, for the types in sdl_wrapper.h and
+ * sprites.h; nothing here calls into SDL.
+ *
+ * Key events come from the script named by HEADLESS_SCRIPT, one event per
+ * line: "<tick> <key> <press|release>". Keys are a single character or one
+ * of left, up, right, down, space, period. Lines starting with # are
+ * ignored. Replays recorded with REPLAY_RECORD play back as usual.
+ */
+
+const int WINDOW_WIDTH = 1000;
+const int WINDOW_HEIGHT = 500;
+const size_t MAX_SCRIPT_LINE = 64;
+
+typedef struct key_name {
+  const char *name;
+  char key;
+} key_name_t;
+
+const key_name_t KEY_NAMES[] = {
+    {"left", LEFT_ARROW}, {"up", UP_ARROW},       {"right", RIGHT_ARROW},
+    {"down", DOWN_ARROW}, {"space", SPACE},       {"period", PERIOD},
+    {"w", W_KEY},         {"a", A_KEY},           {"s", S_KEY},
+    {"d", D_KEY},         {"1", ONE},             {"2", TWO},
+    {"3", THREE}};
+
+/**
+ * The coordinate at the center of the screen.
+ */
+vector_t center;
+/**
+ * The coordinate difference from the center to the top right corner.
+ */
+vector_t max_diff;
+/**
+ * The keypress handler, or NULL if none has been configured.
+ */
+key_handler_t key_handler = NULL;
+/**
+ * The input script, or NULL if there is none or it has been read to the end.
+ */
+FILE *script = NULL;
+bool script_opened = false;
+/**
+ * The number of times sdl_is_done() has been called, which is the tick the
+ * next script events belong to.
+ */
+size_t script_tick = 0;
+
+vector_t get_window_center(void) {
+  vector_t dimensions = {.x = WINDOW_WIDTH, .y = WINDOW_HEIGHT};
+  return vec_multiply(0.5, dimensions);
+}
+
+double get_scene_scale(vector_t window_center) {
+  double x_scale = window_center.x / max_diff.x,
+         y_scale = window_center.y / max_diff.y;
+  return x_scale < y_scale ? x_scale : y_scale;
+}
+
+vector_t get_window_position(vector_t scene_pos, vector_t window_center) {
+  vector_t scene_center_offset = vec_subtract(scene_pos, center);
+  double scale = get_scene_scale(window_center);
+  vector_t pixel_center_offset = vec_multiply(scale, scene_center_offset);
+  vector_t pixel = {.x = round(window_center.x + pixel_center_offset.x),
+                    .y = round(window_center.y - pixel_center_offset.y)};
+  return pixel;
+}
+
+/** Converts a key name from the script to a key code, or '\0' if unknown */
+char script_key(const char *name) {
+  size_t key_names = sizeof(KEY_NAMES) / sizeof(KEY_NAMES[0]);
+  for (size_t i = 0; i < key_names; i++) {
+    if (strcmp(name, KEY_NAMES[i].name) == 0) {
+      return KEY_NAMES[i].key;
+    }
+  }
+  return strlen(name) == 1 ? name[0] : '\0';
+}
+
+/** Dispatches every script event up to the current tick */
+void script_pump(state_t *state) {
+  if (!script_opened) {
+    script_opened = true;
+    const char *path = getenv("HEADLESS_SCRIPT");
+    if (path != NULL) {
+      script = fopen(path, "r");
+      if (script == NULL) {
+        fprintf(stderr, "headless: cannot open script %s\n", path);
+      }
+    }
+  }
+
+  while (script != NULL) {
+    long position = ftell(script);
+    char line[MAX_SCRIPT_LINE];
+    if (fgets(line, sizeof(line), script) == NULL) {
+      fclose(script);
+      script = NULL;
+      break;
+    }
+    size_t tick;
+    char name[MAX_SCRIPT_LINE];
+    char action[MAX_SCRIPT_LINE];
+    if (line[0] == '#' ||
+        sscanf(line, "%zu %63s %63s", &tick, name, action) != 3) {
+      continue;
+    }
+    // Leave events for later ticks in the file until their tick comes
+    if (tick > script_tick) {
+      fseek(script, position, SEEK_SET);
+      break;
+    }
+    char key = script_key(name);
+    if (key == '\0' || key_handler == NULL) {
+      continue;
+    }
+    key_event_type_t type =
+        strcmp(action, "release") == 0 ? KEY_RELEASED : KEY_PRESSED;
+    key_handler(key, type, 0.0, state);
+  }
+}
+
+bool sdl_is_done(void *state) {
+  script_pump((state_t *)state);
+  script_tick++;
+  return false;
+}
+
+void sdl_clear(void) {}
+
+void sdl_draw_polygon(list_t *points, rgb_color_t color) {}
+
+void sdl_draw_projectiles(projectiles_t *projectiles) {}
+
+void sdl_change_music(state_t *state, sound_t sound) {}
+
+list_t *sdl_load_sounds(void) { return list_init(1, NULL); }
+
+void sdl_music(state_t *state, sound_t sound) {}
+
+void sdl_sound_effects(state_t *state, sound_t sound) {}
+
+void sdl_sprites_init(scene_t *scene, game_state_t state) {
+  // Sprites still matter without textures: input handling looks players up
+  // through them
+  sprite_list_init(scene);
+}
+
+void sprite_img_init(scene_t *scene, game_state_t state) {}
+
+void sprite_img_add(scene_t *scene, body_t *body, game_state_t state) {
+  scene_add_sprite(scene, sprite_init(scene, body));
+}
+
+void sprite_img_update(sprite_t *sprite, rng_t *rng) {}
+
+void sdl_release_texture(const texture_region_t *texture) {}
+
+void sdl_show(void) {}
+
+void sdl_init(vector_t min, vector_t max) {
+  assert(min.x < max.x);
+  assert(min.y < max.y);
+
+  center = vec_multiply(0.5, vec_add(min, max));
+  max_diff = vec_subtract(max, center);
+}
+
+void sdl_clean(void) {}
+
+void sdl_render_game(scene_t *scene) {}
+
+void sdl_render_scene(scene_t *scene) {}
+
+void sdl_on_key(key_handler_t handler) { key_handler = handler; }
+
+// Every tick is one frame at 60 Hz, however fast the loop really runs
+double time_since_last_tick(void) { return RUNTIME_TICK_DT; }
@@ -1,8 +1,13 @@
 #include "sdl_wrapper.h"
+#include "frame_timer.h"
 #include "list.h"
 #include "map.h"
+#include "projectile.h"
+#include "render_queue.h"
+#include "rng.h"
+#include "sdl_stats.h"
+#include "texture_cache.h"
 #include <SDL2/SDL.h>
-#include <SDL2/SDL2_gfxPrimitives.h>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 #include <assert.h>
@@ -10,7 +15,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
 
 const char WINDOW_TITLE[] = "CS 3";
 const int WINDOW_WIDTH = 1000;
@@ -19,6 +23,45 @@ const double MS_PER_S = 1e3;
 const int FREQUENCY = 44100;
 const int CHANNELS = 2;
 const int CHUNKSIZE = 1024;
+// Ten seconds of frames at 60 Hz
+const size_t FRAME_STATS_WINDOW = 600;
+// The most time one tick simulates, so a stall such as dragging the window
+// does not move bodies through each other once the game resumes
+const double MAX_TICK_DT = 0.1;
+// Within the texture size limit of every renderer SDL ships
+const int ATLAS_PAGE_SIZE = 2048;
+/**
+ * The images packed into atlas textures when the window is made: those
+ * drawn every frame of a match. Backgrounds fill the window on their own and
+ * are loaded separately.
+ */
+const char *const ATLAS_IMAGES[] = {
+    "assets/map1_p1_0.png", "assets/map1_p1_1.png",
+    "assets/map1_p1_2.png", "assets/map1_p1_3.png",
+    "assets/map1_p2_0.png", "assets/map1_p2_1.png",
+    "assets/map1_p2_2.png", "assets/map1_p2_3.png",
+    "assets/map1_ground.png", "assets/map1_wall.png",
+    "assets/map2_p1_0.png", "assets/map2_p1_1.png",
+    "assets/map2_p1_2.png", "assets/map2_p1_3.png",
+    "assets/map2_p2_0.png", "assets/map2_p2_1.png",
+    "assets/map2_p2_2.png", "assets/map2_p2_3.png",
+    "assets/map2_ground.png", "assets/map2_wall.png",
+    "assets/powerup_ricochet.png", "assets/powerup_shotgun.png",
+    "assets/p1_life.png", "assets/p2_life.png"};
+
+/**
+ * The layers a frame is drawn in, from the back. Bodies that never move sit
+ * on the layers up to LAYER_CLOCK, which are kept in the static layer.
+ */
+typedef enum {
+  LAYER_BACKGROUND,
+  LAYER_MAP,
+  LAYER_CLOCK,
+  LAYER_ITEMS,
+  LAYER_CLOCK_ARMS,
+  LAYER_PROJECTILES,
+  LAYER_PLAYERS
+} layer_t;
 
 /**
  * The coordinate at the center of the screen.
@@ -33,9 +76,39 @@ vector_t max_diff;
  */
 SDL_Window *window;
 /**
- * The renderer used to draw the scene.
+ * Draws the frames recorded here: on a render thread if RENDER_THREAD is
+ * set, and offscreen under SDL's dummy video driver.
+ */
+render_queue_t *render_queue = NULL;
+/**
+ * The frame being recorded, or NULL before the first sdl_clear() after the
+ * last sdl_show().
+ */
+render_snapshot_t *snapshot = NULL;
+/**
+ * The window's size in pixels, updated when the window is resized.
  */
-SDL_Renderer *renderer;
+int window_width = 0;
+int window_height = 0;
+/**
+ * The scaling factor from scene to pixel coordinates for the current window
+ * and scene bounds, updated along with the window's size.
+ */
+double view_scale = 1.0;
+/**
+ * The render queue's textures, which every scene's sprites borrow.
+ */
+texture_cache_t *textures = NULL;
+/**
+ * The game state sprite_img_init() last loaded textures for.
+ */
+game_state_t textures_state = INTRO_MENU;
+/**
+ * Counts the changes to the scene's bodies that never move, so the render
+ * queue knows when to draw its static layer again. It starts past 0, which
+ * is what snapshots hold before any statics are recorded into them.
+ */
+size_t static_generation = 1;
 /**
  * The keypress handler, or NULL if none has been configured.
  */
@@ -46,20 +119,14 @@ key_handler_t key_handler = NULL;
  */
 uint32_t key_start_timestamp;
 /**
- * The value of clock() when time_since_last_tick() was last called.
- * Initially 0.
+ * Times the ticks measured by time_since_last_tick(), or NULL before the
+ * first one.
  */
-clock_t last_clock = 0;
+frame_timer_t *frame_timer = NULL;
 
-/** Computes the center of the window in pixel coordinates */
+/** Returns the center of the window in pixel coordinates */
 vector_t get_window_center(void) {
-  int *width = malloc(sizeof(*width)), *height = malloc(sizeof(*height));
-  assert(width != NULL);
-  assert(height != NULL);
-  SDL_GetWindowSize(window, width, height);
-  vector_t dimensions = {.x = *width, .y = *height};
-  free(width);
-  free(height);
+  vector_t dimensions = {.x = window_width, .y = window_height};
   return vec_multiply(0.5, dimensions);
 }
 
@@ -75,13 +142,21 @@ double get_scene_scale(vector_t window_center) {
   return x_scale < y_scale ? x_scale : y_scale;
 }
 
+/**
+ * Recomputes the window's size and the scene's scale. Only needed when the
+ * window or the scene bounds change, not every frame.
+ */
+void view_update(void) {
+  SDL_GetWindowSize(window, &window_width, &window_height);
+  view_scale = get_scene_scale(get_window_center());
+}
+
 /** Maps a scene coordinate to a window coordinate */
 vector_t get_window_position(vector_t scene_pos, vector_t window_center) {
   // Scale scene coordinates by the scaling factor
   // and map the center of the scene to the center of the window
   vector_t scene_center_offset = vec_subtract(scene_pos, center);
-  double scale = get_scene_scale(window_center);
-  vector_t pixel_center_offset = vec_multiply(scale, scene_center_offset);
+  vector_t pixel_center_offset = vec_multiply(view_scale, scene_center_offset);
   vector_t pixel = {.x = round(window_center.x + pixel_center_offset.x),
                     // Flip y axis since positive y is down on the screen
                     .y = round(window_center.y - pixel_center_offset.y)};
@@ -136,6 +211,16 @@ bool sdl_is_done(void *state) {
     case SDL_QUIT:
       free(event);
       return true;
+    case SDL_RENDER_TARGETS_RESET:
+    case SDL_RENDER_DEVICE_RESET:
+      // Some renderers lose what was drawn into textures
+      static_generation++;
+      break;
+    case SDL_WINDOWEVENT:
+      if (event->window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+        view_update();
+      }
+      break;
     case SDL_KEYDOWN:
     case SDL_KEYUP:
       // Skip the keypress if no handler is configured
@@ -162,11 +247,36 @@ bool sdl_is_done(void *state) {
 }
 
 void sdl_clear(void) {
-  SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-  SDL_RenderClear(renderer);
+  // Nothing is drawn until sdl_show(); clearing starts the frame over
+  snapshot = render_queue_begin(render_queue);
 }
 
-void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+/** Returns the frame being recorded, starting one if needed */
+render_snapshot_t *get_snapshot(void) {
+  if (snapshot == NULL) {
+    sdl_clear();
+  }
+  return snapshot;
+}
+
+/** Starts recording a polygon of the given color */
+void frame_start_polygon(render_frame_t *frame, layer_t layer,
+                         rgb_color_t color) {
+  SDL_Color sdl_color = {
+      .r = color.r * 255, .g = color.g * 255, .b = color.b * 255, .a = 255};
+  render_frame_start_polygon(frame, layer, sdl_color);
+}
+
+/** Records a scene coordinate as the polygon's next vertex */
+void frame_add_point(render_frame_t *frame, vector_t point,
+                     vector_t window_center) {
+  vector_t pixel = get_window_position(point, window_center);
+  render_frame_add_vertex(frame, (SDL_FPoint){.x = pixel.x, .y = pixel.y});
+}
+
+/** Records a polygon given by its vertices in scene coordinates */
+void frame_add_polygon(render_frame_t *frame, layer_t layer, list_t *points,
+                       rgb_color_t color) {
   // Check parameters
   size_t n = list_size(points);
   assert(n >= 3);
@@ -175,24 +285,30 @@ void sdl_draw_polygon(list_t *points, rgb_color_t color) {
   assert(0 <= color.b && color.b <= 1);
 
   vector_t window_center = get_window_center();
-
-  // Convert each vertex to a point on screen
-  int16_t *x_points = malloc(sizeof(*x_points) * n),
-          *y_points = malloc(sizeof(*y_points) * n);
-  assert(x_points != NULL);
-  assert(y_points != NULL);
+  frame_start_polygon(frame, layer, color);
   for (size_t i = 0; i < n; i++) {
-    vector_t *vertex = list_get(points, i);
-    vector_t pixel = get_window_position(*vertex, window_center);
-    x_points[i] = pixel.x;
-    y_points[i] = pixel.y;
+    frame_add_point(frame, *(vector_t *)list_get(points, i), window_center);
   }
+}
 
-  // Draw polygon with the given color
-  filledPolygonRGBA(renderer, x_points, y_points, n, color.r * 255,
-                    color.g * 255, color.b * 255, 255);
-  free(x_points);
-  free(y_points);
+void sdl_draw_polygon(list_t *points, rgb_color_t color) {
+  // Polygons are drawn together with the rest of the frame by sdl_show(),
+  // all on one layer in the order they were drawn in
+  frame_add_polygon(get_snapshot()->frame, LAYER_MAP, points, color);
+}
+
+void sdl_draw_projectiles(projectiles_t *projectiles) {
+  render_frame_t *frame = get_snapshot()->frame;
+  vector_t window_center = get_window_center();
+  for (size_t i = 0; i < projectiles_size(projectiles); i++) {
+    vector_t corners[4];
+    projectiles_get_corners(projectiles, i, corners);
+    frame_start_polygon(frame, LAYER_PROJECTILES,
+                        projectiles_get_color(projectiles, i));
+    for (size_t j = 0; j < 4; j++) {
+      frame_add_point(frame, corners[j], window_center);
+    }
+  }
 }
 
 void sdl_change_music(state_t *state, sound_t sound) {
@@ -241,10 +357,24 @@ void sdl_sound_effects(state_t *state, sound_t sound) {
 }
 
 void sdl_sprites_init(scene_t *scene, game_state_t state) {
+  // Every new scene, whether for a map, a menu or a respawn, comes here
+  static_generation++;
   sprite_list_init(scene);
   sprite_img_init(scene, state);
 }
 
+/** Adds the texture for an image to a sprite, if the image loads */
+void sprite_borrow_texture(sprite_t *sprite, const char *path) {
+  const texture_region_t *tex = texture_cache_acquire(textures, path);
+  if (tex != NULL) {
+    sprite_add_tex(sprite, tex);
+  }
+}
+
+void sdl_release_texture(const texture_region_t *texture) {
+  texture_cache_release(textures, texture);
+}
+
 void sprite_img_init(scene_t *scene, game_state_t state) {
   size_t MAX_PATH_LENGTH = 50;
   size_t name_len = 8;
@@ -274,11 +404,17 @@ void sprite_img_init(scene_t *scene, game_state_t state) {
     strcpy(state_name, "end2_");
   }
 
+  // Respawns rebuild the scene for the same state and reuse every texture
+  // the old scene gave back; moving to another state lets those go
+  if (state != textures_state) {
+    texture_cache_trim(textures);
+    textures_state = state;
+  }
+
   size_t sprite_count = list_size(scene_get_sprites(scene));
   for (size_t i = 0; i < sprite_count; i++) {
     sprite_t *sprite = scene_get_sprite(scene, i);
     body_t *body = sprite_get_body(sprite);
-    list_t *surfaces = list_init(1, (free_func_t)SDL_FreeSurface);
 
     char path[MAX_PATH_LENGTH];
     strcpy(path, "assets/");
@@ -288,111 +424,92 @@ void sprite_img_init(scene_t *scene, game_state_t state) {
     case PLAYER1: {
       char path_suffix[9] = "p1_0.png";
       strcat(path, path_suffix);
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '1';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '2';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '3';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       break;
     }
     case PLAYER2: {
       char path_suffix[9] = "p2_0.png";
       strcat(path, path_suffix);
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '1';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '2';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       path[prefix_length] = '3';
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
 
       break;
     }
     case GROUND: {
       char path_suffix[11] = "ground.png";
       strcat(path, path_suffix);
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
       break;
     }
     case WALL: {
       char path_suffix[9] = "wall.png";
       strcat(path, path_suffix);
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
       break;
     }
     case BACKGROUND: {
       char path_suffix[15] = "background.jpg";
       strcat(path, path_suffix);
-      list_add(surfaces, IMG_Load(path));
+      sprite_borrow_texture(sprite, path);
       break;
     }
     default:
       break;
     }
-
-    // for each surface in list
-    for (size_t i = 0; i < list_size(surfaces); i++) {
-      SDL_Surface *surface = (SDL_Surface *)list_get(surfaces, i);
-      SDL_SetColorKey(surface, SDL_TRUE,
-                      SDL_MapRGB(surface->format, 255, 255, 255));
-      SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surface);
-      if (tex != NULL) {
-        sprite_add_tex(sprite, tex);
-      }
-    }
-
-    list_free(surfaces);
   }
 }
 
 void sprite_img_add(scene_t *scene, body_t *body, game_state_t state) {
-  sprite_t *sprite = sprite_init(body);
+  sprite_t *sprite = sprite_init(scene, body);
   body_info_t *info = get_info(body);
-  SDL_Surface *surface = NULL;
+  const char *path = NULL;
   switch (info->type) {
   case POWERUP_RICOCHET:
-    surface = IMG_Load("assets/powerup_ricochet.png");
+    path = "assets/powerup_ricochet.png";
     break;
   case POWERUP_SHOTGUN:
-    surface = IMG_Load("assets/powerup_shotgun.png");
+    path = "assets/powerup_shotgun.png";
     break;
   case P1_LIFE:
-    if (state == MAP1 || state == MAP3) {
-      surface = IMG_Load("assets/p1_life.png");
-    } else if (state == MAP2) {
-      surface = IMG_Load("assets/p1_life.png");
+    if (state == MAP1 || state == MAP2 || state == MAP3) {
+      path = "assets/p1_life.png";
     }
     break;
   case P2_LIFE:
-    if (state == MAP1 || state == MAP3) {
-      surface = IMG_Load("assets/p2_life.png");
-    } else if (state == MAP2) {
-      surface = IMG_Load("assets/p2_life.png");
+    if (state == MAP1 || state == MAP2 || state == MAP3) {
+      path = "assets/p2_life.png";
     }
     break;
   default:
     break;
   }
-  assert(surface != NULL);
-  SDL_SetColorKey(surface, SDL_TRUE,
-                  SDL_MapRGB(surface->format, 255, 255, 255));
-  SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surface);
-  SDL_FreeSurface(surface);
+  assert(path != NULL);
+  const texture_region_t *tex = texture_cache_acquire(textures, path);
+  assert(tex != NULL);
 
   sprite_add_tex(sprite, tex);
   scene_add_sprite(scene, sprite);
 }
 
-void sprite_img_update(sprite_t *sprite) {
+void sprite_img_update(sprite_t *sprite, rng_t *rng) {
   const size_t WALKING_MOD = 38;
   const size_t RUNNING_MOD = 12;
   body_type_t body_type = get_info(sprite_get_body(sprite))->type;
@@ -410,7 +527,7 @@ void sprite_img_update(sprite_t *sprite) {
     if (vel.x != 0) {
       mod = RUNNING_MOD;
     }
-    if (rand() % mod == 0) {
+    if (rng_below(rng, mod) == 0) {
       new_frame = (new_frame + 1) % sprite_textures(sprite);
     }
   }
@@ -419,22 +536,24 @@ void sprite_img_update(sprite_t *sprite) {
 }
 
 void sdl_show(void) {
-  // Draw boundary lines
+  render_snapshot_t *recording = get_snapshot();
+
+  // Boundary lines are drawn over the frame
   vector_t window_center = get_window_center();
   vector_t max = vec_add(center, max_diff),
            min = vec_subtract(center, max_diff);
   vector_t max_pixel = get_window_position(max, window_center),
            min_pixel = get_window_position(min, window_center);
-  SDL_Rect *boundary = malloc(sizeof(*boundary));
-  boundary->x = min_pixel.x;
-  boundary->y = max_pixel.y;
-  boundary->w = max_pixel.x - min_pixel.x;
-  boundary->h = min_pixel.y - max_pixel.y;
-  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-  SDL_RenderDrawRect(renderer, boundary);
-  free(boundary);
-
-  SDL_RenderPresent(renderer);
+  recording->boundary = (SDL_Rect){.x = min_pixel.x,
+                                   .y = max_pixel.y,
+                                   .w = max_pixel.x - min_pixel.x,
+                                   .h = min_pixel.y - max_pixel.y};
+  recording->width = window_width;
+  recording->height = window_height;
+  recording->texture_generation = texture_cache_generation(textures);
+
+  render_queue_publish(render_queue);
+  snapshot = NULL;
 }
 
 void sdl_init(vector_t min, vector_t max) {
@@ -444,91 +563,136 @@ void sdl_init(vector_t min, vector_t max) {
 
   center = vec_multiply(0.5, vec_add(min, max));
   max_diff = vec_subtract(max, center);
+  // Menus and maps call this again with their own bounds, which must keep
+  // the window and renderer that loaded textures belong to
+  if (render_queue != NULL) {
+    view_update();
+    return;
+  }
   SDL_Init(SDL_INIT_EVERYTHING);
   window = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED,
                             SDL_WINDOWPOS_CENTERED, WINDOW_WIDTH, WINDOW_HEIGHT,
                             SDL_WINDOW_RESIZABLE);
-  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_PRESENTVSYNC);
+  view_update();
+  const char *video_driver = SDL_GetCurrentVideoDriver();
+  render_mode_t mode = RENDER_INLINE;
+  if (video_driver != NULL && strcmp(video_driver, "dummy") == 0) {
+    mode = RENDER_OFFSCREEN;
+  } else if (getenv("RENDER_THREAD") != NULL) {
+    mode = RENDER_THREADED;
+  }
+  render_queue = render_queue_init(window, mode);
+  assert(render_queue != NULL);
+  textures = render_queue_get_textures(render_queue);
+  texture_cache_build_atlas(textures, ATLAS_IMAGES,
+                            sizeof(ATLAS_IMAGES) / sizeof(*ATLAS_IMAGES),
+                            ATLAS_PAGE_SIZE);
 }
 
 void sdl_clean(void) {
-  SDL_DestroyRenderer(renderer);
+  if (frame_timer != NULL) {
+    if (getenv("FRAME_STATS") != NULL) {
+      frame_timer_print(frame_timer, "frames");
+    }
+    frame_timer_free(frame_timer);
+    frame_timer = NULL;
+  }
+  // The render queue destroys the textures and the renderer
+  render_queue_free(render_queue);
+  render_queue = NULL;
+  snapshot = NULL;
+  textures = NULL;
   SDL_DestroyWindow(window);
+  window = NULL;
+}
+
+size_t sdl_take_draw_calls(void) {
+  return render_queue_take_draw_calls(render_queue);
+}
+
+bool sdl_write_frame(const char *path) {
+  return render_queue_write_ppm(render_queue, path);
+}
+
+/** Records a sprite's current frame, if it has any */
+void frame_add_sprite(render_frame_t *frame, layer_t layer, sprite_t *sprite) {
+  if (sprite_textures(sprite) == 0) {
+    return;
+  }
+  body_info_t *info = get_info(sprite_get_body(sprite));
+  render_frame_add_sprite(frame, layer,
+                          sprite_get_tex(sprite, sprite_get_curr_ind(sprite)),
+                          *sprite_get_destR(sprite), info->side == LEFT);
+}
+
+/** Returns the layer bodies of a type are drawn on */
+layer_t get_layer(body_type_t type) {
+  switch (type) {
+  case BACKGROUND:
+    return LAYER_BACKGROUND;
+  case WALL:
+  case GROUND:
+    return LAYER_MAP;
+  case CLOCK:
+    return LAYER_CLOCK;
+  case CLOCK_BIG_ARM:
+  case CLOCK_SMALL_ARM:
+    return LAYER_CLOCK_ARMS;
+  case PLAYER1:
+  case PLAYER2:
+    return LAYER_PLAYERS;
+  default:
+    return LAYER_ITEMS;
+  }
+}
+
+/** Returns the frame a layer is recorded into: static or redrawn */
+render_frame_t *get_layer_frame(render_snapshot_t *recording, layer_t layer) {
+  return layer <= LAYER_CLOCK ? recording->statics : recording->frame;
 }
 
 void sdl_render_game(scene_t *scene) {
   sdl_clear();
   sprite_list_update(scene);
+  render_snapshot_t *recording = snapshot;
+  // Each snapshot keeps its statics, so they are recorded again only when
+  // they have changed since this snapshot last held them
+  bool is_recording_statics = recording->static_generation != static_generation;
+  if (is_recording_statics) {
+    render_frame_clear(recording->statics);
+    recording->static_generation = static_generation;
+  }
+  recording->has_statics = true;
+
+  // Layers put everything in order, so it is recorded as the scene lists it
   size_t sprite_count = list_size(scene_get_sprites(scene));
-  sprite_t *player1_sprite = NULL;
-  sprite_t *player2_sprite = NULL;
   for (size_t i = 0; i < sprite_count; i++) {
     sprite_t *sprite = scene_get_sprite(scene, i);
-    body_info_t *info = get_info(sprite_get_body(sprite));
-
-    if (info->type == PLAYER1) {
-      player1_sprite = sprite;
-    } else if (info->type == PLAYER2) {
-      player2_sprite = sprite;
+    body_type_t type = get_info(sprite_get_body(sprite))->type;
+    if (type == PLAYER1 || type == PLAYER2) {
+      sprite_img_update(sprite, scene_get_rng(scene, RNG_COSMETIC));
     }
-
-    SDL_RendererFlip flip = SDL_FLIP_NONE;
-    if (sprite_textures(sprite) != 0) {
-      if (info->side == LEFT) {
-        flip = SDL_FLIP_HORIZONTAL;
-      }
-
-      SDL_RenderCopyEx(renderer,
-                       sprite_get_tex(sprite, sprite_get_curr_ind(sprite)),
-                       NULL, sprite_get_destR(sprite), 0, NULL, flip);
+    layer_t layer = get_layer(type);
+    if (layer <= LAYER_CLOCK && !is_recording_statics) {
+      continue;
     }
+    frame_add_sprite(get_layer_frame(recording, layer), layer, sprite);
   }
 
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
     body_type_t type = get_info(body)->type;
-    if (type == BULLET || type == CLOCK || type == CLOCK_BIG_ARM ||
-        type == CLOCK_SMALL_ARM) {
-      sdl_draw_polygon(shape, body_get_color(body));
-    }
-    list_free(shape);
-  }
-
-  if (player1_sprite != NULL) {
-    body_info_t *info = get_info(sprite_get_body(player1_sprite));
-    sprite_img_update(player1_sprite);
-
-    SDL_RendererFlip flip = SDL_FLIP_NONE;
-    if (sprite_textures(player1_sprite) != 0) {
-      if (info->side == LEFT) {
-        flip = SDL_FLIP_HORIZONTAL;
-      }
-
-      SDL_RenderCopyEx(
-          renderer,
-          sprite_get_tex(player1_sprite, sprite_get_curr_ind(player1_sprite)),
-          NULL, sprite_get_destR(player1_sprite), 0, NULL, flip);
+    if (type == CLOCK && !is_recording_statics) {
+      continue;
     }
-  }
-
-  if (player2_sprite != NULL) {
-    body_info_t *info = get_info(sprite_get_body(player2_sprite));
-    sprite_img_update(player2_sprite);
-
-    SDL_RendererFlip flip = SDL_FLIP_NONE;
-    if (sprite_textures(player2_sprite) != 0) {
-      if (info->side == LEFT) {
-        flip = SDL_FLIP_HORIZONTAL;
-      }
-
-      SDL_RenderCopyEx(
-          renderer,
-          sprite_get_tex(player2_sprite, sprite_get_curr_ind(player2_sprite)),
-          NULL, sprite_get_destR(player2_sprite), 0, NULL, flip);
+    if (type == CLOCK || type == CLOCK_BIG_ARM || type == CLOCK_SMALL_ARM) {
+      layer_t layer = get_layer(type);
+      frame_add_polygon(get_layer_frame(recording, layer), layer,
+                        body_get_vertices(body), body_get_color(body));
     }
   }
+  sdl_draw_projectiles(scene_get_projectiles(scene));
 
   sdl_show();
 }
@@ -538,20 +702,24 @@ void sdl_render_scene(scene_t *scene) {
   size_t body_count = scene_bodies(scene);
   for (size_t i = 0; i < body_count; i++) {
     body_t *body = scene_get_body(scene, i);
-    list_t *shape = body_get_shape(body);
-    sdl_draw_polygon(shape, body_get_color(body));
-    list_free(shape);
+    sdl_draw_polygon(body_get_vertices(body), body_get_color(body));
   }
+  sdl_draw_projectiles(scene_get_projectiles(scene));
   sdl_show();
 }
 
 void sdl_on_key(key_handler_t handler) { key_handler = handler; }
 
 double time_since_last_tick(void) {
-  clock_t now = clock();
-  double difference = last_clock
-                          ? (double)(now - last_clock) / CLOCKS_PER_SEC
-                          : 0.0; // return 0 the first time this is called
-  last_clock = now;
-  return difference;
+  if (frame_timer == NULL) {
+    frame_timer = frame_timer_init(FRAME_STATS_WINDOW);
+  }
+  // Returns 0 the first time this is called
+  double dt = frame_timer_tick(frame_timer);
+  return dt < MAX_TICK_DT ? dt : MAX_TICK_DT;
+}
+
+frame_stats_t sdl_frame_stats(void) {
+  return frame_timer != NULL ? frame_timer_stats(frame_timer)
+                             : (frame_stats_t){0};
 }
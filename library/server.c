@@ -0,0 +1,370 @@
+#include "envs.h"
+#include "projectile.h"
+#include "runtime.h"
+#include "server_protocol.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Hosts many matches at once as the authority for their clients. Matches
+ * run with sdl_headless.c and are stepped across a thread pool by envs_t;
+ * clients send only their held inputs and are sent each match's state.
+ * server_client.c is a scripted client to drive it with.
+ *
+ * SERVER_PORT sets the UDP port (default 7100) and SERVER_MATCHES,
+ * SERVER_THREADS and SERVER_MAP (1, 2 or 3) what is hosted.
+ * SERVER_BROADCAST_HZ sets how often state is sent, SERVER_TICKS stops the
+ * server after that many ticks and SERVER_UNPACED=1 runs ticks back to back
+ * instead of at 60 Hz, to measure the most matches a core can host. Every
+ * few seconds the server reports how much of each 60 Hz tick it was busy.
+ * A client not heard from for SERVER_CLIENT_TIMEOUT seconds gives up its
+ * slot, and a client that joins again starts its input ticks over.
+ */
+
+const uint16_t SERVER_DEFAULT_PORT = 7100;
+const size_t SERVER_DEFAULT_MATCHES = 16;
+const size_t SERVER_DEFAULT_BROADCAST_HZ = 20;
+const double SERVER_REPORT_INTERVAL = 5.0;
+const double SERVER_CLIENT_TIMEOUT = 10.0;
+const size_t SERVER_PLAYERS = 2;
+
+typedef struct client {
+  bool is_joined;
+  struct sockaddr_in address;
+  uint32_t last_tick;
+  // runtime_now() when a message last came from the client
+  double last_heard;
+} client_t;
+
+typedef struct server {
+  int socket;
+  envs_t *envs;
+  size_t matches;
+  // SERVER_PLAYERS clients and actions per match
+  client_t *clients;
+  uint8_t *actions;
+  bool *dones;
+  uint32_t tick;
+  // Words rather than bytes so the structs written into it are aligned
+  uint32_t packet[SERVER_MAX_PACKET / sizeof(uint32_t)];
+
+  size_t states_sent;
+  size_t inputs_received;
+  double busy_time;
+  size_t busy_ticks;
+} server_t;
+
+int server_open(uint16_t port) {
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+  struct sockaddr_in address = {.sin_family = AF_INET,
+                                .sin_port = htons(port),
+                                .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  // Room for a burst of inputs from every client between two ticks
+  int buffer_size = 1 << 22;
+  setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+  if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+bool same_address(struct sockaddr_in *a, struct sockaddr_in *b) {
+  return a->sin_addr.s_addr == b->sin_addr.s_addr && a->sin_port == b->sin_port;
+}
+
+void server_reply(server_t *server, struct sockaddr_in *to, uint8_t type,
+                  size_t match, size_t player) {
+  server_message_t reply = {.magic = SERVER_MAGIC,
+                            .type = type,
+                            .player = player,
+                            .match = match,
+                            .tick = server->tick};
+  sendto(server->socket, &reply, sizeof(reply), 0, (struct sockaddr *)to,
+         sizeof(*to));
+}
+
+/**
+ * Gives a new client the first free player slot, or its old one again. A
+ * client that restarted counts its ticks from 0 again, so its inputs are
+ * ordered afresh.
+ */
+void server_join(server_t *server, struct sockaddr_in *from, double now) {
+  size_t free_slot = SIZE_MAX;
+  for (size_t i = 0; i < server->matches * SERVER_PLAYERS; i++) {
+    client_t *client = &server->clients[i];
+    if (client->is_joined && same_address(&client->address, from)) {
+      // The welcome was lost, so send it again
+      free_slot = i;
+      break;
+    }
+    if (!client->is_joined && free_slot == SIZE_MAX) {
+      free_slot = i;
+    }
+  }
+  if (free_slot == SIZE_MAX) {
+    server_reply(server, from, SERVER_FULL, 0, 0);
+    return;
+  }
+  client_t *client = &server->clients[free_slot];
+  client->is_joined = true;
+  client->address = *from;
+  client->last_tick = 0;
+  client->last_heard = now;
+  server_reply(server, from, SERVER_WELCOME, free_slot / SERVER_PLAYERS,
+               free_slot % SERVER_PLAYERS);
+}
+
+void server_receive(server_t *server, double now) {
+  server_message_t message;
+  struct sockaddr_in from;
+  socklen_t from_size = sizeof(from);
+  while (recvfrom(server->socket, &message, sizeof(message), MSG_DONTWAIT,
+                  (struct sockaddr *)&from, &from_size) == sizeof(message)) {
+    from_size = sizeof(from);
+    if (message.magic != SERVER_MAGIC) {
+      continue;
+    }
+    if (message.type == SERVER_JOIN) {
+      server_join(server, &from, now);
+      continue;
+    }
+    size_t slot = (size_t)message.match * SERVER_PLAYERS + message.player;
+    if (message.type != SERVER_INPUT || message.match >= server->matches ||
+        message.player >= SERVER_PLAYERS) {
+      continue;
+    }
+    // Only the slot's own client may drive it, and stale inputs that were
+    // overtaken on the way are dropped
+    client_t *client = &server->clients[slot];
+    if (!client->is_joined || !same_address(&client->address, &from) ||
+        message.tick < client->last_tick) {
+      continue;
+    }
+    client->last_tick = message.tick;
+    client->last_heard = now;
+    server->actions[slot] = message.actions;
+    server->inputs_received++;
+  }
+}
+
+/**
+ * Writes as much of a match's state as fits in one datagram into the packet
+ * buffer, from the given body and projectile on, and moves them past what
+ * was written. Returns the datagram's size.
+ */
+size_t server_write_state(server_t *server, size_t match, size_t *next_body,
+                          size_t *next_projectile) {
+  state_t *state = envs_get_match(server->envs, match);
+  scene_t *scene = match_get_scene(state);
+  projectiles_t *projectiles = scene_get_projectiles(scene);
+  // Indices in the message are 16 bits wide
+  size_t body_total = scene_bodies(scene);
+  if (body_total > UINT16_MAX) {
+    body_total = UINT16_MAX;
+  }
+  size_t projectile_total = projectiles_size(projectiles);
+  if (projectile_total > UINT16_MAX) {
+    projectile_total = UINT16_MAX;
+  }
+
+  size_t room = SERVER_MAX_PACKET - sizeof(server_state_t);
+  size_t body_count = body_total - *next_body;
+  if (body_count > room / sizeof(server_body_t)) {
+    body_count = room / sizeof(server_body_t);
+  }
+  room -= body_count * sizeof(server_body_t);
+  size_t projectile_count = projectile_total - *next_projectile;
+  if (projectile_count > room / sizeof(server_projectile_t)) {
+    projectile_count = room / sizeof(server_projectile_t);
+  }
+
+  server_state_t *header = (server_state_t *)server->packet;
+  *header = (server_state_t){
+      .magic = SERVER_MAGIC,
+      .type = SERVER_STATE,
+      .match = match,
+      .tick = server->tick,
+      .lives = {match_get_lives(state, PLAYER1),
+                match_get_lives(state, PLAYER2)},
+      .body_total = body_total,
+      .projectile_total = projectile_total,
+      .first_body = *next_body,
+      .body_count = body_count,
+      .first_projectile = *next_projectile,
+      .projectile_count = projectile_count};
+  server_body_t *bodies = (server_body_t *)(header + 1);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, *next_body + i);
+    vector_t centroid = body_get_centroid(body);
+    vector_t velocity = body_get_velocity(body);
+    bodies[i] = (server_body_t){.x = centroid.x,
+                                .y = centroid.y,
+                                .vx = velocity.x,
+                                .vy = velocity.y,
+                                .angle = body_get_angle(body),
+                                .type = get_info(body)->type};
+  }
+  server_projectile_t *shots = (server_projectile_t *)&bodies[body_count];
+  for (size_t i = 0; i < projectile_count; i++) {
+    size_t index = *next_projectile + i;
+    vector_t position = projectiles_get_position(projectiles, index);
+    vector_t velocity = projectiles_get_velocity(projectiles, index);
+    shots[i] = (server_projectile_t){.x = position.x,
+                                     .y = position.y,
+                                     .vx = velocity.x,
+                                     .vy = velocity.y};
+  }
+  *next_body += body_count;
+  *next_projectile += projectile_count;
+  return (uint8_t *)&shots[projectile_count] - (uint8_t *)server->packet;
+}
+
+/** Frees the slots of clients that stopped sending, letting go of their keys */
+void server_drop_idle(server_t *server, double now) {
+  for (size_t i = 0; i < server->matches * SERVER_PLAYERS; i++) {
+    client_t *client = &server->clients[i];
+    if (client->is_joined && now - client->last_heard > SERVER_CLIENT_TIMEOUT) {
+      client->is_joined = false;
+      server->actions[i] = 0;
+    }
+  }
+}
+
+void server_broadcast(server_t *server) {
+  for (size_t match = 0; match < server->matches; match++) {
+    client_t *clients = &server->clients[match * SERVER_PLAYERS];
+    if (!clients[0].is_joined && !clients[1].is_joined) {
+      continue;
+    }
+    server_state_t *header = (server_state_t *)server->packet;
+    size_t next_body = 0, next_projectile = 0;
+    do {
+      size_t size =
+          server_write_state(server, match, &next_body, &next_projectile);
+      for (size_t player = 0; player < SERVER_PLAYERS; player++) {
+        if (!clients[player].is_joined) {
+          continue;
+        }
+        header->player = player;
+        sendto(server->socket, server->packet, size, 0,
+               (struct sockaddr *)&clients[player].address,
+               sizeof(clients[player].address));
+        server->states_sent++;
+      }
+    } while (next_body < header->body_total ||
+             next_projectile < header->projectile_total);
+  }
+}
+
+void server_report(server_t *server, double elapsed) {
+  size_t joined = 0;
+  for (size_t i = 0; i < server->matches * SERVER_PLAYERS; i++) {
+    joined += server->clients[i].is_joined;
+  }
+  double busy_per_tick =
+      server->busy_ticks > 0 ? server->busy_time / server->busy_ticks : 0;
+  double load = busy_per_tick / RUNTIME_TICK_DT;
+  printf("server: tick %u, %zu matches, %zu clients, %.0f inputs/s, "
+         "%.0f state datagrams/s\n",
+         server->tick, server->matches, joined,
+         server->inputs_received / elapsed, server->states_sent / elapsed);
+  printf("server: %.3f ms busy per tick, %.1f%% of the 60 Hz budget, "
+         "so one core could host about %.0f matches\n",
+         busy_per_tick * 1e3, load * 100,
+         load > 0 ? server->matches / load : 0);
+  server->inputs_received = 0;
+  server->states_sent = 0;
+  server->busy_time = 0;
+  server->busy_ticks = 0;
+}
+
+int main() {
+  size_t matches = runtime_env("SERVER_MATCHES", SERVER_DEFAULT_MATCHES);
+  size_t threads = runtime_env("SERVER_THREADS", 1);
+  size_t map_number = runtime_env("SERVER_MAP", 2);
+  size_t broadcast_hz =
+      runtime_env("SERVER_BROADCAST_HZ", SERVER_DEFAULT_BROADCAST_HZ);
+  size_t max_ticks = runtime_env("SERVER_TICKS", 0);
+  bool is_unpaced = runtime_env("SERVER_UNPACED", 0) != 0;
+  uint16_t port = runtime_env("SERVER_PORT", SERVER_DEFAULT_PORT);
+  game_state_t map = map_number == 1 ? MAP1 : map_number == 3 ? MAP3 : MAP2;
+  size_t broadcast_interval =
+      broadcast_hz > 0 ? (size_t)round(1 / (RUNTIME_TICK_DT * broadcast_hz))
+                       : 0;
+  if (matches == 0 || matches > UINT16_MAX) {
+    fprintf(stderr, "server: SERVER_MATCHES must be from 1 to %u\n",
+            UINT16_MAX);
+    return 1;
+  }
+
+  server_t server = {
+      .socket = server_open(port),
+      .envs = envs_init(matches, map, time(NULL), threads),
+      .matches = matches,
+      .clients = calloc(matches * SERVER_PLAYERS, sizeof(client_t)),
+      .actions = calloc(matches * SERVER_PLAYERS, sizeof(uint8_t)),
+      .dones = calloc(matches, sizeof(bool)),
+      .tick = 0};
+  assert(server.clients != NULL);
+  assert(server.actions != NULL);
+  assert(server.dones != NULL);
+  if (server.socket < 0) {
+    fprintf(stderr, "server: cannot listen on port %u: %s\n", port,
+            strerror(errno));
+    return 1;
+  }
+  printf("server: hosting %zu matches on port %u with %zu threads\n", matches,
+         port, threads);
+
+  double next_tick = runtime_now();
+  double last_report = next_tick;
+  while (max_ticks == 0 || server.tick < max_ticks) {
+    double tick_start = runtime_now();
+    server_receive(&server, tick_start);
+    server_drop_idle(&server, tick_start);
+    // A finished match starts over with its players still in it
+    envs_step(server.envs, server.actions, NULL, server.dones);
+    server.tick++;
+    if (broadcast_interval > 0 && server.tick % broadcast_interval == 0) {
+      server_broadcast(&server);
+    }
+    double now = runtime_now();
+    server.busy_time += now - tick_start;
+    server.busy_ticks++;
+
+    if (now - last_report >= SERVER_REPORT_INTERVAL) {
+      server_report(&server, now - last_report);
+      last_report = now;
+    }
+    if (is_unpaced) {
+      continue;
+    }
+    next_tick += RUNTIME_TICK_DT;
+    double wait = next_tick - runtime_now();
+    if (wait > 0) {
+      struct timespec sleep = {.tv_sec = 0, .tv_nsec = wait * 1e9};
+      nanosleep(&sleep, NULL);
+    }
+  }
+  server_report(&server, runtime_now() - last_report);
+
+  envs_free(server.envs);
+  free(server.clients);
+  free(server.actions);
+  free(server.dones);
+  close(server.socket);
+  return 0;
+}
@@ -0,0 +1,155 @@
+#include "match.h"
+#include "rng.h"
+#include "runtime.h"
+#include "server_protocol.h"
+#include <arpa/inet.h>
+#include <assert.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Scripted clients for server.c. Each client joins the server from its own
+ * socket, holds random inputs at 60 Hz and checks the states it is sent.
+ * CLIENT_COUNT sets how many clients to run (default 2, one match),
+ * CLIENT_TICKS how long for and SERVER_PORT where the server listens.
+ */
+
+const uint16_t CLIENT_DEFAULT_PORT = 7100;
+const size_t CLIENT_DEFAULT_TICKS = 600;
+// Ticks between bot input changes, on average
+const uint32_t CLIENT_BOT_PERIOD = 8;
+
+typedef struct client {
+  int socket;
+  bool is_joined;
+  uint16_t match;
+  uint8_t player;
+  uint8_t actions;
+  size_t states;
+  size_t bad_states;
+  uint32_t last_state_tick;
+} client_t;
+
+void client_send(client_t *client, struct sockaddr_in *server, uint8_t type,
+                 uint32_t tick) {
+  server_message_t message = {.magic = SERVER_MAGIC,
+                              .type = type,
+                              .player = client->player,
+                              .match = client->match,
+                              .tick = tick,
+                              .actions = client->actions};
+  sendto(client->socket, &message, sizeof(message), 0,
+         (struct sockaddr *)server, sizeof(*server));
+}
+
+/** Checks that a state describes a plausible match */
+bool client_check_state(client_t *client, uint8_t *packet, size_t size) {
+  server_state_t *header = (server_state_t *)packet;
+  if (size < sizeof(server_state_t) || header->match != client->match ||
+      header->player != client->player) {
+    return false;
+  }
+  size_t expected = sizeof(server_state_t) +
+                    header->body_count * sizeof(server_body_t) +
+                    header->projectile_count * sizeof(server_projectile_t);
+  if (size != expected || header->body_total == 0 ||
+      header->first_body + header->body_count > header->body_total ||
+      header->first_projectile + header->projectile_count >
+          header->projectile_total) {
+    return false;
+  }
+  server_body_t *bodies = (server_body_t *)(header + 1);
+  for (size_t i = 0; i < header->body_count; i++) {
+    if (bodies[i].x != bodies[i].x || bodies[i].y != bodies[i].y) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void client_receive(client_t *client) {
+  uint32_t packet[SERVER_MAX_PACKET / sizeof(uint32_t)];
+  ssize_t size;
+  while ((size = recv(client->socket, packet, sizeof(packet),
+                      MSG_DONTWAIT)) > 0) {
+    server_message_t *message = (server_message_t *)packet;
+    if ((size_t)size < sizeof(server_message_t) ||
+        message->magic != SERVER_MAGIC) {
+      continue;
+    }
+    if (message->type == SERVER_WELCOME && !client->is_joined) {
+      client->is_joined = true;
+      client->match = message->match;
+      client->player = message->player;
+    } else if (message->type == SERVER_STATE && client->is_joined) {
+      server_state_t *header = (server_state_t *)packet;
+      if (!client_check_state(client, (uint8_t *)packet, size)) {
+        client->bad_states++;
+      } else if (header->first_body == 0 && header->first_projectile == 0) {
+        // A state split across datagrams counts once
+        client->states++;
+      }
+      client->last_state_tick = message->tick;
+    }
+  }
+}
+
+int main() {
+  size_t count = runtime_env("CLIENT_COUNT", 2);
+  size_t ticks = runtime_env("CLIENT_TICKS", CLIENT_DEFAULT_TICKS);
+  uint16_t port = runtime_env("SERVER_PORT", CLIENT_DEFAULT_PORT);
+  struct sockaddr_in server = {.sin_family = AF_INET,
+                               .sin_port = htons(port),
+                               .sin_addr.s_addr = htonl(INADDR_LOOPBACK)};
+  rng_t *rng = rng_init(time(NULL), 0);
+  client_t *clients = calloc(count, sizeof(client_t));
+  assert(clients != NULL);
+  for (size_t i = 0; i < count; i++) {
+    clients[i].socket = socket(AF_INET, SOCK_DGRAM, 0);
+    assert(clients[i].socket >= 0);
+  }
+
+  double next_tick = runtime_now();
+  for (uint32_t tick = 0; tick < ticks; tick++) {
+    for (size_t i = 0; i < count; i++) {
+      client_t *client = &clients[i];
+      client_receive(client);
+      if (!client->is_joined) {
+        client_send(client, &server, SERVER_JOIN, tick);
+        continue;
+      }
+      if (rng_below(rng, CLIENT_BOT_PERIOD) == 0) {
+        client->actions = rng_below(rng, 16);
+      }
+      client_send(client, &server, SERVER_INPUT, tick);
+    }
+    next_tick += RUNTIME_TICK_DT;
+    double wait = next_tick - runtime_now();
+    if (wait > 0) {
+      struct timespec sleep = {.tv_sec = 0, .tv_nsec = wait * 1e9};
+      nanosleep(&sleep, NULL);
+    }
+  }
+
+  size_t joined = 0;
+  size_t states = 0;
+  size_t bad_states = 0;
+  for (size_t i = 0; i < count; i++) {
+    client_receive(&clients[i]);
+    joined += clients[i].is_joined;
+    states += clients[i].states;
+    bad_states += clients[i].bad_states;
+    close(clients[i].socket);
+  }
+  double seconds = ticks * RUNTIME_TICK_DT;
+  printf("clients: %zu of %zu joined, %.1f states/s each, %zu malformed\n",
+         joined, count, joined > 0 ? states / seconds / joined : 0,
+         bad_states);
+  free(clients);
+  rng_free(rng);
+  return bad_states > 0 || joined < count;
+}
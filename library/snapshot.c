@@ -0,0 +1,125 @@
+#include "snapshot.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char SNAPSHOT_MAGIC[4] = {'S', 'N', 'A', 'P'};
+// Bump whenever anything saved into snapshots changes layout
+const uint32_t SNAPSHOT_VERSION = 4;
+// Where the header keeps the snapshot's total size, to catch truncation
+const size_t SNAPSHOT_SIZE_OFFSET =
+    sizeof(SNAPSHOT_MAGIC) + sizeof(SNAPSHOT_VERSION);
+const size_t SNAPSHOT_HEADER_SIZE = SNAPSHOT_SIZE_OFFSET + sizeof(uint64_t);
+
+typedef struct snapshot {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+  size_t cursor;
+  // Sticky until the next save or restore, so loaders can read a whole
+  // record and check once at the end
+  bool has_failed;
+} snapshot_t;
+
+snapshot_t *snapshot_init(size_t initial_capacity) {
+  snapshot_t *snapshot = malloc(sizeof(snapshot_t));
+  assert(snapshot != NULL);
+  size_t capacity = initial_capacity > 0 ? initial_capacity : 1;
+  *snapshot = (snapshot_t){.data = malloc(capacity),
+                           .size = 0,
+                           .capacity = capacity,
+                           .cursor = 0,
+                           .has_failed = false};
+  assert(snapshot->data != NULL);
+  return snapshot;
+}
+
+void snapshot_free(snapshot_t *snapshot) {
+  free(snapshot->data);
+  free(snapshot);
+}
+
+void snapshot_reserve(snapshot_t *snapshot, size_t capacity) {
+  if (capacity <= snapshot->capacity) {
+    return;
+  }
+  while (snapshot->capacity < capacity) {
+    snapshot->capacity *= 2;
+  }
+  snapshot->data = realloc(snapshot->data, snapshot->capacity);
+  assert(snapshot->data != NULL);
+}
+
+void snapshot_begin_save(snapshot_t *snapshot) {
+  snapshot->size = 0;
+  snapshot->cursor = 0;
+  snapshot->has_failed = false;
+  snapshot_write(snapshot, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  snapshot_write(snapshot, &SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+  uint64_t size = 0;
+  snapshot_write(snapshot, &size, sizeof(size));
+}
+
+bool snapshot_begin_restore(snapshot_t *snapshot) {
+  snapshot->cursor = 0;
+  snapshot->has_failed = false;
+  if (snapshot->size < SNAPSHOT_HEADER_SIZE) {
+    return false;
+  }
+  char magic[sizeof(SNAPSHOT_MAGIC)];
+  uint32_t version;
+  uint64_t size;
+  snapshot_read(snapshot, magic, sizeof(magic));
+  snapshot_read(snapshot, &version, sizeof(version));
+  snapshot_read(snapshot, &size, sizeof(size));
+  // A snapshot cut short would otherwise fail partway through restoring
+  return memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0 &&
+         version == SNAPSHOT_VERSION && size == snapshot->size;
+}
+
+void snapshot_write(snapshot_t *snapshot, const void *data, size_t size) {
+  snapshot_reserve(snapshot, snapshot->size + size);
+  memcpy(&snapshot->data[snapshot->size], data, size);
+  snapshot->size += size;
+  if (snapshot->size >= SNAPSHOT_HEADER_SIZE) {
+    uint64_t total = snapshot->size;
+    memcpy(&snapshot->data[SNAPSHOT_SIZE_OFFSET], &total, sizeof(total));
+  }
+}
+
+void snapshot_read(snapshot_t *snapshot, void *data, size_t size) {
+  if (snapshot->has_failed || size > snapshot->size - snapshot->cursor) {
+    snapshot->has_failed = true;
+    memset(data, 0, size);
+    return;
+  }
+  memcpy(data, &snapshot->data[snapshot->cursor], size);
+  snapshot->cursor += size;
+}
+
+size_t snapshot_read_count(snapshot_t *snapshot, size_t item_size) {
+  size_t count;
+  snapshot_read(snapshot, &count, sizeof(count));
+  if (count > (snapshot->size - snapshot->cursor) / item_size) {
+    snapshot->has_failed = true;
+    return 0;
+  }
+  return count;
+}
+
+void snapshot_fail(snapshot_t *snapshot) { snapshot->has_failed = true; }
+
+bool snapshot_has_failed(snapshot_t *snapshot) { return snapshot->has_failed; }
+
+const void *snapshot_get_data(snapshot_t *snapshot) { return snapshot->data; }
+
+size_t snapshot_size(snapshot_t *snapshot) { return snapshot->size; }
+
+void snapshot_set_data(snapshot_t *snapshot, const void *data, size_t size) {
+  snapshot_reserve(snapshot, size);
+  memcpy(snapshot->data, data, size);
+  snapshot->size = size;
+  snapshot->cursor = 0;
+  snapshot->has_failed = false;
+}
@@ -0,0 +1,805 @@
+#include "spectate.h"
+#include "body.h"
+#include "projectile.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char SPECTATE_STREAM_MAGIC[4] = {'S', 'P', 'E', 'C'};
+// Quantization steps per unit of distance, and per turn
+const double SPECTATE_POSITION_SCALE = 32.0;
+const double SPECTATE_ANGLE_STEPS = 65536.0;
+// Keeps coordinates, and so their differences, well inside 64 bits
+const int64_t SPECTATE_MAX_COORDINATE = (int64_t)1 << 40;
+const size_t SPECTATE_TYPE_BITS = 5;
+const size_t SPECTATE_COLOR_BITS = 8;
+const size_t SPECTATE_ANGLE_BITS = 16;
+const size_t SPECTATE_WEAPON_BITS = 2;
+const size_t SPECTATE_TICK_BITS = 32;
+// Limits on what a decoder accepts, so a corrupt frame cannot make it
+// allocate without bound
+const size_t SPECTATE_MAX_SLOTS = 1 << 16;
+const size_t SPECTATE_MAX_VERTICES = 1 << 12;
+const size_t SPECTATE_MAX_PROJECTILES = 1 << 14;
+const size_t SPECTATE_INITIAL_BYTES = 1 << 12;
+const size_t SPECTATE_INITIAL_SLOTS = 64;
+
+/**
+ * Where a body or projectile was on the last two frames, in quantized
+ * steps. Both ends keep the same values, so they predict the same motion.
+ */
+typedef struct spectate_motion {
+  int64_t x;
+  int64_t y;
+  int64_t last_x;
+  int64_t last_y;
+  uint16_t angle;
+  uint16_t last_angle;
+} spectate_motion_t;
+
+typedef struct spectate_entity {
+  bool is_present;
+  size_t generation;
+  body_type_t type;
+  spectate_motion_t motion;
+} spectate_entity_t;
+
+typedef struct spectate_encoder {
+  size_t keyframe_interval;
+  size_t since_keyframe;
+  bool wants_keyframe;
+  // What the last frame was encoded from, to spot respawns
+  scene_t *scene;
+  size_t lives[2];
+
+  // Indexed by body slot
+  size_t slots;
+  spectate_entity_t *entities;
+  body_t **bodies;
+  size_t projectile_count;
+  size_t projectile_capacity;
+  spectate_motion_t *projectiles;
+
+  // The frame being written; bits are packed most significant first
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+  uint64_t bits;
+  size_t bit_count;
+
+  spectate_stats_t stats;
+} spectate_encoder_t;
+
+typedef struct spectate_body {
+  bool is_present;
+  body_type_t type;
+  rgb_color_t color;
+  spectate_motion_t motion;
+  size_t vertex_count;
+  // Offsets from the centroid, before rotation
+  vector_t *vertices;
+} spectate_body_t;
+
+typedef struct spectate_reader {
+  const uint8_t *data;
+  size_t size;
+  size_t bit;
+  bool is_bad;
+} spectate_reader_t;
+
+typedef struct spectate_decoder {
+  bool is_ready;
+  uint32_t tick;
+  size_t lives[2];
+
+  // Indexed by body slot
+  size_t slots;
+  spectate_body_t *bodies;
+  // The slots holding a body, in increasing order
+  size_t body_count;
+  size_t *order;
+
+  size_t projectile_count;
+  size_t projectile_capacity;
+  spectate_motion_t *projectiles;
+  uint8_t *weapons;
+} spectate_decoder_t;
+
+// ---------------------- QUANTIZATION
+// ---------------------------------------------------------------------
+
+int64_t spectate_quantize(double value) {
+  double scaled = value * SPECTATE_POSITION_SCALE;
+  // Written so that NaN lands on a bound too
+  if (!(scaled > -SPECTATE_MAX_COORDINATE)) {
+    return -SPECTATE_MAX_COORDINATE;
+  }
+  if (scaled > SPECTATE_MAX_COORDINATE) {
+    return SPECTATE_MAX_COORDINATE;
+  }
+  return llround(scaled);
+}
+
+uint16_t spectate_quantize_angle(double angle) {
+  double turns = angle / (2 * M_PI);
+  if (!isfinite(turns)) {
+    return 0;
+  }
+  turns -= floor(turns);
+  // A full turn wraps around to 0
+  return (uint16_t)(uint32_t)llround(turns * SPECTATE_ANGLE_STEPS);
+}
+
+double spectate_dequantize(int64_t value) {
+  return value / SPECTATE_POSITION_SCALE;
+}
+
+double spectate_dequantize_angle(uint16_t angle) {
+  return angle * 2 * M_PI / SPECTATE_ANGLE_STEPS;
+}
+
+int64_t spectate_clamp(int64_t value) {
+  if (value < -SPECTATE_MAX_COORDINATE) {
+    return -SPECTATE_MAX_COORDINATE;
+  }
+  return value > SPECTATE_MAX_COORDINATE ? SPECTATE_MAX_COORDINATE : value;
+}
+
+void spectate_motion_start(spectate_motion_t *motion, int64_t x, int64_t y,
+                           uint16_t angle) {
+  *motion = (spectate_motion_t){.x = x,
+                                .y = y,
+                                .last_x = x,
+                                .last_y = y,
+                                .angle = angle,
+                                .last_angle = angle};
+}
+
+/** Guesses the next position by carrying on at the last frame's speed */
+spectate_motion_t spectate_motion_predict(spectate_motion_t *motion) {
+  return (spectate_motion_t){
+      .x = 2 * motion->x - motion->last_x,
+      .y = 2 * motion->y - motion->last_y,
+      .angle = (uint16_t)(2 * motion->angle - motion->last_angle)};
+}
+
+/** Moves to the predicted position corrected by the given errors */
+void spectate_motion_apply(spectate_motion_t *motion, int64_t dx, int64_t dy,
+                           int64_t dangle) {
+  spectate_motion_t predicted = spectate_motion_predict(motion);
+  motion->last_x = motion->x;
+  motion->last_y = motion->y;
+  motion->last_angle = motion->angle;
+  // Only a corrupt stream can leave the range, so this changes nothing for
+  // a valid one
+  motion->x = spectate_clamp(predicted.x + dx);
+  motion->y = spectate_clamp(predicted.y + dy);
+  motion->angle = (uint16_t)(predicted.angle + dangle);
+}
+
+// ---------------------- BIT WRITING
+// ---------------------------------------------------------------------
+
+void spectate_put_byte(spectate_encoder_t *encoder, uint8_t byte) {
+  if (encoder->size == encoder->capacity) {
+    encoder->capacity *= 2;
+    encoder->data = realloc(encoder->data, encoder->capacity);
+    assert(encoder->data != NULL);
+  }
+  encoder->data[encoder->size++] = byte;
+}
+
+/** Writes the low count bits of value, for count up to 32 */
+void spectate_put(spectate_encoder_t *encoder, uint64_t value, size_t count) {
+  assert(count <= 32);
+  if (count == 0) {
+    return;
+  }
+  encoder->bits = (encoder->bits << count) | (value & ((1ull << count) - 1));
+  encoder->bit_count += count;
+  while (encoder->bit_count >= 8) {
+    encoder->bit_count -= 8;
+    spectate_put_byte(encoder, encoder->bits >> encoder->bit_count);
+  }
+}
+
+/**
+ * Writes a positive number as an Elias gamma code: one zero for each bit
+ * after the first, then the number itself, so 1 takes one bit and 2 or 3
+ * take three.
+ */
+void spectate_put_gamma(spectate_encoder_t *encoder, uint64_t value) {
+  assert(value > 0);
+  size_t length = 64 - __builtin_clzll(value);
+  for (size_t zeros = length - 1; zeros > 0;) {
+    size_t count = zeros < 32 ? zeros : 32;
+    spectate_put(encoder, 0, count);
+    zeros -= count;
+  }
+  if (length > 32) {
+    spectate_put(encoder, value >> 32, length - 32);
+    length = 32;
+  }
+  spectate_put(encoder, value, length);
+}
+
+/** Writes a signed number, interleaving signs so small magnitudes are short */
+void spectate_put_signed(spectate_encoder_t *encoder, int64_t value) {
+  uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  spectate_put_gamma(encoder, zigzag + 1);
+}
+
+void spectate_put_count(spectate_encoder_t *encoder, size_t count) {
+  spectate_put_gamma(encoder, (uint64_t)count + 1);
+}
+
+// ---------------------- BIT READING
+// ---------------------------------------------------------------------
+
+/** Reads count bits, for count up to 64. Reading past the end reads 0. */
+uint64_t spectate_get(spectate_reader_t *reader, size_t count) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t byte = reader->bit / 8;
+    if (byte >= reader->size) {
+      reader->is_bad = true;
+      return 0;
+    }
+    value = (value << 1) | ((reader->data[byte] >> (7 - reader->bit % 8)) & 1);
+    reader->bit++;
+  }
+  return value;
+}
+
+uint64_t spectate_get_gamma(spectate_reader_t *reader) {
+  size_t zeros = 0;
+  while (spectate_get(reader, 1) == 0) {
+    if (reader->is_bad || ++zeros > 63) {
+      reader->is_bad = true;
+      return 1;
+    }
+  }
+  return ((uint64_t)1 << zeros) | spectate_get(reader, zeros);
+}
+
+/** Reads a signed number, rejecting any larger than a valid frame holds */
+int64_t spectate_get_signed(spectate_reader_t *reader) {
+  uint64_t zigzag = spectate_get_gamma(reader) - 1;
+  if (zigzag > (uint64_t)SPECTATE_MAX_COORDINATE << 4) {
+    reader->is_bad = true;
+    return 0;
+  }
+  return (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+}
+
+size_t spectate_get_count(spectate_reader_t *reader) {
+  return spectate_get_gamma(reader) - 1;
+}
+
+// ---------------------- ENCODER
+// ---------------------------------------------------------------------
+
+spectate_encoder_t *spectate_encoder_init(size_t keyframe_interval) {
+  assert(keyframe_interval > 0);
+  spectate_encoder_t *encoder = malloc(sizeof(spectate_encoder_t));
+  assert(encoder != NULL);
+  *encoder = (spectate_encoder_t){
+      .keyframe_interval = keyframe_interval,
+      .since_keyframe = 0,
+      .wants_keyframe = true,
+      .scene = NULL,
+      .slots = SPECTATE_INITIAL_SLOTS,
+      .entities = calloc(SPECTATE_INITIAL_SLOTS, sizeof(spectate_entity_t)),
+      .bodies = calloc(SPECTATE_INITIAL_SLOTS, sizeof(body_t *)),
+      .projectile_count = 0,
+      .projectile_capacity = 0,
+      .projectiles = NULL,
+      .data = malloc(SPECTATE_INITIAL_BYTES),
+      .size = 0,
+      .capacity = SPECTATE_INITIAL_BYTES,
+      .stats = {0}};
+  assert(encoder->entities != NULL);
+  assert(encoder->bodies != NULL);
+  assert(encoder->data != NULL);
+  return encoder;
+}
+
+void spectate_encoder_free(spectate_encoder_t *encoder) {
+  free(encoder->entities);
+  free(encoder->bodies);
+  free(encoder->projectiles);
+  free(encoder->data);
+  free(encoder);
+}
+
+void spectate_encoder_request_keyframe(spectate_encoder_t *encoder) {
+  encoder->wants_keyframe = true;
+}
+
+spectate_stats_t spectate_encoder_get_stats(spectate_encoder_t *encoder) {
+  return encoder->stats;
+}
+
+void spectate_encoder_reserve(spectate_encoder_t *encoder, size_t slots) {
+  if (slots <= encoder->slots) {
+    return;
+  }
+  size_t old_slots = encoder->slots;
+  while (encoder->slots < slots) {
+    encoder->slots *= 2;
+  }
+  encoder->entities =
+      realloc(encoder->entities, encoder->slots * sizeof(spectate_entity_t));
+  encoder->bodies = realloc(encoder->bodies, encoder->slots * sizeof(body_t *));
+  assert(encoder->entities != NULL);
+  assert(encoder->bodies != NULL);
+  size_t added = encoder->slots - old_slots;
+  memset(&encoder->entities[old_slots], 0, added * sizeof(spectate_entity_t));
+  memset(&encoder->bodies[old_slots], 0, added * sizeof(body_t *));
+}
+
+/** Writes everything a spectator needs to draw a body it has not seen */
+void spectate_put_spawn(spectate_encoder_t *encoder, size_t slot,
+                        body_t *body) {
+  spectate_entity_t *entity = &encoder->entities[slot];
+  vector_t centroid = body_get_centroid(body);
+  double angle = body_get_angle(body);
+  *entity = (spectate_entity_t){.is_present = true,
+                                .generation = body_get_handle(body).generation,
+                                .type = get_info(body)->type};
+  spectate_motion_start(&entity->motion, spectate_quantize(centroid.x),
+                        spectate_quantize(centroid.y),
+                        spectate_quantize_angle(angle));
+
+  rgb_color_t color = body_get_color(body);
+  spectate_put(encoder, entity->type, SPECTATE_TYPE_BITS);
+  spectate_put(encoder, lround(color.r * 255), SPECTATE_COLOR_BITS);
+  spectate_put(encoder, lround(color.g * 255), SPECTATE_COLOR_BITS);
+  spectate_put(encoder, lround(color.b * 255), SPECTATE_COLOR_BITS);
+  spectate_put_signed(encoder, entity->motion.x);
+  spectate_put_signed(encoder, entity->motion.y);
+  spectate_put(encoder, entity->motion.angle, SPECTATE_ANGLE_BITS);
+
+  list_t *shape = body_get_vertices(body);
+  size_t vertex_count = list_size(shape);
+  spectate_put_count(encoder, vertex_count);
+  for (size_t i = 0; i < vertex_count; i++) {
+    vector_t offset = vec_rotate(
+        vec_subtract(*(vector_t *)list_get(shape, i), centroid), -angle);
+    spectate_put_signed(encoder, spectate_quantize(offset.x));
+    spectate_put_signed(encoder, spectate_quantize(offset.y));
+  }
+}
+
+/** Writes how far a body strayed from its predicted motion */
+void spectate_put_motion(spectate_encoder_t *encoder,
+                         spectate_motion_t *motion, int64_t x, int64_t y,
+                         uint16_t angle) {
+  spectate_motion_t predicted = spectate_motion_predict(motion);
+  int64_t dx = x - predicted.x;
+  int64_t dy = y - predicted.y;
+  int64_t dangle = (int16_t)(uint16_t)(angle - predicted.angle);
+  if (dx == 0 && dy == 0 && dangle == 0) {
+    spectate_put(encoder, 0, 1);
+  } else {
+    spectate_put(encoder, 1, 1);
+    spectate_put_signed(encoder, dx);
+    spectate_put_signed(encoder, dy);
+    spectate_put_signed(encoder, dangle);
+  }
+  spectate_motion_apply(motion, dx, dy, dangle);
+}
+
+/** Whether a slot held a body on the last frame that is gone now */
+bool spectate_is_removed(spectate_encoder_t *encoder, size_t slot) {
+  spectate_entity_t *entity = &encoder->entities[slot];
+  body_t *body = encoder->bodies[slot];
+  return entity->is_present &&
+         (body == NULL ||
+          entity->generation != body_get_handle(body).generation ||
+          entity->type != get_info(body)->type);
+}
+
+void spectate_put_bodies(spectate_encoder_t *encoder, bool is_keyframe) {
+  if (is_keyframe) {
+    for (size_t slot = 0; slot < encoder->slots; slot++) {
+      encoder->entities[slot].is_present = false;
+    }
+  }
+
+  // Slots are sent as the gap from the previous one
+  size_t removed = 0;
+  for (size_t slot = 0; slot < encoder->slots; slot++) {
+    removed += spectate_is_removed(encoder, slot);
+  }
+  spectate_put_count(encoder, removed);
+  size_t next_slot = 0;
+  for (size_t slot = 0; slot < encoder->slots; slot++) {
+    if (spectate_is_removed(encoder, slot)) {
+      spectate_put_count(encoder, slot - next_slot);
+      next_slot = slot + 1;
+      encoder->entities[slot].is_present = false;
+    }
+  }
+
+  size_t spawned = 0;
+  for (size_t slot = 0; slot < encoder->slots; slot++) {
+    spectate_entity_t *entity = &encoder->entities[slot];
+    body_t *body = encoder->bodies[slot];
+    if (body == NULL) {
+      continue;
+    }
+    if (!entity->is_present) {
+      spawned++;
+      continue;
+    }
+    vector_t centroid = body_get_centroid(body);
+    spectate_put_motion(encoder, &entity->motion,
+                        spectate_quantize(centroid.x),
+                        spectate_quantize(centroid.y),
+                        spectate_quantize_angle(body_get_angle(body)));
+  }
+
+  spectate_put_count(encoder, spawned);
+  next_slot = 0;
+  for (size_t slot = 0; slot < encoder->slots; slot++) {
+    if (encoder->bodies[slot] != NULL && !encoder->entities[slot].is_present) {
+      spectate_put_count(encoder, slot - next_slot);
+      next_slot = slot + 1;
+      spectate_put_spawn(encoder, slot, encoder->bodies[slot]);
+    }
+  }
+}
+
+void spectate_put_projectiles(spectate_encoder_t *encoder,
+                              projectiles_t *projectiles, bool is_keyframe) {
+  size_t count = projectiles_size(projectiles);
+  if (count > encoder->projectile_capacity) {
+    encoder->projectile_capacity = count;
+    encoder->projectiles = realloc(encoder->projectiles,
+                                   count * sizeof(spectate_motion_t));
+    assert(encoder->projectiles != NULL);
+  }
+  // Projectiles are matched to the previous frame's by index, which only
+  // goes wrong for a frame after one in front of them is removed
+  size_t known = is_keyframe ? 0 : encoder->projectile_count;
+  spectate_put_count(encoder, count);
+  for (size_t i = 0; i < count; i++) {
+    vector_t position = projectiles_get_position(projectiles, i);
+    int64_t x = spectate_quantize(position.x);
+    int64_t y = spectate_quantize(position.y);
+    spectate_put(encoder, projectiles_get_weapon(projectiles, i),
+                 SPECTATE_WEAPON_BITS);
+    if (i < known) {
+      spectate_put_motion(encoder, &encoder->projectiles[i], x, y, 0);
+    } else {
+      spectate_put_signed(encoder, x);
+      spectate_put_signed(encoder, y);
+      spectate_motion_start(&encoder->projectiles[i], x, y, 0);
+    }
+  }
+  encoder->projectile_count = count;
+}
+
+const uint8_t *spectate_encode(spectate_encoder_t *encoder, state_t *state,
+                               uint32_t tick, size_t *size) {
+  scene_t *scene = match_get_scene(state);
+  size_t lives[2] = {match_get_lives(state, PLAYER1),
+                     match_get_lives(state, PLAYER2)};
+  // Respawns rebuild the scene, reusing its slots for different bodies
+  bool is_respawn = scene != encoder->scene ||
+                    lives[0] != encoder->lives[0] ||
+                    lives[1] != encoder->lives[1];
+  bool is_keyframe =
+      encoder->wants_keyframe || is_respawn ||
+      encoder->since_keyframe + 1 >= encoder->keyframe_interval;
+  encoder->wants_keyframe = false;
+  encoder->since_keyframe = is_keyframe ? 0 : encoder->since_keyframe + 1;
+  encoder->scene = scene;
+  encoder->lives[0] = lives[0];
+  encoder->lives[1] = lives[1];
+
+  memset(encoder->bodies, 0, encoder->slots * sizeof(body_t *));
+  size_t body_count = scene_bodies(scene);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (body_is_removed(body)) {
+      continue;
+    }
+    size_t slot = body_get_handle(body).index;
+    spectate_encoder_reserve(encoder, slot + 1);
+    encoder->bodies[slot] = body;
+  }
+
+  encoder->size = 0;
+  encoder->bits = 0;
+  encoder->bit_count = 0;
+  spectate_put(encoder, is_keyframe, 1);
+  spectate_put(encoder, tick, SPECTATE_TICK_BITS);
+  spectate_put_count(encoder, lives[0]);
+  spectate_put_count(encoder, lives[1]);
+  spectate_put_bodies(encoder, is_keyframe);
+  spectate_put_projectiles(encoder, scene_get_projectiles(scene), is_keyframe);
+  // Pad the last byte with zeros
+  spectate_put(encoder, 0, (8 - encoder->bit_count) % 8);
+
+  encoder->stats.frames++;
+  encoder->stats.bytes += encoder->size;
+  if (is_keyframe) {
+    encoder->stats.keyframes++;
+    encoder->stats.keyframe_bytes += encoder->size;
+  }
+  *size = encoder->size;
+  return encoder->data;
+}
+
+// ---------------------- DECODER
+// ---------------------------------------------------------------------
+
+spectate_decoder_t *spectate_decoder_init(void) {
+  spectate_decoder_t *decoder = malloc(sizeof(spectate_decoder_t));
+  assert(decoder != NULL);
+  *decoder = (spectate_decoder_t){
+      .is_ready = false,
+      .tick = 0,
+      .slots = SPECTATE_INITIAL_SLOTS,
+      .bodies = calloc(SPECTATE_INITIAL_SLOTS, sizeof(spectate_body_t)),
+      .body_count = 0,
+      .order = malloc(SPECTATE_INITIAL_SLOTS * sizeof(size_t)),
+      .projectile_count = 0,
+      .projectile_capacity = 0,
+      .projectiles = NULL,
+      .weapons = NULL};
+  assert(decoder->bodies != NULL);
+  assert(decoder->order != NULL);
+  return decoder;
+}
+
+void spectate_decoder_free(spectate_decoder_t *decoder) {
+  for (size_t slot = 0; slot < decoder->slots; slot++) {
+    free(decoder->bodies[slot].vertices);
+  }
+  free(decoder->bodies);
+  free(decoder->order);
+  free(decoder->projectiles);
+  free(decoder->weapons);
+  free(decoder);
+}
+
+void spectate_decoder_reserve(spectate_decoder_t *decoder, size_t slots) {
+  if (slots <= decoder->slots) {
+    return;
+  }
+  size_t old_slots = decoder->slots;
+  while (decoder->slots < slots) {
+    decoder->slots *= 2;
+  }
+  decoder->bodies =
+      realloc(decoder->bodies, decoder->slots * sizeof(spectate_body_t));
+  decoder->order = realloc(decoder->order, decoder->slots * sizeof(size_t));
+  assert(decoder->bodies != NULL);
+  assert(decoder->order != NULL);
+  memset(&decoder->bodies[old_slots], 0,
+         (decoder->slots - old_slots) * sizeof(spectate_body_t));
+}
+
+/**
+ * Reads the slots of a list of bodies, checking each is in range and
+ * present or not as expected. Returns false if the frame is malformed.
+ */
+bool spectate_get_slot(spectate_reader_t *reader, spectate_decoder_t *decoder,
+                       size_t *next_slot, bool is_present, size_t *slot) {
+  uint64_t gap = spectate_get_count(reader);
+  if (reader->is_bad || gap >= SPECTATE_MAX_SLOTS - *next_slot) {
+    return false;
+  }
+  *slot = *next_slot + gap;
+  *next_slot = *slot + 1;
+  spectate_decoder_reserve(decoder, *next_slot);
+  return decoder->bodies[*slot].is_present == is_present;
+}
+
+bool spectate_get_spawn(spectate_reader_t *reader, spectate_body_t *body) {
+  body->type = spectate_get(reader, SPECTATE_TYPE_BITS);
+  body->color.r = spectate_get(reader, SPECTATE_COLOR_BITS) / 255.0;
+  body->color.g = spectate_get(reader, SPECTATE_COLOR_BITS) / 255.0;
+  body->color.b = spectate_get(reader, SPECTATE_COLOR_BITS) / 255.0;
+  int64_t x = spectate_get_signed(reader);
+  int64_t y = spectate_get_signed(reader);
+  uint16_t angle = spectate_get(reader, SPECTATE_ANGLE_BITS);
+  spectate_motion_start(&body->motion, x, y, angle);
+
+  size_t vertex_count = spectate_get_count(reader);
+  if (reader->is_bad || vertex_count > SPECTATE_MAX_VERTICES) {
+    return false;
+  }
+  body->vertex_count = vertex_count;
+  body->vertices = realloc(body->vertices, vertex_count * sizeof(vector_t));
+  assert(body->vertices != NULL || vertex_count == 0);
+  for (size_t i = 0; i < vertex_count; i++) {
+    body->vertices[i].x = spectate_dequantize(spectate_get_signed(reader));
+    body->vertices[i].y = spectate_dequantize(spectate_get_signed(reader));
+  }
+  body->is_present = true;
+  return !reader->is_bad;
+}
+
+void spectate_get_motion(spectate_reader_t *reader,
+                         spectate_motion_t *motion) {
+  if (spectate_get(reader, 1) == 0) {
+    spectate_motion_apply(motion, 0, 0, 0);
+    return;
+  }
+  int64_t dx = spectate_get_signed(reader);
+  int64_t dy = spectate_get_signed(reader);
+  int64_t dangle = spectate_get_signed(reader);
+  spectate_motion_apply(motion, dx, dy, dangle);
+}
+
+bool spectate_get_bodies(spectate_reader_t *reader,
+                         spectate_decoder_t *decoder, bool is_keyframe) {
+  if (is_keyframe) {
+    for (size_t slot = 0; slot < decoder->slots; slot++) {
+      decoder->bodies[slot].is_present = false;
+    }
+  }
+
+  size_t removed = spectate_get_count(reader);
+  size_t next_slot = 0;
+  for (size_t i = 0; i < removed; i++) {
+    size_t slot;
+    if (!spectate_get_slot(reader, decoder, &next_slot, true, &slot)) {
+      return false;
+    }
+    decoder->bodies[slot].is_present = false;
+  }
+
+  for (size_t slot = 0; slot < decoder->slots && !reader->is_bad; slot++) {
+    if (decoder->bodies[slot].is_present) {
+      spectate_get_motion(reader, &decoder->bodies[slot].motion);
+    }
+  }
+
+  size_t spawned = spectate_get_count(reader);
+  next_slot = 0;
+  for (size_t i = 0; i < spawned; i++) {
+    size_t slot;
+    if (!spectate_get_slot(reader, decoder, &next_slot, false, &slot) ||
+        !spectate_get_spawn(reader, &decoder->bodies[slot])) {
+      return false;
+    }
+  }
+
+  decoder->body_count = 0;
+  for (size_t slot = 0; slot < decoder->slots; slot++) {
+    if (decoder->bodies[slot].is_present) {
+      decoder->order[decoder->body_count++] = slot;
+    }
+  }
+  return !reader->is_bad;
+}
+
+bool spectate_get_projectiles(spectate_reader_t *reader,
+                              spectate_decoder_t *decoder, bool is_keyframe) {
+  size_t count = spectate_get_count(reader);
+  if (reader->is_bad || count > SPECTATE_MAX_PROJECTILES) {
+    return false;
+  }
+  if (count > decoder->projectile_capacity) {
+    decoder->projectile_capacity = count;
+    decoder->projectiles = realloc(decoder->projectiles,
+                                   count * sizeof(spectate_motion_t));
+    decoder->weapons = realloc(decoder->weapons, count * sizeof(uint8_t));
+    assert(decoder->projectiles != NULL);
+    assert(decoder->weapons != NULL);
+  }
+  size_t known = is_keyframe ? 0 : decoder->projectile_count;
+  for (size_t i = 0; i < count; i++) {
+    decoder->weapons[i] = spectate_get(reader, SPECTATE_WEAPON_BITS);
+    if (i < known) {
+      spectate_get_motion(reader, &decoder->projectiles[i]);
+    } else {
+      int64_t x = spectate_get_signed(reader);
+      int64_t y = spectate_get_signed(reader);
+      spectate_motion_start(&decoder->projectiles[i], x, y, 0);
+    }
+  }
+  decoder->projectile_count = count;
+  return !reader->is_bad;
+}
+
+bool spectate_decode(spectate_decoder_t *decoder, const uint8_t *frame,
+                     size_t size) {
+  spectate_reader_t reader = {
+      .data = frame, .size = size, .bit = 0, .is_bad = false};
+  bool is_keyframe = spectate_get(&reader, 1);
+  if (!is_keyframe && !decoder->is_ready) {
+    return false;
+  }
+  uint32_t tick = spectate_get(&reader, SPECTATE_TICK_BITS);
+  size_t lives[2];
+  lives[0] = spectate_get_count(&reader);
+  lives[1] = spectate_get_count(&reader);
+  // A frame that fails partway has left the decoder half updated
+  decoder->is_ready =
+      !reader.is_bad && spectate_get_bodies(&reader, decoder, is_keyframe) &&
+      spectate_get_projectiles(&reader, decoder, is_keyframe);
+  decoder->tick = tick;
+  decoder->lives[0] = lives[0];
+  decoder->lives[1] = lives[1];
+  return decoder->is_ready;
+}
+
+bool spectate_is_ready(spectate_decoder_t *decoder) {
+  return decoder->is_ready;
+}
+
+uint32_t spectate_get_tick(spectate_decoder_t *decoder) {
+  return decoder->tick;
+}
+
+size_t spectate_get_lives(spectate_decoder_t *decoder, body_type_t player) {
+  assert(player == PLAYER1 || player == PLAYER2);
+  return decoder->lives[player == PLAYER1 ? 0 : 1];
+}
+
+size_t spectate_bodies(spectate_decoder_t *decoder) {
+  return decoder->body_count;
+}
+
+spectate_body_t *spectate_get_body(spectate_decoder_t *decoder,
+                                   size_t index) {
+  assert(index < decoder->body_count);
+  return &decoder->bodies[decoder->order[index]];
+}
+
+body_type_t spectate_get_type(spectate_decoder_t *decoder, size_t index) {
+  return spectate_get_body(decoder, index)->type;
+}
+
+rgb_color_t spectate_get_color(spectate_decoder_t *decoder, size_t index) {
+  return spectate_get_body(decoder, index)->color;
+}
+
+vector_t spectate_get_centroid(spectate_decoder_t *decoder, size_t index) {
+  spectate_motion_t *motion = &spectate_get_body(decoder, index)->motion;
+  return (vector_t){.x = spectate_dequantize(motion->x),
+                    .y = spectate_dequantize(motion->y)};
+}
+
+double spectate_get_angle(spectate_decoder_t *decoder, size_t index) {
+  return spectate_dequantize_angle(
+      spectate_get_body(decoder, index)->motion.angle);
+}
+
+list_t *spectate_get_shape(spectate_decoder_t *decoder, size_t index) {
+  spectate_body_t *body = spectate_get_body(decoder, index);
+  vector_t centroid = spectate_get_centroid(decoder, index);
+  double angle = spectate_get_angle(decoder, index);
+  list_t *shape = list_init(body->vertex_count, (free_func_t)free);
+  for (size_t i = 0; i < body->vertex_count; i++) {
+    vector_t *vertex = malloc(sizeof(vector_t));
+    assert(vertex != NULL);
+    *vertex = vec_add(vec_rotate(body->vertices[i], angle), centroid);
+    list_add(shape, vertex);
+  }
+  return shape;
+}
+
+size_t spectate_projectiles(spectate_decoder_t *decoder) {
+  return decoder->projectile_count;
+}
+
+vector_t spectate_get_projectile(spectate_decoder_t *decoder, size_t index) {
+  assert(index < decoder->projectile_count);
+  spectate_motion_t *motion = &decoder->projectiles[index];
+  return (vector_t){.x = spectate_dequantize(motion->x),
+                    .y = spectate_dequantize(motion->y)};
+}
+
+game_weapon_type_t spectate_get_projectile_weapon(spectate_decoder_t *decoder,
+                                                  size_t index) {
+  assert(index < decoder->projectile_count);
+  return decoder->weapons[index];
+}
@@ -0,0 +1,230 @@
+#include "match.h"
+#include "projectile.h"
+#include "rng.h"
+#include "runtime.h"
+#include "spectate.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Plays matches between bots holding random inputs, encodes each as a
+ * spectator stream and reports how many bytes per second of match it took.
+ * Every frame is also decoded on the spot and checked against the match.
+ *
+ * SPECTATE_MAP (1, 2 or 3), SPECTATE_MATCHES, SPECTATE_TICKS and
+ * SPECTATE_SEED set what is played, and SPECTATE_KEYFRAME the most ticks
+ * between keyframes. SPECTATE_OUT writes the first match's stream to a file,
+ * or to standard output if it is "-", for spectate_view.c to show, e.g.
+ *
+ *   SPECTATE_OUT=- ./spectate_record | ./spectate_view
+ */
+
+const size_t SPECTATE_DEFAULT_MATCHES = 8;
+const size_t SPECTATE_DEFAULT_TICKS = 3600;
+const size_t SPECTATE_DEFAULT_KEYFRAME = 300;
+// Ticks between bot input changes, on average
+const uint32_t SPECTATE_BOT_PERIOD = 8;
+// Largest decoded error accepted, in units of distance and radians
+const double SPECTATE_POSITION_TOLERANCE = 0.05;
+const double SPECTATE_ANGLE_TOLERANCE = 0.001;
+
+double record_angle_error(double a, double b) {
+  double error = fmod(fabs(a - b), 2 * M_PI);
+  return error > M_PI ? 2 * M_PI - error : error;
+}
+
+/**
+ * Compares what a decoder rebuilt with the match it came from, returning
+ * false if a body is missing or misplaced. Writes the largest errors seen.
+ */
+bool record_check(spectate_decoder_t *decoder, state_t *state,
+                  double *position_error, double *angle_error) {
+  scene_t *scene = match_get_scene(state);
+  size_t body_count = scene_bodies(scene);
+  // The decoder lists bodies by slot
+  size_t slots = 0;
+  for (size_t i = 0; i < body_count; i++) {
+    size_t slot = body_get_handle(scene_get_body(scene, i)).index;
+    slots = slot >= slots ? slot + 1 : slots;
+  }
+  body_t **bodies = calloc(slots, sizeof(body_t *));
+  assert(bodies != NULL || slots == 0);
+  for (size_t i = 0; i < body_count; i++) {
+    body_t *body = scene_get_body(scene, i);
+    if (!body_is_removed(body)) {
+      bodies[body_get_handle(body).index] = body;
+    }
+  }
+
+  bool is_match = spectate_is_ready(decoder);
+  size_t index = 0;
+  for (size_t slot = 0; slot < slots && is_match; slot++) {
+    body_t *body = bodies[slot];
+    if (body == NULL) {
+      continue;
+    }
+    if (index == spectate_bodies(decoder) ||
+        spectate_get_type(decoder, index) != get_info(body)->type) {
+      is_match = false;
+      break;
+    }
+    double error = vec_length(vec_subtract(
+        body_get_centroid(body), spectate_get_centroid(decoder, index)));
+    double turn = record_angle_error(body_get_angle(body),
+                                     spectate_get_angle(decoder, index));
+    list_t *vertices = body_get_vertices(body);
+    list_t *shape = spectate_get_shape(decoder, index);
+    is_match = list_size(shape) == list_size(vertices);
+    for (size_t i = 0; i < list_size(shape) && is_match; i++) {
+      double vertex_error = vec_length(vec_subtract(
+          *(vector_t *)list_get(vertices, i), *(vector_t *)list_get(shape, i)));
+      error = vertex_error > error ? vertex_error : error;
+    }
+    list_free(shape);
+    *position_error = error > *position_error ? error : *position_error;
+    *angle_error = turn > *angle_error ? turn : *angle_error;
+    index++;
+  }
+  free(bodies);
+
+  projectiles_t *projectiles = scene_get_projectiles(scene);
+  size_t projectile_count = projectiles_size(projectiles);
+  if (index != spectate_bodies(decoder) ||
+      projectile_count != spectate_projectiles(decoder)) {
+    return false;
+  }
+  for (size_t i = 0; i < projectile_count && is_match; i++) {
+    double error =
+        vec_length(vec_subtract(projectiles_get_position(projectiles, i),
+                                spectate_get_projectile(decoder, i)));
+    *position_error = error > *position_error ? error : *position_error;
+  }
+  return is_match && *position_error <= SPECTATE_POSITION_TOLERANCE &&
+         *angle_error <= SPECTATE_ANGLE_TOLERANCE;
+}
+
+void record_write_frame(FILE *out, const uint8_t *frame, size_t size) {
+  assert(size <= UINT16_MAX);
+  uint8_t header[2] = {size & 0xff, size >> 8};
+  fwrite(header, 1, sizeof(header), out);
+  fwrite(frame, 1, size, out);
+}
+
+int main() {
+  size_t map_number = runtime_env("SPECTATE_MAP", 2);
+  size_t matches = runtime_env("SPECTATE_MATCHES", SPECTATE_DEFAULT_MATCHES);
+  size_t ticks = runtime_env("SPECTATE_TICKS", SPECTATE_DEFAULT_TICKS);
+  size_t keyframe = runtime_env("SPECTATE_KEYFRAME", SPECTATE_DEFAULT_KEYFRAME);
+  uint64_t seed = runtime_env("SPECTATE_SEED", 1);
+  const char *out_path = getenv("SPECTATE_OUT");
+  if (map_number < 1 || map_number > 3 || keyframe == 0) {
+    fprintf(stderr, "spectate: SPECTATE_MAP must be 1, 2 or 3 and "
+                    "SPECTATE_KEYFRAME positive\n");
+    return 1;
+  }
+  game_state_t map = map_number == 1 ? MAP1 : map_number == 2 ? MAP2 : MAP3;
+  // Progress goes to stderr when the stream goes to stdout
+  FILE *report = stdout;
+  FILE *out = NULL;
+  if (out_path != NULL && strcmp(out_path, "-") == 0) {
+    out = stdout;
+    report = stderr;
+  } else if (out_path != NULL) {
+    out = fopen(out_path, "wb");
+    if (out == NULL) {
+      fprintf(stderr, "spectate: cannot write %s\n", out_path);
+      return 1;
+    }
+  }
+  if (out != NULL) {
+    fwrite(SPECTATE_STREAM_MAGIC, 1, sizeof(SPECTATE_STREAM_MAGIC), out);
+    fputc(map_number, out);
+  }
+
+  if (map == MAP1) {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX1);
+  } else {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  }
+  double total_rate = 0;
+  double max_rate = 0;
+  double position_error = 0;
+  double angle_error = 0;
+  double encode_time = 0;
+  size_t total_frames = 0;
+  size_t bad_frames = 0;
+  spectate_stats_t totals = {0};
+  for (size_t i = 0; i < matches; i++) {
+    state_t *state = match_init(map, seed + i);
+    rng_t *bots = rng_init(seed + i, 1);
+    spectate_encoder_t *encoder = spectate_encoder_init(keyframe);
+    spectate_decoder_t *decoder = spectate_decoder_init();
+    uint8_t actions[2] = {0, 0};
+    size_t played = 0;
+    while (played < ticks && !match_is_over(state)) {
+      for (size_t player = 0; player < 2; player++) {
+        uint8_t previous = actions[player];
+        if (rng_below(bots, SPECTATE_BOT_PERIOD) == 0) {
+          actions[player] = rng_below(bots, 16);
+        }
+        match_actions(state, player, previous, actions[player]);
+      }
+      match_step(state, RUNTIME_TICK_DT);
+      played++;
+
+      double start = runtime_now();
+      size_t size;
+      const uint8_t *frame = spectate_encode(encoder, state, played, &size);
+      encode_time += runtime_now() - start;
+      if (!spectate_decode(decoder, frame, size) ||
+          !record_check(decoder, state, &position_error, &angle_error)) {
+        bad_frames++;
+      }
+      if (out != NULL && i == 0) {
+        record_write_frame(out, frame, size);
+      }
+    }
+
+    spectate_stats_t stats = spectate_encoder_get_stats(encoder);
+    double rate = played > 0 ? stats.bytes / (played * RUNTIME_TICK_DT) : 0;
+    total_rate += rate;
+    max_rate = rate > max_rate ? rate : max_rate;
+    total_frames += stats.frames;
+    totals.bytes += stats.bytes;
+    totals.keyframes += stats.keyframes;
+    totals.keyframe_bytes += stats.keyframe_bytes;
+    spectate_decoder_free(decoder);
+    spectate_encoder_free(encoder);
+    rng_free(bots);
+    match_free(state);
+  }
+  if (out != NULL && out != stdout) {
+    fclose(out);
+  } else if (out != NULL) {
+    fflush(out);
+  }
+
+  fprintf(report,
+          "spectate: %zu matches, %.0f B/s per match on average, "
+          "%.0f B/s at most\n",
+          matches, matches > 0 ? total_rate / matches : 0, max_rate);
+  double frame_bytes =
+      total_frames > 0 ? (double)totals.bytes / total_frames : 0;
+  double keyframe_bytes =
+      totals.keyframes > 0 ? (double)totals.keyframe_bytes / totals.keyframes
+                           : 0;
+  fprintf(report,
+          "spectate: %zu frames, %.1f B per frame, %zu keyframes of "
+          "%.0f B making up %.0f%% of the stream\n",
+          total_frames, frame_bytes, totals.keyframes, keyframe_bytes,
+          totals.bytes > 0 ? 100.0 * totals.keyframe_bytes / totals.bytes : 0);
+  fprintf(report,
+          "spectate: %.2f us to encode a frame, decoded within %.4f units "
+          "and %.5f rad, %zu bad frames\n",
+          total_frames > 0 ? encode_time / total_frames * 1e6 : 0,
+          position_error, angle_error, bad_frames);
+  return bad_frames > 0;
+}
@@ -0,0 +1,125 @@
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include "spectate.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Shows a spectator stream written by spectate_record.c, from the file named
+ * by SPECTATE_IN or from standard input, at 60 frames per second. Build it
+ * like the game, with this file in place of emscripten.c, or with
+ * sdl_headless.c in place of sdl_wrapper.c too to only decode. Either way it
+ * reports what it decoded. SPECTATE_UNPACED=1 shows frames as fast as they
+ * arrive instead.
+ */
+
+const double SPECTATE_VIEW_PROJECTILE_SIZE = 1.0;
+const rgb_color_t SPECTATE_VIEW_PROJECTILE_COLOR = {.r = 0, .g = 0, .b = 0};
+
+void view_render(spectate_decoder_t *decoder) {
+  sdl_clear();
+  for (size_t i = 0; i < spectate_bodies(decoder); i++) {
+    // The body that pulls everything down sits far below the map
+    if (spectate_get_type(decoder, i) == GRAVITY) {
+      continue;
+    }
+    list_t *shape = spectate_get_shape(decoder, i);
+    if (list_size(shape) >= 3) {
+      sdl_draw_polygon(shape, spectate_get_color(decoder, i));
+    }
+    list_free(shape);
+  }
+  for (size_t i = 0; i < spectate_projectiles(decoder); i++) {
+    vector_t center = spectate_get_projectile(decoder, i);
+    double half = SPECTATE_VIEW_PROJECTILE_SIZE / 2;
+    vector_t corners[4] = {{-half, -half}, {half, -half}, {half, half},
+                           {-half, half}};
+    list_t *square = list_init(4, (free_func_t)free);
+    for (size_t j = 0; j < 4; j++) {
+      vector_t *corner = malloc(sizeof(vector_t));
+      assert(corner != NULL);
+      *corner = vec_add(center, corners[j]);
+      list_add(square, corner);
+    }
+    sdl_draw_polygon(square, SPECTATE_VIEW_PROJECTILE_COLOR);
+    list_free(square);
+  }
+  sdl_show();
+}
+
+int main() {
+  const char *in_path = getenv("SPECTATE_IN");
+  FILE *in = in_path != NULL ? fopen(in_path, "rb") : stdin;
+  if (in == NULL) {
+    fprintf(stderr, "spectate: cannot read %s\n", in_path);
+    return 1;
+  }
+  char magic[sizeof(SPECTATE_STREAM_MAGIC)];
+  int map_number = EOF;
+  if (fread(magic, 1, sizeof(magic), in) == sizeof(magic)) {
+    map_number = fgetc(in);
+  }
+  if (map_number == EOF ||
+      memcmp(magic, SPECTATE_STREAM_MAGIC, sizeof(magic)) != 0) {
+    fprintf(stderr, "spectate: not a spectator stream\n");
+    return 1;
+  }
+  if (map_number == 1) {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX1);
+  } else {
+    sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  }
+
+  bool is_paced = getenv("SPECTATE_UNPACED") == NULL;
+  spectate_decoder_t *decoder = spectate_decoder_init();
+  uint8_t *frame = malloc(UINT16_MAX);
+  assert(frame != NULL);
+  size_t frames = 0;
+  size_t rejected = 0;
+  size_t bytes = 0;
+  double next_frame = runtime_now();
+  uint8_t header[2];
+  while (fread(header, 1, sizeof(header), in) == sizeof(header)) {
+    size_t size = header[0] | (size_t)header[1] << 8;
+    if (fread(frame, 1, size, in) != size) {
+      break;
+    }
+    frames++;
+    bytes += size + sizeof(header);
+    if (!spectate_decode(decoder, frame, size)) {
+      rejected++;
+      continue;
+    }
+    view_render(decoder);
+    if (sdl_is_done(NULL)) {
+      break;
+    }
+
+    next_frame += RUNTIME_TICK_DT;
+    double wait = next_frame - runtime_now();
+    if (is_paced && wait > 0) {
+      struct timespec sleep = {.tv_sec = 0, .tv_nsec = wait * 1e9};
+      nanosleep(&sleep, NULL);
+    }
+  }
+
+  double seconds = frames * RUNTIME_TICK_DT;
+  printf("spectate: %zu frames to tick %u, %zu rejected, %.0f B/s\n", frames,
+         spectate_get_tick(decoder), rejected,
+         seconds > 0 ? bytes / seconds : 0);
+  if (spectate_is_ready(decoder)) {
+    printf("spectate: lives %zu to %zu, %zu bodies and %zu projectiles\n",
+           spectate_get_lives(decoder, PLAYER1),
+           spectate_get_lives(decoder, PLAYER2), spectate_bodies(decoder),
+           spectate_projectiles(decoder));
+  }
+  free(frame);
+  spectate_decoder_free(decoder);
+  if (in != stdin) {
+    fclose(in);
+  }
+  return rejected > 0;
+}
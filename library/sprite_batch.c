@@ -0,0 +1,149 @@
+#include "sprite_batch.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t SPRITE_BATCH_INITIAL_CAPACITY = 64;
+const size_t SPRITE_BATCH_VERTICES_PER_QUAD = 4;
+const size_t SPRITE_BATCH_INDICES_PER_QUAD = 6;
+
+typedef struct sprite_batch {
+  SDL_Renderer *renderer;
+  // The texture every pending quad is drawn from
+  SDL_Texture *texture;
+  SDL_Vertex *vertices;
+  int *indices;
+  // The pending quads' regions and destinations, should geometry fail
+  const texture_region_t **regions;
+  SDL_Rect *dests;
+  bool *flips;
+  size_t size;
+  size_t capacity;
+  size_t draw_calls;
+} sprite_batch_t;
+
+sprite_batch_t *sprite_batch_init(SDL_Renderer *renderer) {
+  sprite_batch_t *batch = malloc(sizeof(sprite_batch_t));
+  assert(batch != NULL);
+  size_t capacity = SPRITE_BATCH_INITIAL_CAPACITY;
+  *batch = (sprite_batch_t){
+      .renderer = renderer,
+      .texture = NULL,
+      .vertices = malloc(capacity * SPRITE_BATCH_VERTICES_PER_QUAD *
+                         sizeof(SDL_Vertex)),
+      .indices =
+          malloc(capacity * SPRITE_BATCH_INDICES_PER_QUAD * sizeof(int)),
+      .regions = malloc(capacity * sizeof(texture_region_t *)),
+      .dests = malloc(capacity * sizeof(SDL_Rect)),
+      .flips = malloc(capacity * sizeof(bool)),
+      .size = 0,
+      .capacity = capacity,
+      .draw_calls = 0};
+  assert(batch->vertices != NULL && batch->indices != NULL);
+  assert(batch->regions != NULL && batch->dests != NULL);
+  assert(batch->flips != NULL);
+  return batch;
+}
+
+void sprite_batch_free(sprite_batch_t *batch) {
+  free(batch->vertices);
+  free(batch->indices);
+  free(batch->regions);
+  free(batch->dests);
+  free(batch->flips);
+  free(batch);
+}
+
+void sprite_batch_grow(sprite_batch_t *batch) {
+  batch->capacity *= 2;
+  size_t capacity = batch->capacity;
+  batch->vertices =
+      realloc(batch->vertices,
+              capacity * SPRITE_BATCH_VERTICES_PER_QUAD * sizeof(SDL_Vertex));
+  batch->indices = realloc(batch->indices, capacity *
+                                               SPRITE_BATCH_INDICES_PER_QUAD *
+                                               sizeof(int));
+  batch->regions =
+      realloc(batch->regions, capacity * sizeof(texture_region_t *));
+  batch->dests = realloc(batch->dests, capacity * sizeof(SDL_Rect));
+  batch->flips = realloc(batch->flips, capacity * sizeof(bool));
+  assert(batch->vertices != NULL && batch->indices != NULL);
+  assert(batch->regions != NULL && batch->dests != NULL);
+  assert(batch->flips != NULL);
+}
+
+void sprite_batch_add(sprite_batch_t *batch, const texture_region_t *region,
+                      const SDL_Rect *dest, bool flip) {
+  if (batch->size > 0 && region->texture != batch->texture) {
+    sprite_batch_flush(batch);
+  }
+  if (batch->size == batch->capacity) {
+    sprite_batch_grow(batch);
+  }
+  batch->texture = region->texture;
+
+  float u0 = (float)region->source.x / region->texture_width;
+  float v0 = (float)region->source.y / region->texture_height;
+  float u1 = (float)(region->source.x + region->source.w) /
+             region->texture_width;
+  float v1 = (float)(region->source.y + region->source.h) /
+             region->texture_height;
+  if (flip) {
+    float swap = u0;
+    u0 = u1;
+    u1 = swap;
+  }
+  float left = dest->x, top = dest->y;
+  float right = dest->x + dest->w, bottom = dest->y + dest->h;
+  SDL_Color white = {.r = 255, .g = 255, .b = 255, .a = 255};
+  SDL_Vertex *vertices =
+      &batch->vertices[batch->size * SPRITE_BATCH_VERTICES_PER_QUAD];
+  vertices[0] = (SDL_Vertex){{left, top}, white, {u0, v0}};
+  vertices[1] = (SDL_Vertex){{right, top}, white, {u1, v0}};
+  vertices[2] = (SDL_Vertex){{right, bottom}, white, {u1, v1}};
+  vertices[3] = (SDL_Vertex){{left, bottom}, white, {u0, v1}};
+
+  // Two triangles per quad, sharing its diagonal
+  int first = batch->size * SPRITE_BATCH_VERTICES_PER_QUAD;
+  int *indices = &batch->indices[batch->size * SPRITE_BATCH_INDICES_PER_QUAD];
+  indices[0] = first;
+  indices[1] = first + 1;
+  indices[2] = first + 2;
+  indices[3] = first;
+  indices[4] = first + 2;
+  indices[5] = first + 3;
+
+  batch->regions[batch->size] = region;
+  batch->dests[batch->size] = *dest;
+  batch->flips[batch->size] = flip;
+  batch->size++;
+}
+
+void sprite_batch_flush(sprite_batch_t *batch) {
+  if (batch->size == 0) {
+    return;
+  }
+  int result = SDL_RenderGeometry(
+      batch->renderer, batch->texture, batch->vertices,
+      batch->size * SPRITE_BATCH_VERTICES_PER_QUAD, batch->indices,
+      batch->size * SPRITE_BATCH_INDICES_PER_QUAD);
+  if (result == 0) {
+    batch->draw_calls++;
+  } else {
+    // Renderers without geometry support still draw quads one at a time
+    for (size_t i = 0; i < batch->size; i++) {
+      SDL_RendererFlip flip =
+          batch->flips[i] ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+      SDL_RenderCopyEx(batch->renderer, batch->texture,
+                       &batch->regions[i]->source, &batch->dests[i], 0, NULL,
+                       flip);
+      batch->draw_calls++;
+    }
+  }
+  batch->size = 0;
+}
+
+size_t sprite_batch_take_draw_calls(sprite_batch_t *batch) {
+  size_t draw_calls = batch->draw_calls;
+  batch->draw_calls = 0;
+  return draw_calls;
+}
@@ -2,27 +2,33 @@
 #include "body.h"
 #include "game.h"
 #include "list.h"
+#include "scene.h"
+#include "texture_cache.h"
 #include "vector.h"
 #include <assert.h>
 
 typedef struct sprite {
-  char *path;
   list_t *tex;
   SDL_Rect *destR;
-  body_t *body;
+  scene_t *scene;
+  body_handle_t body;
   size_t tex_index;
 } sprite_t;
 
-sprite_t *sprite_init(body_t *body) {
-  size_t TEXT_INITIAL_CAPACITY = 4;
-
-  sprite_t *new_sprite = malloc(sizeof(sprite_t));
-  SDL_Rect *destR = malloc(sizeof(SDL_Rect));
+/**
+ * Writes the pixel rectangle covered by body into destR. This runs for every
+ * sprite every frame, so it reads the body's own vertices rather than a copy
+ * and allocates nothing. The scene's cached bounds would be no cheaper: they
+ * are taken before integration, so they trail the body by a tick when drawn,
+ * and are unset for a body added since the last tick.
+ */
+void sprite_place(SDL_Rect *destR, body_t *body) {
   vector_t window_center = get_window_center();
 
-  vector_t *top_right = list_get(body_get_shape(body), 3);
-  vector_t *bottom_left = list_get(body_get_shape(body), 1);
-  vector_t *top_left = list_get(body_get_shape(body), 0);
+  list_t *shape = body_get_vertices(body);
+  vector_t *top_right = list_get(shape, 3);
+  vector_t *bottom_left = list_get(shape, 1);
+  vector_t *top_left = list_get(shape, 0);
 
   vector_t top_left_pix = get_window_position(*top_left, window_center);
   vector_t top_right_pix = get_window_position(*top_right, window_center);
@@ -32,34 +38,44 @@ sprite_t *sprite_init(body_t *body) {
   destR->y = top_left_pix.y;
   destR->w = top_right_pix.x - bottom_left_pix.x;
   destR->h = bottom_left_pix.y - top_right_pix.y;
+}
+
+sprite_t *sprite_init(scene_t *scene, body_t *body) {
+  size_t TEXT_INITIAL_CAPACITY = 4;
+
+  sprite_t *new_sprite = scene_alloc(scene, sizeof(sprite_t));
+  SDL_Rect *destR = scene_alloc(scene, sizeof(SDL_Rect));
+  sprite_place(destR, body);
 
   new_sprite->destR = destR;
-  new_sprite->body = body;
-  new_sprite->path = malloc(sizeof(char));
-  free(top_right);
-  free(bottom_left);
-  free(top_left);
+  new_sprite->scene = scene;
+  new_sprite->body = body_get_handle(body);
 
-  new_sprite->tex = list_init(TEXT_INITIAL_CAPACITY, (free_func_t)free);
+  // Textures are borrowed from the renderer's cache, not owned
+  new_sprite->tex =
+      list_init_arena(scene_get_arena(scene), TEXT_INITIAL_CAPACITY, NULL);
   new_sprite->tex_index = 0;
   return new_sprite;
 }
 
 // updates texture and surface based on body type
 void sprite_update(sprite_t *sprite) {
-  sprite_t *new_sprite = sprite_init(sprite_get_body(sprite));
-
-  sprite->destR = new_sprite->destR;
-  free(new_sprite);
+  body_t *body = sprite_get_body(sprite);
+  if (body != NULL) {
+    sprite_place(sprite->destR, body);
+  }
 }
 
-body_t *sprite_get_body(sprite_t *sprite) { return sprite->body; }
+body_t *sprite_get_body(sprite_t *sprite) {
+  return scene_resolve(sprite->scene, sprite->body);
+}
 
-void sprite_add_tex(sprite_t *sprite, SDL_Texture *tex) {
-  list_add(sprite->tex, tex);
+void sprite_add_tex(sprite_t *sprite, const texture_region_t *tex) {
+  // The list only holds borrowed regions and never writes through them
+  list_add(sprite->tex, (texture_region_t *)tex);
 }
 
-SDL_Texture *sprite_get_tex(sprite_t *sprite, size_t index) {
+const texture_region_t *sprite_get_tex(sprite_t *sprite, size_t index) {
   return list_get(sprite->tex, index);
 }
 
@@ -78,13 +94,16 @@ void sprite_set_destR(sprite_t *sprite, SDL_Rect destR) {
 size_t sprite_get_curr_ind(sprite_t *sprite) { return sprite->tex_index; }
 
 bool sprite_is_removed(sprite_t *sprite) {
-  assert(sprite->body != NULL);
-  return body_is_removed(sprite->body);
+  // A stale handle means the body has already left the scene
+  body_t *body = sprite_get_body(sprite);
+  return body == NULL || body_is_removed(body);
 }
 
 void sprite_free(sprite_t *sprite) {
-  free(sprite->tex);
-  free(sprite->path);
-  free(sprite->destR);
-  free(sprite);
+  for (size_t i = 0; i < list_size(sprite->tex); i++) {
+    sdl_release_texture(list_get(sprite->tex, i));
+  }
+  list_free(sprite->tex);
+  scene_release(sprite->scene, sprite->destR, sizeof(SDL_Rect));
+  scene_release(sprite->scene, sprite, sizeof(sprite_t));
 }
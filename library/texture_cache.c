@@ -0,0 +1,429 @@
+#include "texture_cache.h"
+#include "hash.h"
+#include <SDL2/SDL_image.h>
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const size_t TEXTURE_CACHE_INITIAL_CAPACITY = 32;
+// Empty pixels kept around each atlas image, so that filtering at an
+// image's edge never picks up its neighbour
+const int TEXTURE_CACHE_ATLAS_PADDING = 1;
+
+typedef struct texture_entry {
+  // First, so that a borrowed region leads straight back to its entry
+  texture_region_t region;
+  uint64_t hash;
+  char *path;
+  // The decoded image, until it is uploaded
+  SDL_Surface *surface;
+  // False if the image could not be loaded, which is remembered too
+  bool is_loaded;
+  // Atlas images share their page's texture and are never trimmed
+  bool is_atlas;
+  size_t page;
+  size_t references;
+  // The generation at which the entry was trimmed
+  size_t retired;
+} texture_entry_t;
+
+typedef struct entry_list {
+  // Allocated one by one, so that borrowed regions never move
+  texture_entry_t **entries;
+  size_t size;
+  size_t capacity;
+} entry_list_t;
+
+// A game has a few dozen assets, so entries are searched in order
+typedef struct texture_cache {
+  // Held by every function, as loading and uploading run on two threads
+  pthread_mutex_t lock;
+  entry_list_t live;
+  // Trimmed entries whose textures may still be drawn
+  entry_list_t retired;
+  // Atlas pages, as surfaces until they are uploaded
+  SDL_Surface **page_surfaces;
+  SDL_Texture **pages;
+  size_t page_count;
+  // The last texture_id handed out
+  size_t texture_ids;
+  bool has_uploads;
+  size_t generation;
+  size_t loads;
+} texture_cache_t;
+
+typedef struct atlas_item {
+  size_t index;
+  int width;
+  int height;
+} atlas_item_t;
+
+void entry_list_init(entry_list_t *list) {
+  list->entries =
+      malloc(TEXTURE_CACHE_INITIAL_CAPACITY * sizeof(texture_entry_t *));
+  assert(list->entries != NULL);
+  list->size = 0;
+  list->capacity = TEXTURE_CACHE_INITIAL_CAPACITY;
+}
+
+void entry_list_add(entry_list_t *list, texture_entry_t *entry) {
+  if (list->size == list->capacity) {
+    list->capacity *= 2;
+    list->entries =
+        realloc(list->entries, list->capacity * sizeof(texture_entry_t *));
+    assert(list->entries != NULL);
+  }
+  list->entries[list->size++] = entry;
+}
+
+texture_cache_t *texture_cache_init(void) {
+  texture_cache_t *cache = malloc(sizeof(texture_cache_t));
+  assert(cache != NULL);
+  *cache = (texture_cache_t){.page_surfaces = NULL,
+                             .pages = NULL,
+                             .page_count = 0,
+                             .texture_ids = 0,
+                             .has_uploads = false,
+                             .generation = 0,
+                             .loads = 0};
+  pthread_mutex_init(&cache->lock, NULL);
+  entry_list_init(&cache->live);
+  entry_list_init(&cache->retired);
+  return cache;
+}
+
+void texture_entry_free(texture_entry_t *entry) {
+  if (entry->surface != NULL) {
+    SDL_FreeSurface(entry->surface);
+  }
+  if (entry->region.texture != NULL && !entry->is_atlas) {
+    SDL_DestroyTexture(entry->region.texture);
+  }
+  free(entry->path);
+  free(entry);
+}
+
+void texture_cache_free(texture_cache_t *cache) {
+  for (size_t i = 0; i < cache->live.size; i++) {
+    texture_entry_free(cache->live.entries[i]);
+  }
+  for (size_t i = 0; i < cache->retired.size; i++) {
+    texture_entry_free(cache->retired.entries[i]);
+  }
+  for (size_t i = 0; i < cache->page_count; i++) {
+    if (cache->page_surfaces[i] != NULL) {
+      SDL_FreeSurface(cache->page_surfaces[i]);
+    }
+    if (cache->pages[i] != NULL) {
+      SDL_DestroyTexture(cache->pages[i]);
+    }
+  }
+  free(cache->page_surfaces);
+  free(cache->pages);
+  free(cache->live.entries);
+  free(cache->retired.entries);
+  pthread_mutex_destroy(&cache->lock);
+  free(cache);
+}
+
+texture_entry_t *texture_cache_find(texture_cache_t *cache, const char *path,
+                                    uint64_t hash) {
+  for (size_t i = 0; i < cache->live.size; i++) {
+    texture_entry_t *entry = cache->live.entries[i];
+    if (entry->hash == hash && strcmp(entry->path, path) == 0) {
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+/** Adds an entry for an image that is not loaded yet */
+texture_entry_t *texture_cache_add(texture_cache_t *cache, const char *path,
+                                   uint64_t hash) {
+  texture_entry_t *entry = malloc(sizeof(texture_entry_t));
+  assert(entry != NULL);
+  *entry = (texture_entry_t){.region = {.texture = NULL},
+                             .hash = hash,
+                             .path = strdup(path),
+                             .surface = NULL,
+                             .is_loaded = false,
+                             .is_atlas = false,
+                             .page = 0,
+                             .references = 0,
+                             .retired = 0};
+  assert(entry->path != NULL);
+  entry_list_add(&cache->live, entry);
+  return entry;
+}
+
+SDL_Surface *texture_cache_load(texture_cache_t *cache, const char *path) {
+  cache->loads++;
+  SDL_Surface *surface = IMG_Load(path);
+  if (surface != NULL) {
+    SDL_SetColorKey(surface, SDL_TRUE,
+                    SDL_MapRGB(surface->format, 255, 255, 255));
+  }
+  return surface;
+}
+
+/** Hands an entry its own image, to be uploaded as a texture of its own */
+void texture_entry_set_surface(texture_cache_t *cache, texture_entry_t *entry,
+                               SDL_Surface *surface) {
+  entry->surface = surface;
+  entry->is_loaded = true;
+  entry->region = (texture_region_t){
+      .texture = NULL,
+      .texture_id = ++cache->texture_ids,
+      .source = {.x = 0, .y = 0, .w = surface->w, .h = surface->h},
+      .texture_width = surface->w,
+      .texture_height = surface->h};
+  cache->has_uploads = true;
+}
+
+int atlas_item_compare(const void *a, const void *b) {
+  const atlas_item_t *item_a = a, *item_b = b;
+  // Tallest first, so each shelf wastes little height
+  if (item_a->height != item_b->height) {
+    return item_b->height - item_a->height;
+  }
+  return item_b->width - item_a->width;
+}
+
+size_t texture_cache_build_atlas(texture_cache_t *cache,
+                                 const char *const *paths, size_t count,
+                                 int page_size) {
+  const int PADDING = TEXTURE_CACHE_ATLAS_PADDING;
+  pthread_mutex_lock(&cache->lock);
+  SDL_Surface **images = calloc(count, sizeof(SDL_Surface *));
+  texture_entry_t **entries = calloc(count, sizeof(texture_entry_t *));
+  atlas_item_t *items = malloc(count * sizeof(atlas_item_t));
+  assert(images != NULL && entries != NULL && items != NULL);
+  size_t item_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint64_t hash = hash_bytes(HASH_INIT, paths[i], strlen(paths[i]));
+    if (texture_cache_find(cache, paths[i], hash) != NULL) {
+      continue;
+    }
+    entries[i] = texture_cache_add(cache, paths[i], hash);
+    images[i] = texture_cache_load(cache, paths[i]);
+    if (images[i] == NULL) {
+      continue;
+    }
+    if (images[i]->w + 2 * PADDING > page_size ||
+        images[i]->h + 2 * PADDING > page_size) {
+      texture_entry_set_surface(cache, entries[i], images[i]);
+      images[i] = NULL;
+      continue;
+    }
+    items[item_count++] = (atlas_item_t){
+        .index = i, .width = images[i]->w, .height = images[i]->h};
+  }
+  qsort(items, item_count, sizeof(atlas_item_t), atlas_item_compare);
+
+  // Shelf packing: images fill rows left to right, and each row is as tall
+  // as its first image. Pages are only as tall as what they hold.
+  SDL_Rect *places = malloc(count * sizeof(SDL_Rect));
+  size_t *place_pages = malloc(count * sizeof(size_t));
+  int *page_heights = calloc(item_count + 1, sizeof(int));
+  assert(places != NULL && place_pages != NULL && page_heights != NULL);
+  size_t page = 0;
+  int x = 0, y = 0, shelf_height = 0;
+  for (size_t i = 0; i < item_count; i++) {
+    int width = items[i].width + 2 * PADDING;
+    int height = items[i].height + 2 * PADDING;
+    if (x + width > page_size) {
+      x = 0;
+      y += shelf_height;
+      shelf_height = 0;
+    }
+    if (y + height > page_size) {
+      page++;
+      x = 0;
+      y = 0;
+      shelf_height = 0;
+    }
+    places[items[i].index] = (SDL_Rect){.x = x + PADDING,
+                                        .y = y + PADDING,
+                                        .w = items[i].width,
+                                        .h = items[i].height};
+    place_pages[items[i].index] = page;
+    x += width;
+    shelf_height = height > shelf_height ? height : shelf_height;
+    page_heights[page] =
+        y + height > page_heights[page] ? y + height : page_heights[page];
+  }
+  size_t new_pages = item_count > 0 ? page + 1 : 0;
+
+  size_t page_count = cache->page_count + new_pages;
+  cache->page_surfaces =
+      realloc(cache->page_surfaces, page_count * sizeof(SDL_Surface *));
+  cache->pages = realloc(cache->pages, page_count * sizeof(SDL_Texture *));
+  assert(page_count == 0 ||
+         (cache->page_surfaces != NULL && cache->pages != NULL));
+  for (size_t p = 0; p < new_pages; p++) {
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+        0, page_size, page_heights[p], 32, SDL_PIXELFORMAT_RGBA32);
+    assert(surface != NULL);
+    size_t page_index = cache->page_count + p;
+    size_t texture_id = ++cache->texture_ids;
+    for (size_t i = 0; i < item_count; i++) {
+      size_t index = items[i].index;
+      if (place_pages[index] != p) {
+        continue;
+      }
+      // Copy pixels as they are, leaving color-keyed ones transparent
+      SDL_SetSurfaceBlendMode(images[index], SDL_BLENDMODE_NONE);
+      SDL_BlitSurface(images[index], NULL, surface, &places[index]);
+      entries[index]->is_loaded = true;
+      entries[index]->is_atlas = true;
+      entries[index]->page = page_index;
+      entries[index]->region =
+          (texture_region_t){.texture = NULL,
+                             .texture_id = texture_id,
+                             .source = places[index],
+                             .texture_width = page_size,
+                             .texture_height = page_heights[p]};
+    }
+    cache->page_surfaces[page_index] = surface;
+    cache->pages[page_index] = NULL;
+  }
+  cache->page_count = page_count;
+  cache->has_uploads = cache->has_uploads || new_pages > 0;
+
+  for (size_t i = 0; i < count; i++) {
+    if (images[i] != NULL) {
+      SDL_FreeSurface(images[i]);
+    }
+  }
+  free(images);
+  free(entries);
+  free(items);
+  free(places);
+  free(place_pages);
+  free(page_heights);
+  pthread_mutex_unlock(&cache->lock);
+  return new_pages;
+}
+
+const texture_region_t *texture_cache_acquire(texture_cache_t *cache,
+                                              const char *path) {
+  pthread_mutex_lock(&cache->lock);
+  uint64_t hash = hash_bytes(HASH_INIT, path, strlen(path));
+  texture_entry_t *entry = texture_cache_find(cache, path, hash);
+  if (entry == NULL) {
+    entry = texture_cache_add(cache, path, hash);
+    SDL_Surface *surface = texture_cache_load(cache, path);
+    if (surface != NULL) {
+      texture_entry_set_surface(cache, entry, surface);
+    }
+  }
+  const texture_region_t *region = NULL;
+  if (entry->is_loaded) {
+    entry->references++;
+    region = &entry->region;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return region;
+}
+
+void texture_cache_release(texture_cache_t *cache,
+                           const texture_region_t *region) {
+  if (region == NULL) {
+    return;
+  }
+  texture_entry_t *entry = (texture_entry_t *)region;
+  pthread_mutex_lock(&cache->lock);
+  assert(entry->references > 0);
+  entry->references--;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+void texture_cache_upload(texture_cache_t *cache, SDL_Renderer *renderer) {
+  pthread_mutex_lock(&cache->lock);
+  if (!cache->has_uploads) {
+    pthread_mutex_unlock(&cache->lock);
+    return;
+  }
+  for (size_t i = 0; i < cache->page_count; i++) {
+    if (cache->page_surfaces[i] == NULL) {
+      continue;
+    }
+    cache->pages[i] =
+        SDL_CreateTextureFromSurface(renderer, cache->page_surfaces[i]);
+    if (cache->pages[i] != NULL) {
+      SDL_SetTextureBlendMode(cache->pages[i], SDL_BLENDMODE_BLEND);
+    }
+    SDL_FreeSurface(cache->page_surfaces[i]);
+    cache->page_surfaces[i] = NULL;
+  }
+  for (size_t i = 0; i < cache->live.size; i++) {
+    texture_entry_t *entry = cache->live.entries[i];
+    if (entry->is_atlas) {
+      entry->region.texture = cache->pages[entry->page];
+    } else if (entry->surface != NULL) {
+      entry->region.texture =
+          SDL_CreateTextureFromSurface(renderer, entry->surface);
+      SDL_FreeSurface(entry->surface);
+      entry->surface = NULL;
+    }
+  }
+  cache->has_uploads = false;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+size_t texture_cache_trim(texture_cache_t *cache) {
+  pthread_mutex_lock(&cache->lock);
+  size_t kept = 0;
+  size_t retired = 0;
+  for (size_t i = 0; i < cache->live.size; i++) {
+    texture_entry_t *entry = cache->live.entries[i];
+    if (entry->references > 0 || entry->is_atlas) {
+      cache->live.entries[kept++] = entry;
+    } else if (!entry->is_loaded) {
+      // Images that failed to load are dropped too, to be tried again
+      texture_entry_free(entry);
+    } else {
+      entry->retired = cache->generation + 1;
+      entry_list_add(&cache->retired, entry);
+      retired++;
+    }
+  }
+  cache->live.size = kept;
+  if (retired > 0) {
+    cache->generation++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return retired;
+}
+
+size_t texture_cache_generation(texture_cache_t *cache) {
+  pthread_mutex_lock(&cache->lock);
+  size_t generation = cache->generation;
+  pthread_mutex_unlock(&cache->lock);
+  return generation;
+}
+
+void texture_cache_collect(texture_cache_t *cache, size_t generation) {
+  pthread_mutex_lock(&cache->lock);
+  size_t kept = 0;
+  for (size_t i = 0; i < cache->retired.size; i++) {
+    texture_entry_t *entry = cache->retired.entries[i];
+    if (entry->retired <= generation) {
+      texture_entry_free(entry);
+    } else {
+      cache->retired.entries[kept++] = entry;
+    }
+  }
+  cache->retired.size = kept;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+size_t texture_cache_loads(texture_cache_t *cache) {
+  pthread_mutex_lock(&cache->lock);
+  size_t loads = cache->loads;
+  pthread_mutex_unlock(&cache->lock);
+  return loads;
+}
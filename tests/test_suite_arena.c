@@ -0,0 +1,115 @@
+#include "arena.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdalign.h>
+#include <stdint.h>
+#include <string.h>
+
+const size_t ARENA_TEST_BLOCK = 1024;
+
+void test_alloc_aligned_and_disjoint(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  unsigned char *first = arena_alloc(arena, 3);
+  unsigned char *second = arena_alloc(arena, 5);
+  assert((uintptr_t)first % alignof(max_align_t) == 0);
+  assert((uintptr_t)second % alignof(max_align_t) == 0);
+  assert(second >= first + 3 || first >= second + 5);
+  memset(first, 1, 3);
+  memset(second, 2, 5);
+  assert(first[2] == 1);
+  // Sizes are counted as handed out, rounded up to the alignment
+  assert(arena_used(arena) == 2 * alignof(max_align_t));
+  arena_free(arena);
+}
+
+void test_alloc_larger_than_block(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  unsigned char *small = arena_alloc(arena, 16);
+  unsigned char *large = arena_alloc(arena, 4 * ARENA_TEST_BLOCK);
+  memset(large, 3, 4 * ARENA_TEST_BLOCK);
+  memset(small, 4, 16);
+  assert(large[4 * ARENA_TEST_BLOCK - 1] == 3);
+  assert(small[0] == 4);
+  arena_free(arena);
+}
+
+void test_release_reuses_same_size(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  void *first = arena_alloc(arena, 48);
+  void *other = arena_alloc(arena, 96);
+  size_t used = arena_used(arena);
+  arena_release(arena, first, 48);
+  assert(arena_used(arena) == used - 48);
+  // A different size does not take the released memory
+  void *bigger = arena_alloc(arena, 64);
+  assert(bigger != first);
+  assert(arena_alloc(arena, 48) == first);
+  arena_release(arena, other, 96);
+  assert(arena_alloc(arena, 96) == other);
+  arena_free(arena);
+}
+
+void test_release_is_last_in_first_out(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  void *a = arena_alloc(arena, 32);
+  void *b = arena_alloc(arena, 32);
+  arena_release(arena, a, 32);
+  arena_release(arena, b, 32);
+  assert(arena_alloc(arena, 32) == b);
+  assert(arena_alloc(arena, 32) == a);
+  arena_free(arena);
+}
+
+void test_release_large_sizes(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  // Past the per-size lists, released memory is matched by exact size
+  void *large = arena_alloc(arena, 4000);
+  void *larger = arena_alloc(arena, 5000);
+  arena_release(arena, large, 4000);
+  arena_release(arena, larger, 5000);
+  assert(arena_alloc(arena, 4000) == large);
+  assert(arena_alloc(arena, 5000) == larger);
+  arena_free(arena);
+}
+
+void test_spawn_cycles_stay_flat(void) {
+  arena_t *arena = arena_init(ARENA_TEST_BLOCK);
+  arena_alloc(arena, 200);
+  size_t used = arena_used(arena);
+  // Objects of mixed sizes come and go like bullets between respawns, and
+  // land where the first ones did rather than growing the arena
+  void *first_body = NULL;
+  for (size_t i = 0; i < 1000; i++) {
+    void *body = arena_alloc(arena, 120);
+    void *shape = arena_alloc(arena, 4 * 16);
+    void *aux = arena_alloc(arena, 24);
+    if (first_body == NULL) {
+      first_body = body;
+    }
+    assert(body == first_body);
+    arena_release(arena, shape, 4 * 16);
+    arena_release(arena, body, 120);
+    arena_release(arena, aux, 24);
+    assert(arena_used(arena) == used);
+  }
+  arena_free(arena);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_alloc_aligned_and_disjoint)
+  DO_TEST(test_alloc_larger_than_block)
+  DO_TEST(test_release_reuses_same_size)
+  DO_TEST(test_release_is_last_in_first_out)
+  DO_TEST(test_release_large_sizes)
+  DO_TEST(test_spawn_cycles_stay_flat)
+
+  puts("arena_test PASS");
+}
@@ -0,0 +1,116 @@
+#include "envs.h"
+#include "projectile.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+const uint64_t ENVS_TEST_SEED = 3;
+const size_t ENVS_TEST_COUNT = 3;
+const size_t ENVS_TEST_TICKS = 240;
+// The layout documented in envs.h
+const size_t ENVS_TEST_PLAYER_FLOATS = 7;
+const size_t ENVS_TEST_PROJECTILE_FLOATS = 5;
+const size_t ENVS_TEST_NEAREST = 4;
+const body_type_t ENVS_TEST_PLAYERS[2] = {PLAYER1, PLAYER2};
+
+/** Checks one match's observation against the match itself */
+void envs_test_check(envs_t *envs, size_t index, const float *observation) {
+  state_t *state = envs_get_match(envs, index);
+  scene_t *scene = match_get_scene(state);
+  projectiles_t *projectiles = scene_get_projectiles(scene);
+  size_t player_floats = envs_observation_size() / 2;
+  for (size_t p = 0; p < 2; p++) {
+    const float *out = &observation[p * player_floats];
+    body_t *player = scene_first_of_type(scene, ENVS_TEST_PLAYERS[p]);
+    if (player == NULL) {
+      for (size_t i = 0; i < player_floats; i++) {
+        assert(out[i] == 0);
+      }
+      continue;
+    }
+    vector_t position = body_get_centroid(player);
+    assert(isclose(out[0], (float)position.x));
+    assert(isclose(out[1], (float)position.y));
+    assert(out[6] == match_get_lives(state, ENVS_TEST_PLAYERS[p]));
+
+    // Present projectiles come first, closest first, and match real ones
+    const float *shots = &out[ENVS_TEST_PLAYER_FLOATS];
+    size_t present = 0;
+    double last_distance = 0;
+    for (size_t i = 0; i < ENVS_TEST_NEAREST; i++) {
+      const float *shot = &shots[i * ENVS_TEST_PROJECTILE_FLOATS];
+      if (shot[4] == 0) {
+        for (size_t j = 0; j < ENVS_TEST_PROJECTILE_FLOATS; j++) {
+          assert(shot[j] == 0);
+        }
+        continue;
+      }
+      assert(shot[4] == 1);
+      assert(present == i);
+      present++;
+      double distance = hypot(shot[0], shot[1]);
+      assert(distance + 1e-3 >= last_distance);
+      last_distance = distance;
+    }
+    size_t expected = projectiles_size(projectiles);
+    assert(present ==
+           (expected < ENVS_TEST_NEAREST ? expected : ENVS_TEST_NEAREST));
+  }
+}
+
+void test_observation_size(void) {
+  assert(envs_observation_size() ==
+         2 * (ENVS_TEST_PLAYER_FLOATS +
+              ENVS_TEST_NEAREST * ENVS_TEST_PROJECTILE_FLOATS));
+}
+
+void test_observations_follow_matches(void) {
+  envs_t *envs = envs_init(ENVS_TEST_COUNT, MAP2, ENVS_TEST_SEED, 2);
+  assert(envs_count(envs) == ENVS_TEST_COUNT);
+  size_t size = envs_observation_size();
+  float *observations = malloc(ENVS_TEST_COUNT * size * sizeof(float));
+  uint8_t *actions = malloc(ENVS_TEST_COUNT * 2 * sizeof(uint8_t));
+  bool *dones = malloc(ENVS_TEST_COUNT * sizeof(bool));
+  assert(observations != NULL && actions != NULL && dones != NULL);
+
+  envs_observe(envs, observations);
+  for (size_t i = 0; i < ENVS_TEST_COUNT; i++) {
+    envs_test_check(envs, i, &observations[i * size]);
+  }
+  // Both players keep shooting, so projectiles fill the nearest slots
+  size_t shot_ticks = 0;
+  for (size_t tick = 0; tick < ENVS_TEST_TICKS; tick++) {
+    for (size_t i = 0; i < ENVS_TEST_COUNT * 2; i++) {
+      uint8_t move = (tick / 30 + i) % 2 == 0 ? ENV_ACTION_LEFT
+                                               : ENV_ACTION_RIGHT;
+      actions[i] = move | (tick % 2 == 0 ? ENV_ACTION_SHOOT : 0);
+    }
+    envs_step(envs, actions, observations, dones);
+    for (size_t i = 0; i < ENVS_TEST_COUNT; i++) {
+      envs_test_check(envs, i, &observations[i * size]);
+      shot_ticks += observations[i * size + ENVS_TEST_PLAYER_FLOATS + 4] != 0;
+    }
+  }
+  assert(shot_ticks > 0);
+
+  free(observations);
+  free(actions);
+  free(dones);
+  envs_free(envs);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_observation_size)
+  DO_TEST(test_observations_follow_matches)
+
+  puts("envs_test PASS");
+}
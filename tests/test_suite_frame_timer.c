@@ -0,0 +1,76 @@
+#include "frame_timer.h"
+#include "test_util.h"
+#include <assert.h>
+
+void test_percentiles(void) {
+  frame_timer_t *timer = frame_timer_init(100);
+  // 1 ms to 100 ms, out of order; 37 and 100 share no factor
+  for (size_t i = 0; i < 100; i++) {
+    frame_timer_add(timer, (i * 37 % 100 + 1) / 1e3);
+  }
+  frame_stats_t stats = frame_timer_stats(timer);
+  assert(stats.frames == 100);
+  assert(isclose(stats.min, 1e-3));
+  assert(isclose(stats.avg, 50.5e-3));
+  assert(isclose(stats.p50, 50e-3));
+  assert(isclose(stats.p95, 95e-3));
+  assert(isclose(stats.p99, 99e-3));
+  assert(isclose(stats.max, 100e-3));
+  frame_timer_free(timer);
+}
+
+void test_percentiles_round_up(void) {
+  frame_timer_t *timer = frame_timer_init(10);
+  for (size_t i = 1; i <= 3; i++) {
+    frame_timer_add(timer, i);
+  }
+  // The nearest rank at or above 1.5 of 3 is the second
+  frame_stats_t stats = frame_timer_stats(timer);
+  assert(stats.frames == 3);
+  assert(isclose(stats.p50, 2));
+  assert(isclose(stats.p95, 3));
+  assert(isclose(stats.p99, 3));
+  frame_timer_free(timer);
+}
+
+void test_window_keeps_latest(void) {
+  frame_timer_t *timer = frame_timer_init(10);
+  for (size_t i = 1; i <= 25; i++) {
+    frame_timer_add(timer, i);
+  }
+  frame_stats_t stats = frame_timer_stats(timer);
+  assert(stats.frames == 10);
+  assert(isclose(stats.min, 16));
+  assert(isclose(stats.max, 25));
+  assert(isclose(stats.avg, 20.5));
+  assert(isclose(stats.p50, 20));
+  frame_timer_free(timer);
+}
+
+void test_first_tick_measures_nothing(void) {
+  frame_timer_t *timer = frame_timer_init(10);
+  frame_stats_t stats = frame_timer_stats(timer);
+  assert(stats.frames == 0 && stats.max == 0);
+  assert(frame_timer_tick(timer) == 0);
+  assert(frame_timer_stats(timer).frames == 0);
+  assert(frame_timer_tick(timer) >= 0);
+  assert(frame_timer_stats(timer).frames == 1);
+  frame_timer_free(timer);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_percentiles)
+  DO_TEST(test_percentiles_round_up)
+  DO_TEST(test_window_keeps_latest)
+  DO_TEST(test_first_tick_measures_nothing)
+
+  puts("frame_timer_test PASS");
+}
@@ -0,0 +1,79 @@
+#include "jobs.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const size_t JOBS_TEST_COUNT = 10000;
+const size_t JOBS_TEST_ROUNDS = 50;
+
+typedef struct jobs_test_loop {
+  size_t *visits;
+  size_t count;
+  size_t grain;
+} jobs_test_loop_t;
+
+void jobs_test_visit(jobs_test_loop_t *loop, size_t begin, size_t end) {
+  assert(begin <= end && end <= loop->count);
+  // Only a loop too short to split runs a chunk smaller than the grain
+  assert(end - begin >= loop->grain || end == loop->count);
+  for (size_t i = begin; i < end; i++) {
+    loop->visits[i]++;
+  }
+}
+
+/** Runs loops of many sizes and checks each item was visited once a loop */
+void jobs_test_cover(jobs_t *jobs, size_t grain) {
+  size_t *visits = calloc(JOBS_TEST_COUNT, sizeof(size_t));
+  assert(visits != NULL);
+  size_t counts[] = {0, 1, grain, grain + 1, 3 * grain - 1, JOBS_TEST_COUNT};
+  size_t count_total = sizeof(counts) / sizeof(counts[0]);
+  for (size_t round = 0; round < JOBS_TEST_ROUNDS; round++) {
+    for (size_t c = 0; c < count_total; c++) {
+      jobs_test_loop_t loop = {
+          .visits = visits, .count = counts[c], .grain = grain};
+      jobs_parallel_for(jobs, loop.count, grain, (job_func_t)jobs_test_visit,
+                        &loop);
+      // The loop has finished by the time jobs_parallel_for() returns
+      for (size_t i = 0; i < JOBS_TEST_COUNT; i++) {
+        assert(visits[i] == (i < loop.count ? 1 : 0));
+        visits[i] = 0;
+      }
+    }
+  }
+  free(visits);
+}
+
+void test_inline_without_jobs(void) { jobs_test_cover(NULL, 16); }
+
+void test_one_thread(void) {
+  jobs_t *jobs = jobs_init(1);
+  assert(jobs_threads(jobs) == 1);
+  jobs_test_cover(jobs, 16);
+  jobs_free(jobs);
+}
+
+void test_many_threads(void) {
+  jobs_t *jobs = jobs_init(4);
+  assert(jobs_threads(jobs) == 4);
+  // Small grains make many chunks, so idle threads steal from busy ones
+  jobs_test_cover(jobs, 1);
+  jobs_test_cover(jobs, 7);
+  jobs_test_cover(jobs, 256);
+  jobs_free(jobs);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_inline_without_jobs)
+  DO_TEST(test_one_thread)
+  DO_TEST(test_many_threads)
+
+  puts("jobs_test PASS");
+}
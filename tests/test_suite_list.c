@@ -0,0 +1,93 @@
+#include "list.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+#define LIST_TEST_SIZE 10
+
+size_t list_test_freed = 0;
+
+bool list_test_is_odd(size_t *value) { return *value % 2 == 1; }
+
+bool list_test_is_any(size_t *value) { return true; }
+
+bool list_test_is_none(size_t *value) { return false; }
+
+void list_test_free(size_t *value) {
+  list_test_freed++;
+  free(value);
+}
+
+list_t *list_test_numbers(void) {
+  list_t *list = list_init(1, (free_func_t)list_test_free);
+  for (size_t i = 0; i < LIST_TEST_SIZE; i++) {
+    size_t *value = malloc(sizeof(size_t));
+    assert(value != NULL);
+    *value = i;
+    list_add(list, value);
+  }
+  list_test_freed = 0;
+  return list;
+}
+
+void test_remove_if_keeps_order(void) {
+  list_t *list = list_test_numbers();
+  size_t removed = list_remove_if(list, (list_pred_t)list_test_is_odd);
+  assert(removed == LIST_TEST_SIZE / 2);
+  assert(list_size(list) == LIST_TEST_SIZE / 2);
+  for (size_t i = 0; i < list_size(list); i++) {
+    assert(*(size_t *)list_get(list, i) == 2 * i);
+  }
+  // Removed elements go through the list's freer exactly once
+  assert(list_test_freed == LIST_TEST_SIZE / 2);
+  list_free(list);
+}
+
+void test_remove_if_all_or_none(void) {
+  list_t *list = list_test_numbers();
+  assert(list_remove_if(list, (list_pred_t)list_test_is_none) == 0);
+  assert(list_size(list) == LIST_TEST_SIZE);
+  assert(list_test_freed == 0);
+  assert(list_remove_if(list, (list_pred_t)list_test_is_any) ==
+         LIST_TEST_SIZE);
+  assert(list_size(list) == 0);
+  assert(list_test_freed == LIST_TEST_SIZE);
+  // The list is still usable afterwards
+  size_t *value = malloc(sizeof(size_t));
+  assert(value != NULL);
+  *value = 42;
+  list_add(list, value);
+  assert(*(size_t *)list_get(list, 0) == 42);
+  list_free(list);
+}
+
+void test_remove_if_without_freer(void) {
+  size_t values[LIST_TEST_SIZE];
+  list_t *list = list_init(LIST_TEST_SIZE, NULL);
+  for (size_t i = 0; i < LIST_TEST_SIZE; i++) {
+    values[i] = i;
+    list_add(list, &values[i]);
+  }
+  // Elements the list does not own are dropped but left alone
+  assert(list_remove_if(list, (list_pred_t)list_test_is_odd) ==
+         LIST_TEST_SIZE / 2);
+  assert(list_get(list, 1) == &values[2]);
+  assert(values[1] == 1);
+  list_free(list);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_remove_if_keeps_order)
+  DO_TEST(test_remove_if_all_or_none)
+  DO_TEST(test_remove_if_without_freer)
+
+  puts("list_test PASS");
+}
@@ -0,0 +1,96 @@
+#include "arena.h"
+#include "pool.h"
+#include "test_util.h"
+#include <assert.h>
+
+#define POOL_TEST_CAPACITY 4
+
+void test_take_returns_what_was_put(void) {
+  pool_t *pool = pool_init(NULL, POOL_TEST_CAPACITY);
+  int objects[POOL_TEST_CAPACITY];
+  for (size_t i = 0; i < POOL_TEST_CAPACITY; i++) {
+    pool_put(pool, &objects[i]);
+  }
+  assert(pool_capacity(pool) == POOL_TEST_CAPACITY);
+  assert(pool_in_use(pool) == 0);
+  // Most recently put first, so the warmest object is reused
+  for (size_t i = POOL_TEST_CAPACITY; i > 0; i--) {
+    assert(pool_take(pool) == &objects[i - 1]);
+  }
+  assert(pool_in_use(pool) == POOL_TEST_CAPACITY);
+  pool_free(pool);
+}
+
+void test_empty_take_counts_miss(void) {
+  pool_t *pool = pool_init(NULL, POOL_TEST_CAPACITY);
+  assert(pool_take(pool) == NULL);
+  assert(pool_misses(pool) == 1);
+  int object;
+  pool_put(pool, &object);
+  assert(pool_take(pool) == &object);
+  assert(pool_take(pool) == NULL);
+  assert(pool_misses(pool) == 2);
+  pool_free(pool);
+}
+
+void test_high_water(void) {
+  pool_t *pool = pool_init(NULL, POOL_TEST_CAPACITY);
+  int objects[POOL_TEST_CAPACITY];
+  for (size_t i = 0; i < POOL_TEST_CAPACITY; i++) {
+    pool_put(pool, &objects[i]);
+  }
+  void *first = pool_take(pool);
+  void *second = pool_take(pool);
+  void *third = pool_take(pool);
+  assert(pool_high_water(pool) == 3);
+  pool_put(pool, third);
+  pool_put(pool, second);
+  assert(pool_in_use(pool) == 1);
+  // Reuse within the mark does not raise it
+  pool_put(pool, pool_take(pool));
+  assert(pool_high_water(pool) == 3);
+  pool_put(pool, first);
+  assert(pool_in_use(pool) == 0);
+  assert(pool_misses(pool) == 0);
+  pool_free(pool);
+}
+
+void test_arena_pool(void) {
+  arena_t *arena = arena_init(1024);
+  pool_t *pool = pool_init(arena, POOL_TEST_CAPACITY);
+  size_t used = arena_used(arena);
+  assert(used > 0);
+  // Objects carved from the same arena recycle through the pool, so the
+  // arena stops growing once it is stocked
+  for (size_t i = 0; i < POOL_TEST_CAPACITY; i++) {
+    pool_put(pool, arena_alloc(arena, 64));
+  }
+  used = arena_used(arena);
+  for (size_t i = 0; i < 100; i++) {
+    void *object = pool_take(pool);
+    assert(object != NULL);
+    pool_put(pool, object);
+  }
+  assert(arena_used(arena) == used);
+  assert(pool_misses(pool) == 0);
+  // The pool goes with its arena
+  pool_free(pool);
+  arena_free(arena);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_take_returns_what_was_put)
+  DO_TEST(test_empty_take_counts_miss)
+  DO_TEST(test_high_water)
+  DO_TEST(test_arena_pool)
+
+  puts("pool_test PASS");
+}
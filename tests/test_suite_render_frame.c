@@ -0,0 +1,141 @@
+#include "render_frame.h"
+#include "rng.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+// Ids on either side of each byte of the sort key, and one that shares its
+// low bits with another
+const size_t RENDER_FRAME_TEST_IDS[] = {1,   2,   255,   256,
+                                        257, 511, 65535, 65536 + 2};
+const size_t RENDER_FRAME_TEST_ID_COUNT =
+    sizeof(RENDER_FRAME_TEST_IDS) / sizeof(*RENDER_FRAME_TEST_IDS);
+const uint8_t RENDER_FRAME_TEST_LAYERS = 7;
+const size_t RENDER_FRAME_TEST_COMMANDS = 5000;
+
+/** What the test recorded, to check the drawing order against */
+typedef struct recorded {
+  uint8_t layer;
+  // 0 for polygons
+  size_t texture_bits;
+} recorded_t;
+
+/** Records commands on random layers and textures */
+recorded_t *render_frame_test_record(render_frame_t *frame,
+                                     texture_region_t *regions, size_t count,
+                                     uint64_t seed) {
+  rng_t *rng = rng_init(seed, 0);
+  recorded_t *recorded = malloc(count * sizeof(recorded_t));
+  assert(recorded != NULL);
+  for (size_t i = 0; i < count; i++) {
+    uint8_t layer = rng_below(rng, RENDER_FRAME_TEST_LAYERS);
+    if (rng_below(rng, 3) == 0) {
+      render_frame_start_polygon(frame, layer, (SDL_Color){0, 0, 0, 255});
+      render_frame_add_vertex(frame, (SDL_FPoint){0, 0});
+      recorded[i] = (recorded_t){.layer = layer, .texture_bits = 0};
+    } else {
+      texture_region_t *region =
+          &regions[rng_below(rng, RENDER_FRAME_TEST_ID_COUNT)];
+      render_frame_add_sprite(frame, layer, region, (SDL_Rect){0, 0, 1, 1},
+                              false);
+      recorded[i] = (recorded_t){.layer = layer,
+                                 .texture_bits = region->texture_id & 0xffff};
+    }
+  }
+  rng_free(rng);
+  return recorded;
+}
+
+texture_region_t *render_frame_test_regions(void) {
+  texture_region_t *regions =
+      malloc(RENDER_FRAME_TEST_ID_COUNT * sizeof(texture_region_t));
+  assert(regions != NULL);
+  for (size_t i = 0; i < RENDER_FRAME_TEST_ID_COUNT; i++) {
+    regions[i] = (texture_region_t){.texture = NULL,
+                                    .texture_id = RENDER_FRAME_TEST_IDS[i],
+                                    .source = {0, 0, 1, 1},
+                                    .texture_width = 1,
+                                    .texture_height = 1};
+  }
+  return regions;
+}
+
+/** Checks that an order is a permutation sorted by layer, then texture */
+void render_frame_test_check(const size_t *order, recorded_t *recorded,
+                             size_t count) {
+  bool *is_seen = calloc(count, sizeof(bool));
+  assert(is_seen != NULL);
+  for (size_t i = 0; i < count; i++) {
+    assert(order[i] < count && !is_seen[order[i]]);
+    is_seen[order[i]] = true;
+    if (i == 0) {
+      continue;
+    }
+    recorded_t *last = &recorded[order[i - 1]];
+    recorded_t *next = &recorded[order[i]];
+    assert(last->layer <= next->layer);
+    if (last->layer == next->layer) {
+      assert(last->texture_bits <= next->texture_bits);
+      // Ties keep the order they were recorded in
+      if (last->texture_bits == next->texture_bits) {
+        assert(order[i - 1] < order[i]);
+      }
+    }
+  }
+  free(is_seen);
+}
+
+void test_sort_orders_by_layer_then_texture(void) {
+  render_frame_t *frame = render_frame_init();
+  texture_region_t *regions = render_frame_test_regions();
+  for (uint64_t seed = 0; seed < 10; seed++) {
+    render_frame_clear(frame);
+    size_t count = RENDER_FRAME_TEST_COMMANDS / (seed + 1);
+    recorded_t *recorded =
+        render_frame_test_record(frame, regions, count, seed);
+    render_frame_test_check(render_frame_sort(frame), recorded, count);
+    free(recorded);
+  }
+  free(regions);
+  render_frame_free(frame);
+}
+
+void test_sort_keeps_recording_order(void) {
+  render_frame_t *frame = render_frame_init();
+  texture_region_t *regions = render_frame_test_regions();
+  // Ids 2 and 65536 + 2 share their low bits, so they sort as one texture
+  texture_region_t *same_bits[] = {&regions[1],
+                                   &regions[RENDER_FRAME_TEST_ID_COUNT - 1]};
+  for (size_t i = 0; i < RENDER_FRAME_TEST_COMMANDS; i++) {
+    render_frame_add_sprite(frame, 3, same_bits[i % 2], (SDL_Rect){0, 0, 1, 1},
+                            false);
+  }
+  const size_t *order = render_frame_sort(frame);
+  for (size_t i = 0; i < RENDER_FRAME_TEST_COMMANDS; i++) {
+    assert(order[i] == i);
+  }
+  free(regions);
+  render_frame_free(frame);
+}
+
+void test_sort_empty_frame(void) {
+  render_frame_t *frame = render_frame_init();
+  assert(render_frame_sort(frame) != NULL);
+  render_frame_free(frame);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_sort_orders_by_layer_then_texture)
+  DO_TEST(test_sort_keeps_recording_order)
+  DO_TEST(test_sort_empty_frame)
+
+  puts("render_frame_test PASS");
+}
@@ -0,0 +1,105 @@
+#include "match.h"
+#include "replay.h"
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdio.h>
+
+const char REPLAY_TEST_PATH[] = "test_replay.bin";
+const uint64_t REPLAY_TEST_SEED = 7;
+const size_t REPLAY_TEST_TICKS = 600;
+const char REPLAY_TEST_KEYS[] = {A_KEY,      D_KEY,       W_KEY,    SPACE,
+                                 LEFT_ARROW, RIGHT_ARROW, UP_ARROW, PERIOD};
+const size_t REPLAY_TEST_KEY_COUNT = sizeof(REPLAY_TEST_KEYS);
+
+/** Whether a key is held on a tick, the same on every run */
+bool replay_test_is_held(size_t tick, size_t key) {
+  return (tick / 6 + key * 5) % 4 != 0;
+}
+
+void replay_test_key(char key, key_event_type_t type, double held_time,
+                     state_t *state) {
+  match_key(state, key, type == KEY_PRESSED);
+}
+
+/** Plays a match with scripted keys, recording it to REPLAY_TEST_PATH */
+void replay_test_record(void) {
+  replay_t *replay =
+      replay_record(REPLAY_TEST_PATH, REPLAY_TEST_SEED, RUNTIME_TICK_DT);
+  assert(replay != NULL);
+  assert(replay_is_recording(replay));
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  state_t *state = match_init(MAP2, REPLAY_TEST_SEED);
+  for (size_t tick = 0; tick < REPLAY_TEST_TICKS; tick++) {
+    for (size_t key = 0; key < REPLAY_TEST_KEY_COUNT; key++) {
+      bool is_held = replay_test_is_held(tick, key);
+      if (tick > 0 && is_held == replay_test_is_held(tick - 1, key)) {
+        continue;
+      }
+      key_event_type_t type = is_held ? KEY_PRESSED : KEY_RELEASED;
+      replay_add_key(replay, REPLAY_TEST_KEYS[key], type, 0);
+      replay_test_key(REPLAY_TEST_KEYS[key], type, 0, state);
+    }
+    match_step(state, RUNTIME_TICK_DT);
+    assert(replay_end_tick(replay, MAP2, match_hash(state)));
+  }
+  assert(replay_get_ticks(replay) == REPLAY_TEST_TICKS);
+  replay_free(replay);
+  match_free(state);
+}
+
+/** Plays REPLAY_TEST_PATH back, returning how many ticks diverged */
+size_t replay_test_play(uint64_t seed) {
+  replay_t *replay = replay_play(REPLAY_TEST_PATH);
+  assert(replay != NULL);
+  assert(!replay_is_recording(replay));
+  assert(replay_get_seed(replay) == REPLAY_TEST_SEED);
+  assert(replay_get_dt(replay) == RUNTIME_TICK_DT);
+  state_t *state = match_init(MAP2, seed);
+  size_t divergences = 0;
+  while (replay_play_tick(replay, replay_test_key, state)) {
+    match_step(state, replay_get_dt(replay));
+    if (!replay_check_tick(replay, MAP2, match_hash(state))) {
+      divergences++;
+    }
+  }
+  assert(replay_get_ticks(replay) == REPLAY_TEST_TICKS);
+  replay_free(replay);
+  match_free(state);
+  return divergences;
+}
+
+void test_playback_matches_recording(void) {
+  replay_test_record();
+  assert(replay_test_play(REPLAY_TEST_SEED) == 0);
+  remove(REPLAY_TEST_PATH);
+}
+
+void test_playback_detects_divergence(void) {
+  replay_test_record();
+  // Another seed draws different random numbers, so the match drifts apart
+  assert(replay_test_play(REPLAY_TEST_SEED + 1) > 0);
+  remove(REPLAY_TEST_PATH);
+}
+
+void test_play_rejects_missing_file(void) {
+  remove(REPLAY_TEST_PATH);
+  assert(replay_play(REPLAY_TEST_PATH) == NULL);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_playback_matches_recording)
+  DO_TEST(test_playback_detects_divergence)
+  DO_TEST(test_play_rejects_missing_file)
+
+  puts("replay_test PASS");
+}
@@ -0,0 +1,142 @@
+#include "match.h"
+#include "rollback.h"
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdlib.h>
+
+const uint64_t ROLLBACK_TEST_SEED = 5;
+const size_t ROLLBACK_TEST_TICKS = 600;
+const size_t ROLLBACK_TEST_DELAY = 2;
+const size_t ROLLBACK_TEST_MAX_ROLLBACK = 8;
+// Room past the last tick for inputs scheduled input delay ticks ahead
+const size_t ROLLBACK_TEST_SLACK = 16;
+
+/** The actions a player holds on a tick, the same on every run */
+uint8_t rollback_test_actions(size_t tick, size_t player) {
+  return (tick / 5 + player * 7) * 3 % 16;
+}
+
+/** Steps a match with every input known up front, as rollback must match */
+uint64_t rollback_test_reference(uint8_t *inputs[2]) {
+  state_t *state = match_init(MAP2, ROLLBACK_TEST_SEED);
+  uint8_t previous[2] = {0, 0};
+  for (size_t tick = 0; tick < ROLLBACK_TEST_TICKS; tick++) {
+    if (match_is_over(state)) {
+      continue;
+    }
+    for (size_t player = 0; player < 2; player++) {
+      match_actions(state, player, previous[player], inputs[player][tick]);
+      previous[player] = inputs[player][tick];
+    }
+    match_step(state, RUNTIME_TICK_DT);
+  }
+  uint64_t hash = match_hash(state);
+  match_free(state);
+  return hash;
+}
+
+/**
+ * Plays both sides of a match, delivering each side's inputs to the other
+ * latency frames after they are sent, then checks both against a match
+ * that knew every input up front. Returns the sides' rollbacks and stalls
+ * added up.
+ */
+rollback_stats_t rollback_test_play(size_t latency) {
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  rollback_t *sides[2];
+  uint8_t *inputs[2];
+  size_t *sent_at[2];
+  size_t next_input[2], delivered[2];
+  size_t capacity = ROLLBACK_TEST_TICKS + ROLLBACK_TEST_SLACK;
+  for (size_t side = 0; side < 2; side++) {
+    sides[side] =
+        rollback_init(MAP2, ROLLBACK_TEST_SEED, side, ROLLBACK_TEST_DELAY,
+                      ROLLBACK_TEST_MAX_ROLLBACK);
+    // Ticks before the input delay run without input on both sides
+    inputs[side] = calloc(capacity, sizeof(uint8_t));
+    sent_at[side] = calloc(capacity, sizeof(size_t));
+    assert(inputs[side] != NULL && sent_at[side] != NULL);
+    next_input[side] = ROLLBACK_TEST_DELAY;
+    delivered[side] = ROLLBACK_TEST_DELAY;
+  }
+
+  bool is_done = false;
+  for (size_t frame = 0; !is_done; frame++) {
+    // Neither side can stall for good while inputs keep arriving
+    assert(frame < 4 * ROLLBACK_TEST_TICKS);
+    is_done = true;
+    for (size_t side = 0; side < 2; side++) {
+      size_t other = 1 - side;
+      while (delivered[other] < next_input[other] &&
+             sent_at[other][delivered[other]] + latency <= frame) {
+        rollback_add_remote_input(sides[side], delivered[other],
+                                  inputs[other][delivered[other]]);
+        delivered[other]++;
+      }
+      if (rollback_get_tick(sides[side]) < ROLLBACK_TEST_TICKS) {
+        uint8_t actions = rollback_test_actions(frame, side);
+        size_t tick = rollback_add_local_input(sides[side], actions);
+        if (tick == next_input[side]) {
+          assert(tick < capacity);
+          inputs[side][tick] = actions;
+          sent_at[side][tick] = frame;
+          next_input[side]++;
+        }
+        rollback_advance(sides[side], RUNTIME_TICK_DT);
+      }
+      is_done &=
+          rollback_get_tick(sides[side]) >= ROLLBACK_TEST_TICKS &&
+          rollback_get_confirmed_tick(sides[side]) >= ROLLBACK_TEST_TICKS;
+    }
+  }
+
+  uint64_t expected = rollback_test_reference(inputs);
+  rollback_stats_t totals = {0};
+  for (size_t side = 0; side < 2; side++) {
+    rollback_sync(sides[side], RUNTIME_TICK_DT);
+    assert(match_hash(rollback_get_state(sides[side])) == expected);
+    rollback_stats_t stats = rollback_get_stats(sides[side]);
+    assert(stats.max_rollback_ticks <= ROLLBACK_TEST_MAX_ROLLBACK);
+    totals.rollbacks += stats.rollbacks;
+    totals.stalls += stats.stalls;
+    rollback_free(sides[side]);
+    free(inputs[side]);
+    free(sent_at[side]);
+  }
+  return totals;
+}
+
+void test_no_latency_needs_no_rollback(void) {
+  // Inputs arrive before the input delay runs out, so nothing is predicted
+  assert(rollback_test_play(0).rollbacks == 0);
+}
+
+void test_late_inputs_resimulate_to_the_same_match(void) {
+  rollback_stats_t stats = rollback_test_play(ROLLBACK_TEST_DELAY + 3);
+  assert(stats.rollbacks > 0);
+  assert(stats.stalls == 0);
+}
+
+void test_latency_past_max_rollback_stalls_instead(void) {
+  rollback_stats_t stats = rollback_test_play(ROLLBACK_TEST_MAX_ROLLBACK + 4);
+  assert(stats.rollbacks > 0);
+  assert(stats.stalls > 0);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_no_latency_needs_no_rollback)
+  DO_TEST(test_late_inputs_resimulate_to_the_same_match)
+  DO_TEST(test_latency_past_max_rollback_stalls_instead)
+
+  puts("rollback_test PASS");
+}
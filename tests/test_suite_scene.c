@@ -0,0 +1,91 @@
+#include "body.h"
+#include "forces.h"
+#include "list.h"
+#include "scene.h"
+#include "test_util.h"
+#include <assert.h>
+
+const double SCENE_TEST_DT = 1e-2;
+
+body_t *scene_test_body(scene_t *scene) {
+  body_t *body = body_init(rect_init(1, 1), 1, (rgb_color_t){0, 0, 0});
+  scene_add_body(scene, body);
+  return body;
+}
+
+void test_handle_resolves_until_removed(void) {
+  scene_t *scene = scene_init();
+  body_t *body = scene_test_body(scene);
+  body_handle_t handle = body_get_handle(body);
+  assert(scene_resolve(scene, handle) == body);
+  // Removal is deferred, so the body resolves for the rest of the tick
+  body_remove(body);
+  assert(scene_resolve(scene, handle) == body);
+  scene_tick(scene, SCENE_TEST_DT);
+  assert(scene_bodies(scene) == 0);
+  assert(scene_resolve(scene, handle) == NULL);
+  scene_free(scene);
+}
+
+void test_reused_slot_rejects_stale_handle(void) {
+  scene_t *scene = scene_init();
+  body_t *old_body = scene_test_body(scene);
+  body_handle_t old_handle = body_get_handle(old_body);
+  body_remove(old_body);
+  scene_tick(scene, SCENE_TEST_DT);
+
+  // The new body takes over the slot under a newer generation
+  body_t *new_body = scene_test_body(scene);
+  body_handle_t new_handle = body_get_handle(new_body);
+  assert(new_handle.index == old_handle.index);
+  assert(new_handle.generation != old_handle.generation);
+  assert(scene_resolve(scene, old_handle) == NULL);
+  assert(scene_resolve(scene, new_handle) == new_body);
+  scene_free(scene);
+}
+
+void test_invalid_handles_resolve_to_nothing(void) {
+  scene_t *scene = scene_init();
+  body_t *body = scene_test_body(scene);
+  assert(scene_resolve(scene, BODY_HANDLE_NONE) == NULL);
+  body_handle_t past_end = body_get_handle(body);
+  past_end.index += 100;
+  assert(scene_resolve(scene, past_end) == NULL);
+  scene_free(scene);
+}
+
+void test_removed_body_retires_its_binds(void) {
+  scene_t *scene = scene_init();
+  body_t *anchor = scene_test_body(scene);
+  body_t *body = scene_test_body(scene);
+  body_set_centroid(body, (vector_t){10, 0});
+  create_spring(scene, 1, anchor, body);
+  body_remove(anchor);
+  scene_tick(scene, SCENE_TEST_DT);
+
+  // With the spring gone, nothing pulls the body once its velocity settles
+  assert(scene_bodies(scene) == 1);
+  assert(scene_get_body(scene, 0) == body);
+  assert(scene_resolve(scene, body_get_handle(body)) == body);
+  vector_t velocity = body_get_velocity(body);
+  scene_tick(scene, SCENE_TEST_DT);
+  assert(vec_isclose(body_get_velocity(body), velocity));
+  scene_free(scene);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_handle_resolves_until_removed)
+  DO_TEST(test_reused_slot_rejects_stale_handle)
+  DO_TEST(test_invalid_handles_resolve_to_nothing)
+  DO_TEST(test_removed_body_retires_its_binds)
+
+  puts("scene_test PASS");
+}
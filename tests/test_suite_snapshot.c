@@ -0,0 +1,187 @@
+#include "match.h"
+#include "rng.h"
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include "snapshot.h"
+#include "test_util.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+const uint64_t SNAPSHOT_TEST_SEED = 42;
+const size_t SNAPSHOT_TEST_TICKS = 240;
+
+/** The actions a player holds on a tick, the same on every run */
+uint8_t snapshot_test_actions(size_t tick, size_t player) {
+  return (tick / 7 + player * 3) * 5 % 16;
+}
+
+/** Plays ticks from tick on, writing the hash after each */
+void snapshot_test_play(state_t *state, size_t tick, size_t ticks,
+                        uint64_t *hashes) {
+  for (size_t i = 0; i < ticks; i++, tick++) {
+    for (size_t player = 0; player < 2; player++) {
+      match_actions(state, player,
+                    tick > 0 ? snapshot_test_actions(tick - 1, player) : 0,
+                    snapshot_test_actions(tick, player));
+    }
+    match_step(state, RUNTIME_TICK_DT);
+    hashes[i] = match_hash(state);
+  }
+}
+
+state_t *snapshot_test_match(void) {
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  return match_init(MAP2, SNAPSHOT_TEST_SEED);
+}
+
+void test_restore_replays_the_same_ticks(void) {
+  state_t *state = snapshot_test_match();
+  uint64_t *before = malloc(SNAPSHOT_TEST_TICKS * sizeof(uint64_t));
+  uint64_t *after = malloc(SNAPSHOT_TEST_TICKS * sizeof(uint64_t));
+  assert(before != NULL && after != NULL);
+  snapshot_test_play(state, 0, SNAPSHOT_TEST_TICKS, before);
+
+  snapshot_t *snapshot = snapshot_init(1);
+  match_save(state, snapshot);
+  uint64_t saved_hash = match_hash(state);
+  snapshot_test_play(state, SNAPSHOT_TEST_TICKS, SNAPSHOT_TEST_TICKS,
+                     before);
+  assert(match_restore(state, snapshot));
+  assert(match_hash(state) == saved_hash);
+  snapshot_test_play(state, SNAPSHOT_TEST_TICKS, SNAPSHOT_TEST_TICKS, after);
+  assert(memcmp(before, after, SNAPSHOT_TEST_TICKS * sizeof(uint64_t)) == 0);
+
+  snapshot_free(snapshot);
+  match_free(state);
+  free(before);
+  free(after);
+}
+
+void test_restore_into_another_match(void) {
+  state_t *state = snapshot_test_match();
+  uint64_t *hashes = malloc(SNAPSHOT_TEST_TICKS * sizeof(uint64_t));
+  uint64_t *copy_hashes = malloc(SNAPSHOT_TEST_TICKS * sizeof(uint64_t));
+  assert(hashes != NULL && copy_hashes != NULL);
+  snapshot_test_play(state, 0, SNAPSHOT_TEST_TICKS, hashes);
+
+  snapshot_t *snapshot = snapshot_init(1);
+  match_save(state, snapshot);
+  // Only the bytes travel, as they would through a file
+  snapshot_t *copy = snapshot_init(1);
+  snapshot_set_data(copy, snapshot_get_data(snapshot),
+                    snapshot_size(snapshot));
+  state_t *other = match_init(MAP2, SNAPSHOT_TEST_SEED + 1);
+  assert(match_restore(other, copy));
+  assert(match_hash(other) == match_hash(state));
+
+  snapshot_test_play(state, SNAPSHOT_TEST_TICKS, SNAPSHOT_TEST_TICKS, hashes);
+  snapshot_test_play(other, SNAPSHOT_TEST_TICKS, SNAPSHOT_TEST_TICKS,
+                     copy_hashes);
+  assert(memcmp(hashes, copy_hashes, SNAPSHOT_TEST_TICKS * sizeof(uint64_t)) ==
+         0);
+
+  snapshot_free(snapshot);
+  snapshot_free(copy);
+  match_free(state);
+  match_free(other);
+  free(hashes);
+  free(copy_hashes);
+}
+
+void test_restore_rejects_truncated(void) {
+  state_t *state = snapshot_test_match();
+  snapshot_t *snapshot = snapshot_init(1);
+  match_save(state, snapshot);
+  const uint8_t *data = snapshot_get_data(snapshot);
+  size_t size = snapshot_size(snapshot);
+
+  uint64_t *hashes = malloc(SNAPSHOT_TEST_TICKS * sizeof(uint64_t));
+  assert(hashes != NULL);
+  snapshot_test_play(state, 0, SNAPSHOT_TEST_TICKS, hashes);
+  uint64_t hash = match_hash(state);
+
+  snapshot_t *truncated = snapshot_init(1);
+  size_t sizes[] = {0, 3, size / 2, size - 1};
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); i++) {
+    snapshot_set_data(truncated, data, sizes[i]);
+    assert(!match_restore(state, truncated));
+    assert(match_hash(state) == hash);
+  }
+
+  snapshot_free(truncated);
+  snapshot_free(snapshot);
+  match_free(state);
+  free(hashes);
+}
+
+void test_restore_rejects_other_formats(void) {
+  state_t *state = snapshot_test_match();
+  snapshot_t *snapshot = snapshot_init(1);
+  match_save(state, snapshot);
+  size_t size = snapshot_size(snapshot);
+  uint8_t *data = malloc(size);
+  assert(data != NULL);
+  memcpy(data, snapshot_get_data(snapshot), size);
+  uint64_t hash = match_hash(state);
+
+  // The magic comes first
+  data[0] ^= 0xff;
+  snapshot_set_data(snapshot, data, size);
+  assert(!match_restore(state, snapshot));
+  assert(match_hash(state) == hash);
+
+  free(data);
+  snapshot_free(snapshot);
+  match_free(state);
+}
+
+void test_restore_rejects_corrupt_counts(void) {
+  // Nothing has been shot yet, so the projectile count sits just before the
+  // high water mark and the scene's random states at the very end
+  state_t *state = snapshot_test_match();
+  snapshot_t *snapshot = snapshot_init(1);
+  match_save(state, snapshot);
+  size_t size = snapshot_size(snapshot);
+  size_t count_offset = size - RNG_STREAMS * sizeof(uint64_t) -
+                        sizeof(size_t) - sizeof(size_t);
+  uint8_t *data = malloc(size);
+  assert(data != NULL);
+  memcpy(data, snapshot_get_data(snapshot), size);
+  size_t count;
+  memcpy(&count, &data[count_offset], sizeof(count));
+  assert(count == 0);
+  uint64_t hash = match_hash(state);
+
+  // Too many to fit, and few enough to allocate but not to read
+  size_t counts[] = {SIZE_MAX, 1};
+  for (size_t i = 0; i < sizeof(counts) / sizeof(*counts); i++) {
+    memcpy(&data[count_offset], &counts[i], sizeof(counts[i]));
+    snapshot_set_data(snapshot, data, size);
+    assert(!match_restore(state, snapshot));
+    assert(match_hash(state) == hash);
+  }
+
+  free(data);
+  snapshot_free(snapshot);
+  match_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_restore_replays_the_same_ticks)
+  DO_TEST(test_restore_into_another_match)
+  DO_TEST(test_restore_rejects_truncated)
+  DO_TEST(test_restore_rejects_other_formats)
+  DO_TEST(test_restore_rejects_corrupt_counts)
+
+  puts("snapshot_test PASS");
+}
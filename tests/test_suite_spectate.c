@@ -0,0 +1,168 @@
+#include "match.h"
+#include "projectile.h"
+#include "runtime.h"
+#include "sdl_wrapper.h"
+#include "spectate.h"
+#include "test_util.h"
+#include <assert.h>
+#include <math.h>
+
+const uint64_t SPECTATE_TEST_SEED = 7;
+const size_t SPECTATE_TEST_TICKS = 900;
+const size_t SPECTATE_TEST_KEYFRAME_INTERVAL = 120;
+// Half a step of the encoder's 1/32 pixel and 1/65536 turn quantization
+const double SPECTATE_TEST_POSITION_ERROR = 0.5 / 32 + 1e-9;
+const double SPECTATE_TEST_ANGLE_ERROR = M_PI / 65536 + 1e-9;
+
+/** The actions a player holds on a tick, the same on every run */
+uint8_t spectate_test_actions(size_t tick, size_t player) {
+  return (tick / 11 + player * 5) * 3 % 16;
+}
+
+state_t *spectate_test_match(void) {
+  sdl_init((vector_t)VEC_ZERO, (vector_t)MAX2);
+  return match_init(MAP2, SPECTATE_TEST_SEED);
+}
+
+void spectate_test_step(state_t *state, size_t tick) {
+  for (size_t player = 0; player < 2; player++) {
+    match_actions(state, player,
+                  tick > 0 ? spectate_test_actions(tick - 1, player) : 0,
+                  spectate_test_actions(tick, player));
+  }
+  match_step(state, RUNTIME_TICK_DT);
+}
+
+bool spectate_test_angle_isclose(double a, double b) {
+  double difference = remainder(a - b, 2 * M_PI);
+  return fabs(difference) <= SPECTATE_TEST_ANGLE_ERROR;
+}
+
+/** Checks that the decoder shows the match as the encoder was given it */
+void spectate_test_compare(spectate_decoder_t *decoder, state_t *state,
+                           uint32_t tick) {
+  assert(spectate_is_ready(decoder));
+  assert(spectate_get_tick(decoder) == tick);
+  assert(spectate_get_lives(decoder, PLAYER1) ==
+         match_get_lives(state, PLAYER1));
+  assert(spectate_get_lives(decoder, PLAYER2) ==
+         match_get_lives(state, PLAYER2));
+
+  scene_t *scene = match_get_scene(state);
+  assert(spectate_bodies(decoder) == scene_bodies(scene));
+  for (size_t i = 0; i < scene_bodies(scene); i++) {
+    body_t *body = scene_get_body(scene, i);
+    assert(spectate_get_type(decoder, i) == get_info(body)->type);
+    assert(within(SPECTATE_TEST_POSITION_ERROR,
+                  spectate_get_centroid(decoder, i).x,
+                  body_get_centroid(body).x));
+    assert(within(SPECTATE_TEST_POSITION_ERROR,
+                  spectate_get_centroid(decoder, i).y,
+                  body_get_centroid(body).y));
+    assert(spectate_test_angle_isclose(spectate_get_angle(decoder, i),
+                                       body_get_angle(body)));
+  }
+
+  projectiles_t *projectiles = scene_get_projectiles(scene);
+  assert(spectate_projectiles(decoder) == projectiles_size(projectiles));
+  for (size_t i = 0; i < projectiles_size(projectiles); i++) {
+    vector_t position = projectiles_get_position(projectiles, i);
+    assert(within(SPECTATE_TEST_POSITION_ERROR,
+                  spectate_get_projectile(decoder, i).x, position.x));
+    assert(within(SPECTATE_TEST_POSITION_ERROR,
+                  spectate_get_projectile(decoder, i).y, position.y));
+  }
+}
+
+void test_stream_follows_match(void) {
+  state_t *state = spectate_test_match();
+  spectate_encoder_t *encoder =
+      spectate_encoder_init(SPECTATE_TEST_KEYFRAME_INTERVAL);
+  spectate_decoder_t *decoder = spectate_decoder_init();
+  // Bodies and projectiles speed up, turn and stop, so motion residuals of
+  // both signs and many code lengths go through the stream
+  size_t projectile_frames = 0;
+  for (size_t tick = 0; tick < SPECTATE_TEST_TICKS; tick++) {
+    spectate_test_step(state, tick);
+    size_t size;
+    const uint8_t *frame = spectate_encode(encoder, state, tick, &size);
+    assert(spectate_decode(decoder, frame, size));
+    spectate_test_compare(decoder, state, tick);
+    projectile_frames += spectate_projectiles(decoder) > 0;
+  }
+  assert(projectile_frames > 0);
+
+  spectate_stats_t stats = spectate_encoder_get_stats(encoder);
+  assert(stats.frames == SPECTATE_TEST_TICKS);
+  assert(stats.keyframes >= SPECTATE_TEST_TICKS /
+                                SPECTATE_TEST_KEYFRAME_INTERVAL);
+  assert(stats.keyframes < stats.frames);
+  // Frames between keyframes only carry what changed
+  size_t delta_bytes = stats.bytes - stats.keyframe_bytes;
+  size_t delta_frames = stats.frames - stats.keyframes;
+  assert(delta_bytes / delta_frames < stats.keyframe_bytes / stats.keyframes);
+
+  spectate_decoder_free(decoder);
+  spectate_encoder_free(encoder);
+  match_free(state);
+}
+
+void test_decoder_waits_for_keyframe(void) {
+  state_t *state = spectate_test_match();
+  spectate_encoder_t *encoder =
+      spectate_encoder_init(SPECTATE_TEST_KEYFRAME_INTERVAL);
+  spectate_decoder_t *decoder = spectate_decoder_init();
+  size_t size;
+  spectate_test_step(state, 0);
+  spectate_encode(encoder, state, 0, &size);
+
+  // Joining after the first keyframe shows nothing until the next one
+  spectate_test_step(state, 1);
+  const uint8_t *frame = spectate_encode(encoder, state, 1, &size);
+  assert(!spectate_decode(decoder, frame, size));
+  assert(!spectate_is_ready(decoder));
+  spectate_encoder_request_keyframe(encoder);
+  spectate_test_step(state, 2);
+  frame = spectate_encode(encoder, state, 2, &size);
+  assert(spectate_decode(decoder, frame, size));
+  spectate_test_compare(decoder, state, 2);
+
+  spectate_decoder_free(decoder);
+  spectate_encoder_free(encoder);
+  match_free(state);
+}
+
+void test_truncated_frame_rejected(void) {
+  state_t *state = spectate_test_match();
+  spectate_encoder_t *encoder =
+      spectate_encoder_init(SPECTATE_TEST_KEYFRAME_INTERVAL);
+  spectate_decoder_t *decoder = spectate_decoder_init();
+  size_t size;
+  spectate_test_step(state, 0);
+  const uint8_t *frame = spectate_encode(encoder, state, 0, &size);
+  assert(!spectate_decode(decoder, frame, size / 2));
+  assert(!spectate_is_ready(decoder));
+  // The whole frame still decodes afterwards
+  assert(spectate_decode(decoder, frame, size));
+  spectate_test_compare(decoder, state, 0);
+
+  spectate_decoder_free(decoder);
+  spectate_encoder_free(encoder);
+  match_free(state);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  DO_TEST(test_stream_follows_match)
+  DO_TEST(test_decoder_waits_for_keyframe)
+  DO_TEST(test_truncated_frame_rejected)
+
+  puts("spectate_test PASS");
+}
@@ -0,0 +1,85 @@
+#include "test_util.h"
+#include "texture_cache.h"
+#include <SDL2/SDL.h>
+#include <assert.h>
+#include <stdio.h>
+
+const char *TEXTURE_CACHE_TEST_IMAGE = "texture_cache_test.bmp";
+const char *TEXTURE_CACHE_TEST_MISSING = "texture_cache_test_missing.bmp";
+const int TEXTURE_CACHE_TEST_SIZE = 8;
+
+/** Writes a small image to load, since the tests ship without assets */
+void texture_cache_test_write_image(void) {
+  SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(
+      0, TEXTURE_CACHE_TEST_SIZE, TEXTURE_CACHE_TEST_SIZE, 32,
+      SDL_PIXELFORMAT_RGBA32);
+  assert(surface != NULL);
+  assert(SDL_SaveBMP(surface, TEXTURE_CACHE_TEST_IMAGE) == 0);
+  SDL_FreeSurface(surface);
+}
+
+void test_acquire_shares_one_load(void) {
+  texture_cache_t *cache = texture_cache_init();
+  const texture_region_t *first =
+      texture_cache_acquire(cache, TEXTURE_CACHE_TEST_IMAGE);
+  const texture_region_t *second =
+      texture_cache_acquire(cache, TEXTURE_CACHE_TEST_IMAGE);
+  assert(first != NULL);
+  assert(first == second);
+  assert(first->texture_id != 0);
+  assert(first->source.w == TEXTURE_CACHE_TEST_SIZE);
+  assert(texture_cache_loads(cache) == 1);
+  texture_cache_release(cache, first);
+  texture_cache_release(cache, second);
+  texture_cache_free(cache);
+}
+
+void test_released_image_kept_until_trim(void) {
+  texture_cache_t *cache = texture_cache_init();
+  const texture_region_t *region =
+      texture_cache_acquire(cache, TEXTURE_CACHE_TEST_IMAGE);
+  texture_cache_release(cache, region);
+  // A rebuilt scene borrows it again without reading the disk
+  region = texture_cache_acquire(cache, TEXTURE_CACHE_TEST_IMAGE);
+  assert(texture_cache_loads(cache) == 1);
+  // Borrowed images survive a trim
+  assert(texture_cache_trim(cache) == 0);
+  assert(texture_cache_generation(cache) == 0);
+  texture_cache_release(cache, region);
+  assert(texture_cache_trim(cache) == 1);
+  assert(texture_cache_generation(cache) == 1);
+  texture_cache_collect(cache, texture_cache_generation(cache));
+
+  region = texture_cache_acquire(cache, TEXTURE_CACHE_TEST_IMAGE);
+  assert(region != NULL);
+  assert(texture_cache_loads(cache) == 2);
+  texture_cache_release(cache, region);
+  texture_cache_free(cache);
+}
+
+void test_missing_image(void) {
+  texture_cache_t *cache = texture_cache_init();
+  assert(texture_cache_acquire(cache, TEXTURE_CACHE_TEST_MISSING) == NULL);
+  // Nothing was borrowed, and giving back NULL does nothing
+  texture_cache_release(cache, NULL);
+  assert(texture_cache_trim(cache) == 0);
+  texture_cache_free(cache);
+}
+
+int main(int argc, char *argv[]) {
+  // Run all tests if there are no command-line arguments
+  bool all_tests = argc == 1;
+  // Read test name from file
+  char testname[100];
+  if (!all_tests) {
+    read_testname(argv[1], testname, sizeof(testname));
+  }
+
+  texture_cache_test_write_image();
+  DO_TEST(test_acquire_shares_one_load)
+  DO_TEST(test_released_image_kept_until_trim)
+  DO_TEST(test_missing_image)
+  remove(TEXTURE_CACHE_TEST_IMAGE);
+
+  puts("texture_cache_test PASS");
+}